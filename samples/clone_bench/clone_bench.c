@@ -0,0 +1,150 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "yuki.h"
+
+#define CLONE_BENCH_DEFAULT_ROWS  10000
+#define CLONE_BENCH_DEFAULT_LOOPS 100
+#define CLONE_BENCH_FIELDS        6
+#define CLONE_BENCH_CELL_LENGTH   32
+
+typedef ybool_t (*clone_bench_clone_func_t)(yvar_t ** new_var, const yvar_t * old_var);
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/**
+ * clone result repeatedly with clone func and report throughput.
+ */
+static int bench(const char * name, clone_bench_clone_func_t clone, const yvar_t * result, int rows, int loops)
+{
+    yvar_t * cloned = NULL;
+    int i;
+
+    // warm up thread arena so that the first func doesn't pay for growing it.
+    if (!clone(&cloned, result)) {
+        fprintf(stderr, "cannot clone result\n");
+        return -1;
+    }
+
+    yuki_clean_up();
+    double start = now();
+
+    for (i = 0; i < loops; i++) {
+        if (!clone(&cloned, result)) {
+            fprintf(stderr, "cannot clone result\n");
+            return -1;
+        }
+
+        yuki_clean_up();
+    }
+
+    double elapsed = now() - start;
+    printf("%-28s %12.3f %14.0f\n", name, elapsed * 1000 / loops, rows * loops / elapsed);
+    return 0;
+}
+
+/**
+ * clone a select result set repeatedly and report throughput.
+ * rows are maps sharing one keys var. str cells have own memory as mysql rows do.
+ */
+static int run(const char * config, int rows, int loops)
+{
+    if (!yuki_init(config)) {
+        fprintf(stderr, "cannot init yuki with %s\n", config);
+        return -1;
+    }
+
+    yvar_t raw_keys[CLONE_BENCH_FIELDS];
+    yvar_t * raw_fields = (yvar_t *)malloc(sizeof(yvar_t) * rows * CLONE_BENCH_FIELDS);
+    yvar_t * raw_values = (yvar_t *)malloc(sizeof(yvar_t) * rows);
+    yvar_t * raw_rows = (yvar_t *)malloc(sizeof(yvar_t) * rows);
+    char * cells = (char *)malloc(rows * CLONE_BENCH_CELL_LENGTH * 2);
+    int i;
+
+    if (!raw_fields || !raw_values || !raw_rows || !cells) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+
+    yvar_cstr(raw_keys[0], "uid");
+    yvar_cstr(raw_keys[1], "diamond");
+    yvar_cstr(raw_keys[2], "cash");
+    yvar_cstr(raw_keys[3], "nick");
+    yvar_cstr(raw_keys[4], "email");
+    yvar_cstr(raw_keys[5], "created_at");
+
+    yvar_t keys = YVAR_EMPTY();
+    yvar_array(keys, raw_keys);
+
+    for (i = 0; i < rows; i++) {
+        yvar_t * fields = raw_fields + i * CLONE_BENCH_FIELDS;
+        char * email = cells + i * CLONE_BENCH_CELL_LENGTH * 2;
+        char * created_at = email + CLONE_BENCH_CELL_LENGTH;
+        snprintf(email, CLONE_BENCH_CELL_LENGTH, "user_%08d@example.com", i);
+        snprintf(created_at, CLONE_BENCH_CELL_LENGTH, "2010-08-13 01:%02d:%02d", i / 60 % 60, i % 60);
+
+        yvar_int64(fields[0], 1234567890 + i);
+        yvar_int32(fields[1], i);
+        yvar_uint32(fields[2], rows - i);
+        yvar_cstr(fields[3], "yuki");
+        yvar_cstr_with_size(fields[4], email, strlen(email));
+        yvar_cstr_with_size(fields[5], created_at, strlen(created_at));
+        yvar_array_with_size(raw_values[i], fields, CLONE_BENCH_FIELDS);
+        yvar_map(raw_rows[i], keys, raw_values[i]);
+    }
+
+    yvar_t result = YVAR_EMPTY();
+    yvar_array_with_size(result, raw_rows, rows);
+
+    // both clones run in the same thread arena. _yvar_clone_sized() walks result to size memory first.
+    int ret = bench("one pass", _yvar_clone, &result, rows, loops);
+
+    if (!ret) {
+        ret = bench("two pass", _yvar_clone_sized, &result, rows, loops);
+    }
+
+    free(raw_fields);
+    free(raw_values);
+    free(raw_rows);
+    free(cells);
+    yuki_shutdown();
+    return ret;
+}
+
+/**
+ * compare one pass clone and two pass clone in thread arena.
+ * usage: clone_bench [rows] [loops]
+ */
+int main(int argc, char * argv[])
+{
+    int rows = CLONE_BENCH_DEFAULT_ROWS;
+    int loops = CLONE_BENCH_DEFAULT_LOOPS;
+
+    if (argc > 1) {
+        rows = atoi(argv[1]);
+    }
+
+    if (argc > 2) {
+        loops = atoi(argv[2]);
+    }
+
+    if (rows <= 0 || loops <= 0) {
+        fprintf(stderr, "usage: %s [rows] [loops]\n", argv[0]);
+        return -1;
+    }
+
+    printf("%-28s %12s %14s\n", "clone", "ms/clone", "rows/s");
+
+    if (run("./sample.config", rows, loops)) {
+        return -1;
+    }
+
+    return 0;
+}
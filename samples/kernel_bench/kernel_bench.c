@@ -0,0 +1,152 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "yuki.h"
+
+#define KERNEL_BENCH_DEFAULT_ITEMS 1000000
+#define KERNEL_BENCH_DEFAULT_LOOPS 100
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static void report(const char * name, double elapsed, int items, int loops, yint64_t check)
+{
+    printf("%-28s %12.3f %14.0f %20lld\n", name, elapsed * 1000 / loops, (double)items * loops / elapsed, (long long)check);
+}
+
+/**
+ * sum and filter int64 ids with per-var getter and with array kernels.
+ * usage: kernel_bench [items] [loops]
+ */
+int main(int argc, char * argv[])
+{
+    int items = KERNEL_BENCH_DEFAULT_ITEMS;
+    int loops = KERNEL_BENCH_DEFAULT_LOOPS;
+    int i, j;
+
+    if (argc > 1) {
+        items = atoi(argv[1]);
+    }
+
+    if (argc > 2) {
+        loops = atoi(argv[2]);
+    }
+
+    if (items <= 0 || loops <= 0) {
+        fprintf(stderr, "usage: %s [items] [loops]\n", argv[0]);
+        return -1;
+    }
+
+    if (!yuki_init("./sample.config")) {
+        fprintf(stderr, "cannot init yuki\n");
+        return -1;
+    }
+
+    yint64_t * raw_ids = (yint64_t *)malloc(sizeof(yint64_t) * items);
+    yvar_t * raw_vars = (yvar_t *)malloc(sizeof(yvar_t) * items);
+
+    if (!raw_ids || !raw_vars) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+
+    for (i = 0; i < items; i++) {
+        raw_ids[i] = 1234567890LL + (i * 7919LL) % items;
+        yvar_int64(raw_vars[i], raw_ids[i]);
+    }
+
+    yvar_t vars = YVAR_EMPTY();
+    yvar_t packed = YVAR_EMPTY();
+    yvar_array_with_size(vars, raw_vars, items);
+    yvar_packed_array_with_size(packed, YVAR_TYPE_INT64, raw_ids, items);
+
+    yvar_t pivot = YVAR_EMPTY();
+    yvar_int64(pivot, 1234567890LL + items / 2);
+
+    yvar_t sum = YVAR_EMPTY();
+    yvar_t filtered = YVAR_EMPTY();
+    yint64_t check = 0;
+    double start;
+
+    printf("kernel: %s\n", yvar_kernel_name());
+    printf("%-28s %12s %14s %20s\n", "case", "ms/loop", "items/s", "check");
+
+    start = now();
+
+    for (i = 0; i < loops; i++) {
+        check = 0;
+
+        FOREACH_YVAR_ARRAY(vars, value) {
+            yint64_t id;
+            yvar_get_int64(*value, id);
+            check += id;
+        }
+    }
+
+    report("sum by yvar_get_int64", now() - start, items, loops, check);
+
+    start = now();
+
+    for (i = 0; i < loops; i++) {
+        yvar_array_sum(vars, sum);
+    }
+
+    report("yvar_array_sum array", now() - start, items, loops, yvar_to_int64(sum));
+
+    start = now();
+
+    for (i = 0; i < loops; i++) {
+        yvar_array_sum(packed, sum);
+    }
+
+    report("yvar_array_sum packed", now() - start, items, loops, yvar_to_int64(sum));
+
+    start = now();
+
+    for (i = 0; i < loops; i++) {
+        yvar_t * result = (yvar_t *)ybuffer_simple_alloc(sizeof(yvar_t) * items);
+        yint64_t id;
+        check = 0;
+
+        for (j = 0; j < items; j++) {
+            if (yvar_get_int64(raw_vars[j], id) && id < pivot.data.yint64_data) {
+                result[check++] = raw_vars[j];
+            }
+        }
+
+        yuki_clean_up();
+    }
+
+    report("filter by yvar_get_int64", now() - start, items, loops, check);
+
+    start = now();
+
+    for (i = 0; i < loops; i++) {
+        yvar_array_filter_cmp(vars, YVAR_CMP_LT, pivot, filtered);
+        check = yvar_count(filtered);
+        yuki_clean_up();
+    }
+
+    report("yvar_array_filter_cmp array", now() - start, items, loops, check);
+
+    start = now();
+
+    for (i = 0; i < loops; i++) {
+        yvar_array_filter_cmp(packed, YVAR_CMP_LT, pivot, filtered);
+        check = yvar_count(filtered);
+        yuki_clean_up();
+    }
+
+    report("yvar_array_filter_cmp packed", now() - start, items, loops, check);
+
+    free(raw_ids);
+    free(raw_vars);
+    yuki_shutdown();
+    return 0;
+}
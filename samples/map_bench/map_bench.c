@@ -0,0 +1,120 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "yuki.h"
+
+#define MAP_BENCH_DEFAULT_LOOPS 1000000
+#define MAP_BENCH_KEY_LENGTH    32
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/**
+ * look up every key of map in turn and return ns per yvar_map_get().
+ */
+static double bench_map_get(const yvar_t * map, const yvar_t * keys, int size, int loops)
+{
+    yvar_t value = YVAR_EMPTY();
+    int found = 0;
+    int i;
+
+    double start = now();
+
+    for (i = 0; i < loops; i++) {
+        found += yvar_map_get(*map, keys[i % size], value);
+    }
+
+    double elapsed = now() - start;
+
+    if (found != loops) {
+        fprintf(stderr, "some keys are not found\n");
+    }
+
+    return elapsed * 1000000000.0 / loops;
+}
+
+/**
+ * compare map_get on plain maps and cloned maps.
+ * plain map is always scanned linearly. cloned map with 8 or more keys has a hash index.
+ * usage: map_bench [loops]
+ */
+int main(int argc, char * argv[])
+{
+    int sizes[] = {2, 4, 8, 16, 40, 100, 1000};
+    int loops = MAP_BENCH_DEFAULT_LOOPS;
+    int s, i;
+
+    if (argc > 1) {
+        loops = atoi(argv[1]);
+    }
+
+    if (loops <= 0) {
+        fprintf(stderr, "usage: %s [loops]\n", argv[0]);
+        return -1;
+    }
+
+    if (!yuki_init("./sample.config")) {
+        fprintf(stderr, "cannot init yuki\n");
+        return -1;
+    }
+
+    atexit(&yuki_shutdown);
+
+    printf("%8s %14s %14s\n", "keys", "plain ns/get", "cloned ns/get");
+
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int size = sizes[s];
+        // lookup keys have own copy of strings as real world callers do
+        char * key_strs = (char *)malloc(size * MAP_BENCH_KEY_LENGTH * 2);
+        yvar_t * keys = (yvar_t *)malloc(size * sizeof(yvar_t));
+        yvar_t * lookup_keys = (yvar_t *)malloc(size * sizeof(yvar_t));
+        yvar_t * values = (yvar_t *)malloc(size * sizeof(yvar_t));
+
+        if (!key_strs || !keys || !lookup_keys || !values) {
+            fprintf(stderr, "out of memory\n");
+            return -1;
+        }
+
+        for (i = 0; i < size; i++) {
+            char * key_str = key_strs + i * MAP_BENCH_KEY_LENGTH * 2;
+            char * lookup_key_str = key_str + MAP_BENCH_KEY_LENGTH;
+            snprintf(key_str, MAP_BENCH_KEY_LENGTH, "column_%d", i);
+            strcpy(lookup_key_str, key_str);
+            yvar_cstr_with_size(keys[i], key_str, strlen(key_str));
+            yvar_cstr_with_size(lookup_keys[i], lookup_key_str, strlen(lookup_key_str));
+            yvar_int32(values[i], i);
+        }
+
+        yvar_t keys_var = YVAR_EMPTY();
+        yvar_t values_var = YVAR_EMPTY();
+        yvar_t plain_map = YVAR_EMPTY();
+        yvar_array_with_size(keys_var, keys, size);
+        yvar_array_with_size(values_var, values, size);
+        yvar_map(plain_map, keys_var, values_var);
+
+        yvar_t * cloned_map = NULL;
+
+        if (!yvar_clone(cloned_map, plain_map)) {
+            fprintf(stderr, "cannot clone map\n");
+            return -1;
+        }
+
+        double linear = bench_map_get(&plain_map, lookup_keys, size, loops);
+        double hashed = bench_map_get(cloned_map, lookup_keys, size, loops);
+        printf("%8d %14.1f %14.1f\n", size, linear, hashed);
+
+        yuki_clean_up();
+        free(key_strs);
+        free(keys);
+        free(lookup_keys);
+        free(values);
+    }
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "yuki.h"
+
+#define MMAP_BENCH_DEFAULT_ROWS  100000
+#define MMAP_BENCH_DEFAULT_LOOPS 20
+#define MMAP_BENCH_FIELDS        5
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static long minor_faults()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+
+/**
+ * clone a select-like result set repeatedly and report time and page faults.
+ */
+static int run(const char * config, int rows, int loops)
+{
+    if (!yuki_init(config)) {
+        fprintf(stderr, "cannot init yuki with %s\n", config);
+        return -1;
+    }
+
+    yvar_t * raw_fields = (yvar_t *)malloc(sizeof(yvar_t) * rows * MMAP_BENCH_FIELDS);
+    yvar_t * raw_rows = (yvar_t *)malloc(sizeof(yvar_t) * rows);
+    int i;
+
+    if (!raw_fields || !raw_rows) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+
+    for (i = 0; i < rows; i++) {
+        yvar_t * fields = raw_fields + i * MMAP_BENCH_FIELDS;
+        yvar_cstr(fields[0], "1234567890");
+        yvar_int64(fields[1], i);
+        yvar_int64(fields[2], rows - i);
+        yvar_cstr(fields[3], "abc\n \" ' asd cs\r quo't cas\" \\");
+        yvar_cstr(fields[4], "2010-08-13 01:23:45");
+        yvar_array_with_size(raw_rows[i], fields, MMAP_BENCH_FIELDS);
+    }
+
+    yvar_t result = YVAR_EMPTY();
+    yvar_array_with_size(result, raw_rows, rows);
+
+    yvar_t * cloned = NULL;
+    long faults = minor_faults();
+    double start = now();
+
+    for (i = 0; i < loops; i++) {
+        if (!yvar_clone(cloned, result)) {
+            fprintf(stderr, "cannot clone result\n");
+            break;
+        }
+
+        yuki_clean_up();
+    }
+
+    double elapsed = now() - start;
+    faults = minor_faults() - faults;
+    printf("%-22s %12.3f %14.0f\n", config, elapsed * 1000 / loops, (double)faults / loops);
+
+    free(raw_fields);
+    free(raw_rows);
+    yuki_shutdown();
+    return 0;
+}
+
+/**
+ * compare malloc-backed and mmap-backed chunks when cloning large results.
+ * usage: mmap_bench [rows] [loops]
+ */
+int main(int argc, char * argv[])
+{
+    int rows = MMAP_BENCH_DEFAULT_ROWS;
+    int loops = MMAP_BENCH_DEFAULT_LOOPS;
+
+    if (argc > 1) {
+        rows = atoi(argv[1]);
+    }
+
+    if (argc > 2) {
+        loops = atoi(argv[2]);
+    }
+
+    if (rows <= 0 || loops <= 0) {
+        fprintf(stderr, "usage: %s [rows] [loops]\n", argv[0]);
+        return -1;
+    }
+
+    printf("%-22s %12s %14s\n", "config", "ms/clone", "faults/clone");
+
+    if (run("./sample.config", rows, loops) || run("./sample_mmap.config", rows, loops)) {
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#include "yuki.h"
+
+#define PIN_BENCH_MAX_THREADS 32
+#define PIN_BENCH_DEFAULT_LOOPS 200000
+
+static yvar_t * g_template = NULL;
+static int g_loops = PIN_BENCH_DEFAULT_LOOPS;
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static void * pin_worker(void * arg)
+{
+    yvar_t * pinned = NULL;
+    int i;
+
+    for (i = 0; i < g_loops; i++) {
+        if (!yvar_pin(pinned, *g_template)) {
+            fprintf(stderr, "cannot pin template\n");
+            break;
+        }
+
+        yvar_unpin(pinned);
+
+        // unpinned buffers move to thread chain. release them regularly.
+        if (i % 1000 == 999) {
+            yuki_clean_up();
+        }
+    }
+
+    yuki_clean_up();
+    return NULL;
+}
+
+/**
+ * measure pin/unpin throughput of a small query template with different thread count.
+ * usage: pin_bench [loops per thread] [max threads]
+ */
+int main(int argc, char * argv[])
+{
+    int max_threads = 8;
+
+    if (argc > 1) {
+        g_loops = atoi(argv[1]);
+    }
+
+    if (argc > 2) {
+        max_threads = atoi(argv[2]);
+    }
+
+    if (max_threads <= 0 || max_threads > PIN_BENCH_MAX_THREADS || g_loops <= 0) {
+        fprintf(stderr, "usage: %s [loops per thread] [max threads <= %d]\n", argv[0], PIN_BENCH_MAX_THREADS);
+        return -1;
+    }
+
+    if (!yuki_init("./sample.config")) {
+        fprintf(stderr, "cannot init yuki\n");
+        return -1;
+    }
+
+    atexit(&yuki_shutdown);
+
+    yvar_map_kv_t raw_template = {
+        {YVAR_CSTR("uid"),        YVAR_CSTR("huandu")},
+        {YVAR_CSTR("int_value"),  YVAR_INT32(12345)},
+        {YVAR_CSTR("char_value"), YVAR_CSTR("hey~")},
+        {YVAR_CSTR("text_value"), YVAR_CSTR("world")},
+    };
+
+    if (!yvar_map_smart_clone(g_template, raw_template)) {
+        fprintf(stderr, "cannot clone template\n");
+        return -1;
+    }
+
+    pthread_t threads[PIN_BENCH_MAX_THREADS];
+    int thread_count;
+    int i;
+
+    printf("%8s %12s %14s\n", "threads", "seconds", "pin+unpin/s");
+
+    for (thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+        double start = now();
+
+        for (i = 0; i < thread_count; i++) {
+            pthread_create(&threads[i], NULL, &pin_worker, NULL);
+        }
+
+        for (i = 0; i < thread_count; i++) {
+            pthread_join(threads[i], NULL);
+        }
+
+        double elapsed = now() - start;
+        printf("%8d %12.3f %14.0f\n", thread_count, elapsed, (double)g_loops * thread_count / elapsed);
+    }
+
+    return 0;
+}
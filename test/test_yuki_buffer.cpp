@@ -0,0 +1,419 @@
+#include <gtest/gtest.h>
+
+#include "yuki.h"
+#define YUKI_CFG_FILE "./test/yuki.config"
+#define YUKI_EPOCH_CFG_FILE "./test/yuki_epoch.config"
+
+TEST(YukiBufferTest, ArenaAlloc) {
+    ASSERT_TRUE(yuki_init(YUKI_CFG_FILE));
+
+    // small allocations are bump allocated and never overlap
+    char * prev = NULL;
+
+    for (int i = 0; i < 10000; i++) {
+        char * p = (char *)ybuffer_simple_alloc(13);
+        ASSERT_TRUE(p);
+        ASSERT_EQ((ysize_t)p % 8, 0u);
+        memset(p, i & 0xFF, 13);
+
+        if (prev) {
+            ASSERT_EQ(prev[12], (char)((i - 1) & 0xFF));
+        }
+
+        prev = p;
+    }
+
+    // large allocation gets a dedicated chunk
+    char * large = (char *)ybuffer_simple_alloc(4 * 1024 * 1024);
+    ASSERT_TRUE(large);
+    memset(large, 0, 4 * 1024 * 1024);
+
+    // buffer created from arena is exactly sized
+    ybuffer_t * buffer = ybuffer_create(100);
+    ASSERT_TRUE(buffer);
+    ASSERT_EQ(ybuffer_available_size(buffer), ybuffer_round_up(100));
+    ASSERT_TRUE(ybuffer_alloc(buffer, 100));
+    ASSERT_EQ(ybuffer_available_size(buffer), 0u);
+    ASSERT_FALSE(ybuffer_alloc(buffer, 1));
+
+    yuki_clean_up();
+
+    ASSERT_TRUE(ybuffer_simple_alloc(13));
+
+    yuki_shutdown();
+}
+
+TEST(YukiBufferTest, MarkAndRewind) {
+    ASSERT_TRUE(yuki_init(YUKI_CFG_FILE));
+
+    ybuffer_mark_t outer;
+    ybuffer_mark_t inner;
+    ASSERT_TRUE(ybuffer_mark(&outer));
+
+    void * first = ybuffer_simple_alloc(16);
+    ASSERT_TRUE(first);
+    ASSERT_TRUE(ybuffer_mark(&inner));
+
+    void * second = ybuffer_simple_alloc(16);
+    void * large = ybuffer_simple_alloc(2 * 1024 * 1024);
+    ASSERT_TRUE(second);
+    ASSERT_TRUE(large);
+
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_TRUE(ybuffer_simple_alloc(100));
+    }
+
+    // memory after inner mark is released and reused
+    ASSERT_TRUE(ybuffer_rewind(&inner));
+    ASSERT_EQ(ybuffer_simple_alloc(16), second);
+    ASSERT_EQ(ybuffer_simple_alloc(2 * 1024 * 1024), large);
+
+    ASSERT_TRUE(ybuffer_rewind(&outer));
+    ASSERT_EQ(ybuffer_simple_alloc(16), first);
+
+    // inner mark is out of date after rewinding to outer mark
+    ASSERT_TRUE(ybuffer_rewind(&outer));
+    ASSERT_TRUE(ybuffer_simple_alloc(32 * 1024));
+    ASSERT_FALSE(ybuffer_rewind(&inner));
+
+    yuki_clean_up();
+    yuki_shutdown();
+}
+
+TEST(YukiBufferTest, CleanUpReusesChunks) {
+    ASSERT_TRUE(yuki_init(YUKI_CFG_FILE));
+
+    void * small = ybuffer_simple_alloc(16);
+    void * large = ybuffer_simple_alloc(64 * 1024);
+    ASSERT_TRUE(small);
+    ASSERT_TRUE(large);
+
+    // cached chunks are handed out again after clean up
+    yuki_clean_up();
+    void * large_again = ybuffer_simple_alloc(64 * 1024);
+    void * small_again = ybuffer_simple_alloc(16);
+    ASSERT_EQ(large_again, large);
+    ASSERT_EQ(small_again, small);
+
+    yuki_clean_up();
+    yuki_shutdown();
+}
+
+static void * create_global_buffers(void * arg)
+{
+    ybuffer_t ** buffers = (ybuffer_t **)arg;
+
+    for (int i = 0; i < 100; i++) {
+        buffers[i] = ybuffer_create_global(32);
+    }
+
+    yuki_clean_up();
+    return NULL;
+}
+
+TEST(YukiBufferTest, GlobalBufferAcrossThreads) {
+    ASSERT_TRUE(yuki_init(YUKI_CFG_FILE));
+
+    const int thread_count = 8;
+    pthread_t threads[thread_count];
+    ybuffer_t * buffers[thread_count][100];
+
+    for (int i = 0; i < thread_count; i++) {
+        ASSERT_EQ(pthread_create(&threads[i], NULL, &create_global_buffers, buffers[i]), 0);
+    }
+
+    for (int i = 0; i < thread_count; i++) {
+        ASSERT_EQ(pthread_join(threads[i], NULL), 0);
+    }
+
+    // buffers created in other threads are destroyed in current thread
+    for (int i = 0; i < thread_count; i++) {
+        for (int j = 0; j < 100; j += 2) {
+            ASSERT_TRUE(buffers[i][j]);
+            ASSERT_TRUE(ybuffer_destroy_global(buffers[i][j]));
+        }
+    }
+
+    yuki_clean_up();
+
+    // the rest are reclaimed by shutdown
+    yuki_shutdown();
+}
+
+TEST(YukiBufferTest, Stats) {
+    ASSERT_TRUE(yuki_init(YUKI_CFG_FILE));
+    yuki_clean_up();
+    ASSERT_TRUE(ybuffer_stats_reset());
+
+    ybuffer_stats_t thread_stats;
+    ybuffer_stats_t process_stats;
+    ASSERT_TRUE(ybuffer_stats(&thread_stats, &process_stats));
+    ASSERT_EQ(thread_stats.requested_bytes, 0u);
+    ASSERT_EQ(thread_stats.reserved_bytes, 0u);
+    ASSERT_EQ(thread_stats.chunk_count, 0u);
+
+    for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(ybuffer_simple_alloc(100));
+    }
+
+    ybuffer_t * global = ybuffer_create_global(1000);
+    ASSERT_TRUE(global);
+
+    ASSERT_TRUE(ybuffer_stats(&thread_stats, &process_stats));
+    ASSERT_EQ(thread_stats.requested_bytes, 100u * ybuffer_round_up(100));
+    ASSERT_GE(thread_stats.reserved_bytes, thread_stats.requested_bytes);
+    ASSERT_GT(thread_stats.chunk_count, 0u);
+    ASSERT_GE(process_stats.requested_bytes, thread_stats.requested_bytes);
+    ASSERT_GE(process_stats.reserved_bytes, thread_stats.reserved_bytes);
+    ASSERT_GE(process_stats.global_pinned_bytes, 1000u);
+    ASSERT_GE(process_stats.peak_global_pinned_bytes, process_stats.global_pinned_bytes);
+
+    ysize_t pinned = process_stats.global_pinned_bytes;
+    ysize_t reserved = thread_stats.reserved_bytes;
+    ASSERT_TRUE(ybuffer_destroy_global(global));
+
+    // destroyed global buffer moves to thread chain
+    ASSERT_TRUE(ybuffer_stats(&thread_stats, &process_stats));
+    ASSERT_EQ(process_stats.global_pinned_bytes, pinned - global->size);
+    ASSERT_EQ(thread_stats.reserved_bytes, reserved + global->size);
+
+    // clean up keeps peak and moves chunks to cache
+    yuki_clean_up();
+    ASSERT_TRUE(ybuffer_stats(&thread_stats, NULL));
+    ASSERT_EQ(thread_stats.reserved_bytes, 0u);
+    ASSERT_EQ(thread_stats.chunk_count, 0u);
+    ASSERT_GT(thread_stats.cached_bytes, 0u);
+    ASSERT_GE(thread_stats.peak_reserved_bytes, reserved + global->size);
+
+    ASSERT_TRUE(ybuffer_stats_reset());
+    ASSERT_TRUE(ybuffer_stats(&thread_stats, NULL));
+    ASSERT_EQ(thread_stats.requested_bytes, 0u);
+    ASSERT_EQ(thread_stats.peak_reserved_bytes, 0u);
+
+    yuki_shutdown();
+}
+
+TEST(YukiBufferTest, SlabAllocAndFree) {
+    ASSERT_TRUE(yuki_init(YUKI_CFG_FILE));
+
+    void * objects[1000];
+
+    for (int i = 0; i < 1000; i++) {
+        objects[i] = ybuffer_slab_smart_alloc(yvar_t);
+        ASSERT_TRUE(objects[i]);
+        ASSERT_EQ((ysize_t)objects[i] % 8, 0u);
+        memset(objects[i], i & 0xFF, sizeof(yvar_t));
+    }
+
+    for (int i = 1; i < 1000; i++) {
+        ASSERT_NE(objects[i - 1], objects[i]);
+        ASSERT_EQ(((char *)objects[i - 1])[sizeof(yvar_t) - 1], (char)((i - 1) & 0xFF));
+    }
+
+    // freed objects are reused before new ones are carved
+    ybuffer_slab_smart_free(objects[10], yvar_t);
+    ybuffer_slab_smart_free(objects[20], yvar_t);
+    ASSERT_EQ(ybuffer_slab_smart_alloc(yvar_t), objects[20]);
+    ASSERT_EQ(ybuffer_slab_smart_alloc(yvar_t), objects[10]);
+
+    // other size classes don't share free list
+    ybuffer_slab_free(objects[30], 8);
+    ASSERT_NE(ybuffer_slab_smart_alloc(yvar_t), objects[30]);
+    ASSERT_EQ(ybuffer_slab_alloc(8), objects[30]);
+
+    // large object falls back to arena
+    ASSERT_TRUE(ybuffer_slab_alloc(4096));
+
+    yuki_clean_up();
+    yuki_shutdown();
+}
+
+TEST(YukiBufferTest, AlignedAlloc) {
+    ASSERT_TRUE(yuki_init(YUKI_CFG_FILE));
+
+    ysize_t aligns[] = {1, 8, 16, 32, 64, 4096};
+
+    for (size_t i = 0; i < sizeof(aligns) / sizeof(aligns[0]); i++) {
+        ysize_t align = aligns[i];
+
+        // unaligned allocation in between moves arena cursor
+        ASSERT_TRUE(ybuffer_simple_alloc(8));
+
+        ybuffer_t * buffer = ybuffer_create_aligned(100, align);
+        ASSERT_TRUE(buffer);
+        ASSERT_EQ(ybuffer_available_size(buffer), ybuffer_round_up(100));
+
+        char * p = (char *)ybuffer_alloc_aligned(buffer, 100, align);
+        ASSERT_TRUE(p);
+        ASSERT_EQ((ysize_t)p % align, 0u);
+        memset(p, 0, 100);
+        ASSERT_EQ(ybuffer_available_size(buffer), 0u);
+    }
+
+    // padding is consumed from buffer
+    ybuffer_t * buffer = ybuffer_create(256);
+    ASSERT_TRUE(buffer);
+    ASSERT_TRUE(ybuffer_alloc(buffer, 8));
+
+    char * p = (char *)ybuffer_alloc_aligned(buffer, 32, 64);
+    ASSERT_TRUE(p);
+    ASSERT_EQ((ysize_t)p % 64, 0u);
+    ASSERT_FALSE(ybuffer_alloc_aligned(buffer, 256, 64));
+
+    // align must be power of two
+    ASSERT_FALSE(ybuffer_alloc_aligned(buffer, 8, 24));
+    ASSERT_FALSE(ybuffer_create_aligned(8, 0));
+
+    yuki_clean_up();
+    yuki_shutdown();
+}
+
+typedef struct _detached_result_t {
+    yvar_t * var;
+    ybuffer_t * chain;
+} detached_result_t;
+
+static void * build_detached_var(void * arg)
+{
+    detached_result_t * result = (detached_result_t *)arg;
+    char * before = (char *)ybuffer_simple_alloc(16);
+    strcpy(before, "before mark");
+
+    ybuffer_mark_t mark;
+    ybuffer_detach_begin(&mark);
+
+    yvar_t values[1000];
+
+    for (int i = 0; i < 1000; i++) {
+        yvar_int32(values[i], i);
+    }
+
+    yvar_t array = YVAR_EMPTY();
+    yvar_array(array, values);
+    yvar_clone(result->var, array);
+
+    ybuffer_detach(&mark, &result->chain);
+
+    // memory allocated before mark is still owned by current thread
+    if (strcmp(before, "before mark") || !ybuffer_simple_alloc(16)) {
+        result->var = NULL;
+    }
+
+    // detached chunks survive clean up of current thread
+    yuki_clean_up();
+    return NULL;
+}
+
+TEST(YukiBufferTest, DetachAndAdopt) {
+    ASSERT_TRUE(yuki_init(YUKI_CFG_FILE));
+
+    ybuffer_stats_t before;
+    ybuffer_stats_t after;
+    ASSERT_TRUE(ybuffer_stats(&before, NULL));
+
+    detached_result_t result = {NULL, NULL};
+    pthread_t thread;
+    ASSERT_EQ(pthread_create(&thread, NULL, &build_detached_var, &result), 0);
+    ASSERT_EQ(pthread_join(thread, NULL), 0);
+
+    ASSERT_TRUE(result.var);
+    ASSERT_TRUE(result.chain);
+    ASSERT_TRUE(ybuffer_adopt(result.chain));
+    ASSERT_TRUE(ybuffer_stats(&after, NULL));
+    ASSERT_GT(after.chunk_count, before.chunk_count);
+
+    ASSERT_EQ(yvar_count(*result.var), 1000u);
+
+    yvar_t value = YVAR_EMPTY();
+    yint32_t int32_value;
+
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_TRUE(yvar_array_get(*result.var, i, value));
+        ASSERT_TRUE(yvar_get_int32(value, int32_value));
+        ASSERT_EQ(int32_value, i);
+    }
+
+    // detach needs a matching begin
+    ybuffer_mark_t mark;
+    ybuffer_t * chain;
+    ASSERT_TRUE(ybuffer_mark(&mark));
+    ASSERT_FALSE(ybuffer_detach(&mark, &chain));
+    ASSERT_TRUE(ybuffer_detach_begin(&mark));
+    ASSERT_FALSE(ybuffer_detach_begin(&mark));
+    ASSERT_TRUE(ybuffer_detach(&mark, &chain));
+    ASSERT_FALSE(chain);
+
+    // chunks grown inside detach window do not make later chunks larger
+    yuki_clean_up();
+    ASSERT_TRUE(ybuffer_stats(&before, NULL));
+    ASSERT_TRUE(ybuffer_simple_alloc(100));
+    ASSERT_TRUE(ybuffer_stats(&after, NULL));
+    ysize_t first_chunk_size = after.reserved_bytes - before.reserved_bytes;
+
+    yuki_clean_up();
+    ASSERT_TRUE(ybuffer_detach_begin(&mark));
+
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(ybuffer_simple_alloc(6000));
+    }
+
+    ASSERT_TRUE(ybuffer_detach(&mark, &chain));
+    ASSERT_TRUE(chain);
+    ASSERT_TRUE(ybuffer_adopt(chain));
+    ASSERT_TRUE(ybuffer_stats(&before, NULL));
+    ASSERT_TRUE(ybuffer_simple_alloc(100));
+    ASSERT_TRUE(ybuffer_stats(&after, NULL));
+    ASSERT_EQ(after.reserved_bytes - before.reserved_bytes, first_chunk_size);
+
+    // adopted chunks are released by clean up of current thread
+    yuki_clean_up();
+    ASSERT_TRUE(ybuffer_stats(&after, NULL));
+    ASSERT_EQ(after.chunk_count, 0u);
+
+    yuki_shutdown();
+}
+
+TEST(YukiBufferTest, EpochReclaim) {
+    // epoch config keeps 1 epoch and reclaims once thread reserves more than 1MB
+    ASSERT_TRUE(yuki_init(YUKI_EPOCH_CFG_FILE));
+    yuki_clean_up();
+
+    ybuffer_stats_t stats;
+    ASSERT_TRUE(ybuffer_simple_alloc(100));
+    ASSERT_TRUE(ybuffer_stats(&stats, NULL));
+    ASSERT_EQ(stats.chunk_count, 1u);
+
+    // new epoch opens a new chunk. expired epochs are kept below threshold.
+    ASSERT_TRUE(ybuffer_epoch_advance());
+    ASSERT_TRUE(ybuffer_simple_alloc(100));
+    ASSERT_TRUE(ybuffer_stats(&stats, NULL));
+    ASSERT_EQ(stats.chunk_count, 2u);
+
+    ASSERT_TRUE(ybuffer_epoch_advance());
+    ASSERT_TRUE(ybuffer_epoch_advance());
+    ASSERT_TRUE(ybuffer_stats(&stats, NULL));
+    ASSERT_EQ(stats.chunk_count, 2u);
+
+    // above threshold, chunks older than previous epoch are released
+    ASSERT_TRUE(ybuffer_simple_alloc(2 * 1024 * 1024));
+    ASSERT_TRUE(ybuffer_epoch_advance());
+    ASSERT_TRUE(ybuffer_stats(&stats, NULL));
+    ASSERT_EQ(stats.chunk_count, 1u);
+
+    ASSERT_TRUE(ybuffer_epoch_advance());
+    ASSERT_TRUE(ybuffer_stats(&stats, NULL));
+    ASSERT_EQ(stats.chunk_count, 0u);
+
+    // safe point releases memory above threshold only
+    ASSERT_TRUE(ybuffer_simple_alloc(100));
+    ASSERT_TRUE(ybuffer_safe_point());
+    ASSERT_TRUE(ybuffer_stats(&stats, NULL));
+    ASSERT_EQ(stats.chunk_count, 1u);
+
+    ASSERT_TRUE(ybuffer_simple_alloc(2 * 1024 * 1024));
+    ASSERT_TRUE(ybuffer_safe_point());
+    ASSERT_TRUE(ybuffer_stats(&stats, NULL));
+    ASSERT_EQ(stats.chunk_count, 0u);
+
+    yuki_shutdown();
+}
@@ -172,6 +172,51 @@ TEST_F(YukiTableTest, SelectOne) {
     ASSERT_TRUE(yvar_equal(created_at_var, expected_created_at));
 }
 
+TEST_F(YukiTableTest, SelectOneMove) {
+    yvar_t field_wildcard = YVAR_EMPTY();
+    yvar_t cond_key1 = YVAR_EMPTY();
+    yvar_t cond_value1 = YVAR_EMPTY();
+    yvar_t op = YVAR_EMPTY();
+    yvar_cstr(field_wildcard, "*");
+    yvar_cstr(cond_key1, "uid");
+    yvar_cstr(cond_value1, "1234567890");
+    yvar_cstr(op, "=");
+
+    yvar_t raw_fields[] = {
+        field_wildcard
+    };
+
+    yvar_t fields = YVAR_EMPTY();
+    yvar_array(fields, raw_fields);
+
+    yvar_triple_array_t raw_cond = {
+        {cond_key1, op, cond_value1},
+    };
+
+    yvar_t * stack_fields = &fields;
+    yvar_t * cloned_fields;
+    yvar_t * cond;
+    ASSERT_TRUE(yvar_clone(cloned_fields, fields));
+    ASSERT_TRUE(yvar_triple_array_smart_clone(cond, raw_cond));
+
+    ytable_t * ytable = ytable_instance("mytest");
+    ASSERT_TRUE(ytable);
+
+    // stack var cannot be moved.
+    ASSERT_EQ(ytable_select_move(ytable, stack_fields), ytable);
+    ASSERT_EQ(ytable_last_error(ytable), YTABLE_ERROR_INVALID_PARAM);
+
+    yvar_t * result;
+    ASSERT_EQ(ytable_select_move(ytable, cloned_fields), ytable);
+    ASSERT_EQ(ytable_last_error(ytable), YTABLE_ERROR_SUCCESS);
+    ASSERT_FALSE(cloned_fields);
+    ASSERT_EQ(ytable_where_move(ytable, cond), ytable);
+    ASSERT_EQ(ytable_last_error(ytable), YTABLE_ERROR_SUCCESS);
+    ASSERT_FALSE(cond);
+    ASSERT_TRUE(ytable_fetch_one(ytable, result));
+    ASSERT_EQ(yvar_count(*result), 1u);
+}
+
 TEST_F(YukiTableTest, UpdateOne) {
     yvar_t field1 = YVAR_EMPTY();
     yvar_t field2 = YVAR_EMPTY();
@@ -1,3 +1,4 @@
+#include <sys/mman.h>
 #include <gtest/gtest.h>
 #include "yuki.h"
 
@@ -42,6 +43,92 @@ TEST(YukiVarTest, UseVar) {
     yuki_shutdown();
 }
 
+TEST(YukiVarTest, IntStrConversion) {
+    yuki_init(YUKI_CFG_FILE);
+
+    #define _GENERATE_INT_TO_STR_CASE(t, v, exp) do { \
+        yvar_t my_var = YVAR_EMPTY(); \
+        yvar_##t(my_var, (v)); \
+        char buffer[32]; \
+    \
+        ASSERT_TRUE(yvar_get_str(my_var, buffer, sizeof(buffer))); \
+        ASSERT_STREQ((exp), buffer); \
+    } while (0)
+
+    _GENERATE_INT_TO_STR_CASE(bool, ytrue, "true");
+    _GENERATE_INT_TO_STR_CASE(int8, 0, "0");
+    _GENERATE_INT_TO_STR_CASE(int8, -128, "-128");
+    _GENERATE_INT_TO_STR_CASE(uint8, 200, "200");
+    _GENERATE_INT_TO_STR_CASE(int16, -23456, "-23456");
+    _GENERATE_INT_TO_STR_CASE(uint32, 0x93123452UL, "2467443794");
+    _GENERATE_INT_TO_STR_CASE(int64, YUKI_MIN_INT64_VALUE, "-9223372036854775808");
+    _GENERATE_INT_TO_STR_CASE(uint64, 18446744073709551615ULL, "18446744073709551615");
+
+    #undef _GENERATE_INT_TO_STR_CASE
+
+    {
+        // buffer must hold '\0'.
+        yvar_t my_var = YVAR_EMPTY();
+        yvar_int32(my_var, 1234);
+        char buffer[4];
+        ASSERT_FALSE(yvar_get_str(my_var, buffer, sizeof(buffer)));
+    }
+
+    #define _GENERATE_PARSE_CASE(t, str, ok, exp) do { \
+        yvar_t my_var = YVAR_EMPTY(); \
+        yvar_cstr(my_var, (str)); \
+        y##t##_t value = 0; \
+    \
+        ASSERT_EQ((ybool_t)(ok), yvar_parse_##t(my_var, value)) << "wrong result when parsing " str; \
+    \
+        if (ok) { \
+            ASSERT_EQ((y##t##_t)(exp), value) << "wrong value when parsing " str; \
+        } \
+    } while (0)
+
+    _GENERATE_PARSE_CASE(int8, "-128", ytrue, -128);
+    _GENERATE_PARSE_CASE(int8, "128", yfalse, 0);
+    _GENERATE_PARSE_CASE(uint8, "+255", ytrue, 255);
+    _GENERATE_PARSE_CASE(uint8, "-1", yfalse, 0);
+    _GENERATE_PARSE_CASE(uint16, "-0", ytrue, 0);
+    _GENERATE_PARSE_CASE(int32, "78901234", ytrue, 78901234);
+    _GENERATE_PARSE_CASE(int32, "12a", yfalse, 0);
+    _GENERATE_PARSE_CASE(int32, "", yfalse, 0);
+    _GENERATE_PARSE_CASE(int32, "-", yfalse, 0);
+    _GENERATE_PARSE_CASE(int32, " 1", yfalse, 0);
+    _GENERATE_PARSE_CASE(int64, "-9223372036854775808", ytrue, YUKI_MIN_INT64_VALUE);
+    _GENERATE_PARSE_CASE(int64, "9223372036854775808", yfalse, 0);
+    _GENERATE_PARSE_CASE(int64, "-9223372036854775809", yfalse, 0);
+    _GENERATE_PARSE_CASE(uint64, "18446744073709551615", ytrue, 18446744073709551615ULL);
+    _GENERATE_PARSE_CASE(uint64, "18446744073709551616", yfalse, 0);
+    _GENERATE_PARSE_CASE(uint64, "000000000000000000000000042", ytrue, 42);
+
+    #undef _GENERATE_PARSE_CASE
+
+    {
+        // getters never parse str. parsers accept non-str vars as getters do.
+        yvar_t my_var = YVAR_EMPTY();
+        yint64_t value;
+        yvar_cstr(my_var, "42");
+        ASSERT_FALSE(yvar_get_int64(my_var, value));
+
+        yvar_uint16(my_var, 4242);
+        ASSERT_TRUE(yvar_parse_int64(my_var, value));
+        ASSERT_EQ(value, 4242);
+
+        // converted str can be parsed back.
+        char buffer[32];
+        yvar_int64(my_var, -1234567890123LL);
+        ASSERT_TRUE(yvar_get_str(my_var, buffer, sizeof(buffer)));
+        yvar_cstr_with_size(my_var, buffer, strlen(buffer));
+        ASSERT_TRUE(yvar_parse_int64(my_var, value));
+        ASSERT_EQ(value, -1234567890123LL);
+    }
+
+    yuki_clean_up();
+    yuki_shutdown();
+}
+
 TEST(YukiVarTest, ForeachVarArray) {
     yuki_init(YUKI_CFG_FILE);
 
@@ -106,6 +193,122 @@ TEST(YukiVarTest, ForeachVarArray) {
     yuki_shutdown();
 }
 
+TEST(YukiVarTest, ListPushAndPop) {
+    yuki_init(YUKI_CFG_FILE);
+
+    yvar_t list = YVAR_EMPTY();
+    yvar_list(list);
+
+    for (yint32_t i = 0; i < 100; i++) {
+        yvar_t value = YVAR_EMPTY();
+        yvar_int32(value, i);
+        ASSERT_TRUE(yvar_list_push_back(list, value));
+    }
+
+    ASSERT_EQ(yvar_count(list), 100u);
+
+    yvar_t output = YVAR_EMPTY();
+    yint32_t int32_value;
+    ASSERT_TRUE(yvar_list_pop_front(list, output));
+    ASSERT_TRUE(yvar_get_int32(output, int32_value));
+    ASSERT_EQ(int32_value, 0);
+    ASSERT_TRUE(yvar_list_pop_back(list, output));
+    ASSERT_TRUE(yvar_get_int32(output, int32_value));
+    ASSERT_EQ(int32_value, 99);
+    ASSERT_EQ(yvar_count(list), 98u);
+
+    // popped nodes are reused by push
+    for (yint32_t i = 0; i < 1000; i++) {
+        yvar_t value = YVAR_EMPTY();
+        yvar_int32(value, i);
+        ASSERT_TRUE(yvar_list_push_back(list, value));
+        ASSERT_TRUE(yvar_list_pop_front(list, output));
+    }
+
+    ASSERT_EQ(yvar_count(list), 98u);
+
+    while (yvar_list_pop_back(list, output)) {}
+
+    ASSERT_EQ(yvar_count(list), 0u);
+    ASSERT_FALSE(yvar_list_pop_front(list, output));
+
+    yuki_clean_up();
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, ListAsQueue) {
+    yuki_init(YUKI_CFG_FILE);
+
+    yvar_t list = YVAR_EMPTY();
+    yvar_t other = YVAR_EMPTY();
+    yvar_t output = YVAR_EMPTY();
+    yint32_t int32_value;
+    yvar_list(list);
+    yvar_list(other);
+
+    for (yint32_t i = 0; i < 5000; i++) {
+        yvar_t value = YVAR_EMPTY();
+        yvar_int32(value, i);
+        ASSERT_TRUE(yvar_list_push_back(list, value));
+        ASSERT_TRUE(yvar_list_push_back(other, value));
+        ASSERT_EQ(yvar_count(list), (ysize_t)i + 1);
+    }
+
+    ASSERT_TRUE(yvar_equal(list, other));
+
+    yint32_t expected = 0;
+
+    FOREACH_YVAR_LIST(list, value) {
+        ASSERT_TRUE(yvar_get_int32(*value, int32_value));
+        ASSERT_EQ(int32_value, expected);
+        expected++;
+    }
+
+    ASSERT_EQ(expected, 5000);
+
+    // foreach on a non list var does nothing. its data is not a list node.
+    yvar_t not_list = YVAR_EMPTY();
+    yvar_int64(not_list, 0x12345678);
+
+    FOREACH_YVAR_LIST(not_list, not_list_value) {
+        FAIL() << "non list var is iterated";
+    }
+
+    // last element is different.
+    ASSERT_TRUE(yvar_list_pop_back(other, output));
+    yvar_int32(output, -1);
+    ASSERT_TRUE(yvar_list_push_back(other, output));
+    ASSERT_FALSE(yvar_equal(list, other));
+    ASSERT_GT(yvar_compare(list, other), 0);
+
+    yvar_t * cloned = NULL;
+    ASSERT_TRUE(yvar_clone(cloned, list));
+    ASSERT_EQ(yvar_count(*cloned), 5000u);
+    ASSERT_TRUE(yvar_equal(*cloned, list));
+
+    // consume as a work queue across node boundaries.
+    for (yint32_t i = 0; i < 4990; i++) {
+        ASSERT_TRUE(yvar_list_pop_front(list, output));
+        ASSERT_TRUE(yvar_get_int32(output, int32_value));
+        ASSERT_EQ(int32_value, i);
+    }
+
+    ASSERT_EQ(yvar_count(list), 10u);
+
+    for (yint32_t i = 4999; i >= 4990; i--) {
+        ASSERT_TRUE(yvar_list_pop_back(list, output));
+        ASSERT_TRUE(yvar_get_int32(output, int32_value));
+        ASSERT_EQ(int32_value, i);
+        ASSERT_EQ(yvar_count(list), (ysize_t)(i - 4990));
+    }
+
+    ASSERT_FALSE(yvar_list_pop_front(list, output));
+    ASSERT_FALSE(yvar_list_pop_back(list, output));
+
+    yuki_clean_up();
+    yuki_shutdown();
+}
+
 TEST(YukiVarTest, VarClone) {
     yvar_t * before_init_var = NULL;
     yvar_t before_init_int8_var = YVAR_EMPTY();
@@ -420,6 +623,782 @@ TEST(YukiVarTest, VarPinAndUnpin) {
     yuki_shutdown();
 }
 
+TEST(YukiVarTest, VarFreezeAndShare) {
+    yuki_init(YUKI_CFG_FILE);
+
+    yvar_t raw_ids[100];
+
+    for (int i = 0; i < 100; i++) {
+        yvar_int32(raw_ids[i], i);
+    }
+
+    yvar_t ids = YVAR_EMPTY();
+    yvar_array(ids, raw_ids);
+
+    ybuffer_stats_t stats;
+    ASSERT_TRUE(ybuffer_stats(NULL, &stats));
+    ysize_t pinned_bytes = stats.global_pinned_bytes;
+
+    yvar_t * frozen = NULL;
+    ASSERT_TRUE(yvar_freeze(frozen, ids));
+    ASSERT_TRUE(yvar_has_option(*frozen, YVAR_OPTION_FROZEN));
+    ASSERT_TRUE(yvar_has_option(*frozen, YVAR_OPTION_PINNED));
+    ASSERT_TRUE(yvar_equal(*frozen, ids));
+    ASSERT_TRUE(ybuffer_stats(NULL, &stats));
+    ASSERT_GT(stats.global_pinned_bytes, pinned_bytes);
+
+    // clone, pin and freeze of a frozen var share it.
+    yvar_t * cloned = NULL;
+    yvar_t * pinned = NULL;
+    yvar_t * refrozen = NULL;
+    ASSERT_TRUE(yvar_clone(cloned, *frozen));
+    ASSERT_TRUE(yvar_pin(pinned, *frozen));
+    ASSERT_TRUE(yvar_freeze(refrozen, *frozen));
+    ASSERT_EQ(cloned, frozen);
+    ASSERT_EQ(pinned, frozen);
+    ASSERT_EQ(refrozen, frozen);
+
+    // a plain copy is not frozen. its clone is a real copy.
+    yvar_t copy = YVAR_EMPTY();
+    yvar_t * copy_cloned = NULL;
+    ASSERT_TRUE(yvar_assign(copy, *frozen));
+    ASSERT_FALSE(yvar_has_option(copy, YVAR_OPTION_FROZEN));
+    ASSERT_TRUE(yvar_clone(copy_cloned, copy));
+    ASSERT_NE(copy_cloned, frozen);
+    ASSERT_TRUE(yvar_equal(*copy_cloned, ids));
+
+    // write triggers copy. frozen var is never modified.
+    yvar_t value = YVAR_EMPTY();
+    yvar_cstr(value, "new value");
+    ASSERT_FALSE(yvar_assign(*cloned, value));
+    ASSERT_TRUE(yvar_cow_assign(cloned, value));
+    ASSERT_NE(cloned, frozen);
+    ASSERT_TRUE(yvar_equal(*cloned, value));
+    ASSERT_TRUE(yvar_equal(*frozen, ids));
+
+    yvar_t * thawed = frozen;
+    ASSERT_TRUE(yvar_thaw(thawed));
+    ASSERT_NE(thawed, frozen);
+    ASSERT_FALSE(yvar_has_option(*thawed, YVAR_OPTION_FROZEN | YVAR_OPTION_PINNED));
+    ASSERT_TRUE(yvar_equal(*thawed, ids));
+    ASSERT_TRUE(yvar_array_sort(*thawed));
+
+    // clone still holds a reference after every explicit one is dropped.
+    ASSERT_TRUE(yvar_unpin(pinned));
+    ASSERT_TRUE(yvar_unpin(refrozen));
+    ASSERT_TRUE(yvar_unpin(frozen));
+    ASSERT_TRUE(yvar_equal(*frozen, ids));
+    ASSERT_TRUE(ybuffer_stats(NULL, &stats));
+    ASSERT_GT(stats.global_pinned_bytes, pinned_bytes);
+
+    yuki_clean_up();
+    ASSERT_TRUE(ybuffer_stats(NULL, &stats));
+    ASSERT_EQ(stats.global_pinned_bytes, pinned_bytes);
+
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, VarFreezeInConditions) {
+    yuki_init(YUKI_CFG_FILE);
+
+    yvar_t raw_ids[100];
+
+    for (int i = 0; i < 100; i++) {
+        yvar_int32(raw_ids[i], i);
+    }
+
+    yvar_t ids = YVAR_EMPTY();
+    yvar_array(ids, raw_ids);
+
+    ybuffer_stats_t stats;
+    ASSERT_TRUE(ybuffer_stats(NULL, &stats));
+    ysize_t pinned_bytes = stats.global_pinned_bytes;
+
+    yvar_t * frozen = NULL;
+    ASSERT_TRUE(yvar_freeze(frozen, ids));
+
+    // where conditions: {"uid": frozen ids, "status": 1}
+    yvar_t raw_keys[2];
+    yvar_t raw_values[2];
+    yvar_cstr(raw_keys[0], "uid");
+    yvar_cstr(raw_keys[1], "status");
+    raw_values[0] = *frozen;
+    yvar_int32(raw_values[1], 1);
+
+    yvar_t keys = YVAR_EMPTY();
+    yvar_t values = YVAR_EMPTY();
+    yvar_t conditions = YVAR_EMPTY();
+    yvar_array(keys, raw_keys);
+    yvar_array(values, raw_values);
+    yvar_map(conditions, keys, values);
+
+    yvar_t key = YVAR_EMPTY();
+    yvar_t value = YVAR_EMPTY();
+    yvar_cstr(key, "uid");
+
+    // clone shares frozen element.
+    yvar_t * cloned = NULL;
+    ASSERT_TRUE(yvar_clone(cloned, conditions));
+    ASSERT_TRUE(yvar_map_get(*cloned, key, value));
+    ASSERT_EQ(value.data.yarray_data.yvars, frozen->data.yarray_data.yvars);
+    ASSERT_TRUE(yvar_equal(value, ids));
+
+    // clone, pin and freeze of a copy of frozen var share the frozen var itself.
+    yvar_t * copy_cloned = NULL;
+    yvar_t * copy_pinned = NULL;
+    yvar_t * copy_refrozen = NULL;
+    ASSERT_TRUE(yvar_clone(copy_cloned, raw_values[0]));
+    ASSERT_TRUE(yvar_pin(copy_pinned, raw_values[0]));
+    ASSERT_TRUE(yvar_freeze(copy_refrozen, raw_values[0]));
+    ASSERT_EQ(copy_cloned, frozen);
+    ASSERT_EQ(copy_pinned, frozen);
+    ASSERT_EQ(copy_refrozen, frozen);
+
+    // a copy doesn't own a reference.
+    ASSERT_FALSE(yvar_unpin(&raw_values[0]));
+    ASSERT_TRUE(yvar_unpin(copy_pinned));
+    ASSERT_TRUE(yvar_unpin(copy_refrozen));
+
+    // frozen var without memory cannot be found thru a copy. copy is cloned, pinned or frozen by value.
+    yvar_t status = YVAR_EMPTY();
+    yvar_t * frozen_status = NULL;
+    yvar_int32(status, 1);
+    ASSERT_TRUE(yvar_freeze(frozen_status, status));
+
+    yvar_t status_copy = *frozen_status;
+    yvar_t * status_cloned = NULL;
+    yvar_t * status_pinned = NULL;
+    yvar_t * status_refrozen = NULL;
+    ASSERT_TRUE(yvar_clone(status_cloned, status_copy));
+    ASSERT_TRUE(yvar_pin(status_pinned, status_copy));
+    ASSERT_TRUE(yvar_freeze(status_refrozen, status_copy));
+    ASSERT_NE(status_cloned, &status_copy);
+    ASSERT_NE(status_pinned, &status_copy);
+    ASSERT_NE(status_refrozen, &status_copy);
+    ASSERT_FALSE(yvar_has_option(*status_cloned, YVAR_OPTION_FROZEN | YVAR_OPTION_PINNED));
+    ASSERT_TRUE(yvar_has_option(*status_refrozen, YVAR_OPTION_FROZEN));
+    ASSERT_TRUE(yvar_equal(*status_cloned, status));
+    ASSERT_TRUE(yvar_equal(*status_pinned, status));
+    ASSERT_TRUE(yvar_equal(*status_refrozen, status));
+    ASSERT_TRUE(yvar_unpin(status_pinned));
+    ASSERT_TRUE(yvar_unpin(status_refrozen));
+    ASSERT_TRUE(yvar_unpin(frozen_status));
+
+    // pin copies frozen element.
+    // value got by yvar_map_get() is pinned as frozen var is. get into new vars.
+    yvar_t * pinned = NULL;
+    yvar_t pinned_value = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_pin(pinned, conditions));
+    ASSERT_TRUE(yvar_map_get(*pinned, key, pinned_value));
+    ASSERT_NE(pinned_value.data.yarray_data.yvars, frozen->data.yarray_data.yvars);
+    ASSERT_TRUE(yvar_equal(pinned_value, ids));
+    ASSERT_TRUE(yvar_unpin(pinned));
+
+    // clone keeps frozen var alive until clean up.
+    yvar_t shared_value = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_unpin(frozen));
+    ASSERT_TRUE(yvar_map_get(*cloned, key, shared_value));
+    ASSERT_TRUE(yvar_equal(shared_value, ids));
+    ASSERT_TRUE(ybuffer_stats(NULL, &stats));
+    ASSERT_GT(stats.global_pinned_bytes, pinned_bytes);
+
+    yuki_clean_up();
+    ASSERT_TRUE(ybuffer_stats(NULL, &stats));
+    ASSERT_EQ(stats.global_pinned_bytes, pinned_bytes);
+
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, VarMove) {
+    yuki_init(YUKI_CFG_FILE);
+
+    yvar_t raw_ids[10];
+
+    for (int i = 0; i < 10; i++) {
+        yvar_int32(raw_ids[i], i);
+    }
+
+    yvar_t ids = YVAR_EMPTY();
+    yvar_array(ids, raw_ids);
+
+    // stack var owns nothing. it cannot be moved.
+    yvar_t * stack_var = &ids;
+    yvar_t * moved = NULL;
+    ASSERT_FALSE(yvar_move(moved, stack_var));
+    ASSERT_EQ(stack_var, &ids);
+    ASSERT_FALSE(moved);
+
+    yvar_t * cloned = NULL;
+    ASSERT_TRUE(yvar_clone(cloned, ids));
+    yvar_t * origin = cloned;
+    ASSERT_TRUE(yvar_move(moved, cloned));
+    ASSERT_FALSE(cloned);
+    ASSERT_EQ(moved, origin);
+    ASSERT_TRUE(yvar_equal(*moved, ids));
+    ASSERT_FALSE(yvar_move(moved, cloned));
+
+    yvar_t * pinned = NULL;
+    yvar_t * pinned_moved = NULL;
+    ASSERT_TRUE(yvar_pin(pinned, ids));
+    ASSERT_TRUE(yvar_move(pinned_moved, pinned));
+    ASSERT_FALSE(pinned);
+    ASSERT_TRUE(yvar_unpin(pinned_moved));
+
+    yuki_clean_up();
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, PackedArray) {
+    yuki_init(YUKI_CFG_FILE);
+
+    yint64_t raw_ids[1000];
+    yvar_t raw_vars[1000];
+
+    for (int i = 0; i < 1000; i++) {
+        raw_ids[i] = (yint64_t)i * 1000000007LL;
+        yvar_int64(raw_vars[i], raw_ids[i]);
+    }
+
+    yvar_t ids = YVAR_EMPTY();
+    yvar_packed_array(ids, YVAR_TYPE_INT64, raw_ids);
+    ASSERT_TRUE(yvar_is_packed_array(ids));
+    ASSERT_EQ(yvar_count(ids), 1000u);
+    ASSERT_EQ(yvar_array_size(ids), 1000u);
+
+    yvar_t item = YVAR_EMPTY();
+    yint64_t value;
+    ASSERT_TRUE(yvar_array_get(ids, 999, item));
+    ASSERT_TRUE(yvar_is_int64(item));
+    ASSERT_TRUE(yvar_get_int64(item, value));
+    ASSERT_EQ(value, raw_ids[999]);
+    ASSERT_TRUE(yvar_array_get(ids, 1000, item));
+    ASSERT_TRUE(yvar_is_undefined(item));
+
+    int cnt = 0;
+    FOREACH_YVAR_PACKED_ARRAY(ids, id) {
+        ASSERT_TRUE(yvar_get_int64(*id, value));
+        ASSERT_EQ(value, raw_ids[cnt]);
+        cnt++;
+    }
+    ASSERT_EQ(cnt, 1000);
+
+    yvar_t * cloned = NULL;
+    ASSERT_TRUE(yvar_clone(cloned, ids));
+    ASSERT_TRUE(yvar_is_packed_array(*cloned));
+    ASSERT_NE(yvar_packed_array_buffer(*cloned), yvar_packed_array_buffer(ids));
+    ASSERT_TRUE(yvar_equal(*cloned, ids));
+    ASSERT_EQ(yvar_compare(*cloned, ids), 0);
+
+    yvar_t * pinned = NULL;
+    ASSERT_TRUE(yvar_pin(pinned, ids));
+    ASSERT_TRUE(yvar_equal(*pinned, ids));
+    ASSERT_TRUE(yvar_unpin(pinned));
+
+    // generic array of int64 vars converts to and from packed array.
+    yvar_t vars = YVAR_EMPTY();
+    yvar_array(vars, raw_vars);
+    yvar_t * packed = NULL;
+    yvar_t * unpacked = NULL;
+    ASSERT_TRUE(yvar_array_pack(packed, vars, YVAR_TYPE_INT64));
+    ASSERT_TRUE(yvar_equal(*packed, ids));
+    ASSERT_TRUE(yvar_array_unpack(unpacked, *packed));
+    ASSERT_TRUE(yvar_is_array(*unpacked));
+    ASSERT_TRUE(yvar_equal(*unpacked, vars));
+
+    // values must fit in item type.
+    ASSERT_FALSE(yvar_array_pack(packed, vars, YVAR_TYPE_INT8));
+    ASSERT_FALSE(yvar_array_pack(packed, vars, YVAR_TYPE_CSTR));
+
+    // items must be int-like. otherwise var is undefined.
+    yvar_t bad_type = YVAR_EMPTY();
+    yvar_t * bad_type_cloned = NULL;
+    yvar_packed_array(bad_type, YVAR_TYPE_CSTR, raw_ids);
+    ASSERT_TRUE(yvar_is_undefined(bad_type));
+    ASSERT_TRUE(yvar_clone(bad_type_cloned, bad_type));
+    ASSERT_TRUE(yvar_is_undefined(*bad_type_cloned));
+
+    // items of different types are never equal.
+    yvar_t same_items = YVAR_EMPTY();
+    yvar_t empty_int32 = YVAR_EMPTY();
+    yvar_t empty_int64 = YVAR_EMPTY();
+    yvar_packed_array_with_size(same_items, YVAR_TYPE_UINT64, raw_ids, 1000);
+    yvar_packed_array_with_size(empty_int32, YVAR_TYPE_INT32, NULL, 0);
+    yvar_packed_array_with_size(empty_int64, YVAR_TYPE_INT64, NULL, 0);
+    ASSERT_FALSE(yvar_equal(same_items, ids));
+    ASSERT_FALSE(yvar_equal(empty_int32, empty_int64));
+
+    yint16_t raw_small[] = {1, 2, 3};
+    yint16_t raw_large[] = {1, 3};
+    yvar_t small = YVAR_EMPTY();
+    yvar_t large = YVAR_EMPTY();
+    yvar_packed_array(small, YVAR_TYPE_INT16, raw_small);
+    yvar_packed_array(large, YVAR_TYPE_INT16, raw_large);
+    ASSERT_FALSE(yvar_equal(small, large));
+    ASSERT_LT(yvar_compare(small, large), 0);
+    ASSERT_GT(yvar_compare(large, small), 0);
+
+    yuki_clean_up();
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, ArrayKernel) {
+    yuki_init(YUKI_CFG_FILE);
+
+    const int size = 1003;
+    yint32_t raw_int32[size];
+    yuint64_t raw_uint64[size];
+    yvar_t raw_int32_vars[size];
+    yvar_t raw_uint64_vars[size];
+    yint64_t int32_sum = 0;
+    yuint64_t uint64_sum = 0;
+
+    for (int i = 0; i < size; i++) {
+        raw_int32[i] = (i * 7919) % 2000 - 1000;
+        raw_uint64[i] = (yuint64_t)i * 0x9E3779B97F4A7C15ULL;
+        yvar_int32(raw_int32_vars[i], raw_int32[i]);
+        yvar_uint64(raw_uint64_vars[i], raw_uint64[i]);
+        int32_sum += raw_int32[i];
+        uint64_sum += raw_uint64[i];
+    }
+
+    yvar_t int32_vars = YVAR_EMPTY();
+    yvar_t uint64_vars = YVAR_EMPTY();
+    yvar_t int32_packed = YVAR_EMPTY();
+    yvar_t uint64_packed = YVAR_EMPTY();
+    yvar_array(int32_vars, raw_int32_vars);
+    yvar_array(uint64_vars, raw_uint64_vars);
+    yvar_packed_array(int32_packed, YVAR_TYPE_INT32, raw_int32);
+    yvar_packed_array(uint64_packed, YVAR_TYPE_UINT64, raw_uint64);
+
+    ASSERT_TRUE(yvar_kernel_name());
+
+    yvar_t sum = YVAR_EMPTY();
+    yvar_t expected = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_array_sum(int32_vars, sum));
+    yvar_int64(expected, int32_sum);
+    ASSERT_TRUE(yvar_equal(sum, expected));
+    ASSERT_TRUE(yvar_array_sum(int32_packed, sum));
+    ASSERT_TRUE(yvar_equal(sum, expected));
+    ASSERT_TRUE(yvar_array_sum(uint64_vars, sum));
+    yvar_uint64(expected, uint64_sum);
+    ASSERT_TRUE(yvar_equal(sum, expected));
+    ASSERT_TRUE(yvar_array_sum(uint64_packed, sum));
+    ASSERT_TRUE(yvar_equal(sum, expected));
+
+    yvar_t min = YVAR_EMPTY();
+    yvar_t max = YVAR_EMPTY();
+    yvar_t expected_min = YVAR_EMPTY();
+    yvar_t expected_max = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_array_minmax(int32_packed, min, max));
+    yvar_int32(expected_min, -1000);
+    yvar_int32(expected_max, 999);
+    ASSERT_TRUE(yvar_equal(min, expected_min));
+    ASSERT_TRUE(yvar_equal(max, expected_max));
+
+    yuint64_t uint64_min = raw_uint64[0];
+    yuint64_t uint64_max = raw_uint64[0];
+
+    for (int i = 0; i < size; i++) {
+        uint64_min = raw_uint64[i] < uint64_min? raw_uint64[i]: uint64_min;
+        uint64_max = raw_uint64[i] > uint64_max? raw_uint64[i]: uint64_max;
+    }
+
+    ASSERT_TRUE(yvar_array_minmax(uint64_vars, min, max));
+    yvar_uint64(expected_min, uint64_min);
+    yvar_uint64(expected_max, uint64_max);
+    ASSERT_TRUE(yvar_equal(min, expected_min));
+    ASSERT_TRUE(yvar_equal(max, expected_max));
+
+    // every op selects the same items as a plain loop.
+    yvar_t pivot = YVAR_EMPTY();
+    yvar_int64(pivot, 17);
+    yvar_cmp_t ops[] = {YVAR_CMP_EQ, YVAR_CMP_NE, YVAR_CMP_LT, YVAR_CMP_LE, YVAR_CMP_GT, YVAR_CMP_GE};
+
+    for (size_t op = 0; op < sizeof(ops) / sizeof(ops[0]); op++) {
+        yvar_t filtered_vars = YVAR_EMPTY();
+        yvar_t filtered_packed = YVAR_EMPTY();
+        ASSERT_TRUE(yvar_array_filter_cmp(int32_vars, ops[op], pivot, filtered_vars));
+        ASSERT_TRUE(yvar_array_filter_cmp(int32_packed, ops[op], pivot, filtered_packed));
+        ASSERT_TRUE(yvar_is_array(filtered_vars));
+        ASSERT_TRUE(yvar_is_packed_array(filtered_packed));
+
+        size_t cnt = 0;
+
+        for (int i = 0; i < size; i++) {
+            yint32_t v = raw_int32[i];
+            bool hit = YVAR_CMP_EQ == ops[op]? v == 17: YVAR_CMP_NE == ops[op]? v != 17:
+                YVAR_CMP_LT == ops[op]? v < 17: YVAR_CMP_LE == ops[op]? v <= 17:
+                YVAR_CMP_GT == ops[op]? v > 17: v >= 17;
+
+            if (!hit) {
+                continue;
+            }
+
+            yvar_t item = YVAR_EMPTY();
+            ASSERT_TRUE(yvar_array_get(filtered_vars, cnt, item));
+            ASSERT_TRUE(yvar_equal(item, raw_int32_vars[i]));
+            ASSERT_TRUE(yvar_array_get(filtered_packed, cnt, item));
+            ASSERT_TRUE(yvar_equal(item, raw_int32_vars[i]));
+            cnt++;
+        }
+
+        ASSERT_EQ(yvar_count(filtered_vars), cnt);
+        ASSERT_EQ(yvar_count(filtered_packed), cnt);
+    }
+
+    yvar_t value = YVAR_EMPTY();
+    yvar_int32(value, raw_int32[10]);
+    size_t int32_cnt = 0;
+
+    for (int i = 0; i < size; i++) {
+        int32_cnt += raw_int32[i] == raw_int32[10];
+    }
+
+    ASSERT_EQ(yvar_array_count_eq(int32_vars, value), int32_cnt);
+    ASSERT_EQ(yvar_array_count_eq(int32_packed, value), int32_cnt);
+    yvar_uint64(value, raw_uint64[size - 1]);
+    ASSERT_EQ(yvar_array_count_eq(uint64_packed, value), 1u);
+
+    // value out of range of items.
+    yvar_t filtered = YVAR_EMPTY();
+    yvar_uint64(value, YUKI_MAX_UINT64_VALUE);
+    ASSERT_EQ(yvar_array_count_eq(int32_vars, value), 0u);
+    ASSERT_TRUE(yvar_array_filter_cmp(int32_vars, YVAR_CMP_LT, value, filtered));
+    ASSERT_EQ(yvar_count(filtered), (size_t)size);
+    yvar_int8(value, -1);
+    ASSERT_TRUE(yvar_array_filter_cmp(uint64_packed, YVAR_CMP_LE, value, filtered));
+    ASSERT_EQ(yvar_count(filtered), 0u);
+
+    // vars must have same int type.
+    yvar_t mixed_raw[] = {YVAR_EMPTY(), YVAR_EMPTY()};
+    yvar_int32(mixed_raw[0], 1);
+    yvar_int64(mixed_raw[1], 2);
+    yvar_t mixed = YVAR_EMPTY();
+    yvar_array(mixed, mixed_raw);
+    ASSERT_FALSE(yvar_array_sum(mixed, sum));
+    ASSERT_FALSE(yvar_array_minmax(mixed, min, max));
+
+    yvar_t empty = YVAR_EMPTY();
+    yvar_array_with_size(empty, NULL, 0);
+    ASSERT_TRUE(yvar_array_sum(empty, sum));
+    ASSERT_EQ(yvar_to_int64(sum), 0);
+    ASSERT_FALSE(yvar_array_minmax(empty, min, max));
+
+    yuki_clean_up();
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, ArraySlice) {
+    yuki_init(YUKI_CFG_FILE);
+
+    yvar_t raw_vars[10];
+
+    for (int i = 0; i < 10; i++) {
+        yvar_int32(raw_vars[i], i);
+    }
+
+    yvar_t arr = YVAR_EMPTY();
+    yvar_array(arr, raw_vars);
+    yvar_set_option(arr, YVAR_OPTION_SORTED);
+
+    // slice shares vars with array.
+    yvar_t slice = YVAR_EMPTY();
+    yvar_t item = YVAR_EMPTY();
+    yint32_t value;
+    ASSERT_TRUE(yvar_array_slice(arr, 2, 5, slice));
+    ASSERT_TRUE(yvar_is_array(slice));
+    ASSERT_EQ(yvar_count(slice), 3u);
+    ASSERT_TRUE(yvar_has_option(slice, YVAR_OPTION_READONLY));
+    ASSERT_TRUE(yvar_has_option(slice, YVAR_OPTION_SORTED));
+    ASSERT_TRUE(yvar_array_get(slice, 0, item));
+    ASSERT_TRUE(yvar_get_int32(item, value));
+    ASSERT_EQ(value, 2);
+    ASSERT_FALSE(yvar_array_push_back(slice, item));
+
+    // range is clamped to array size. a readonly view can be reused as output.
+    ASSERT_TRUE(yvar_array_slice(arr, 8, 100, slice));
+    ASSERT_EQ(yvar_count(slice), 2u);
+    ASSERT_TRUE(yvar_array_slice(arr, 20, 100, slice));
+    ASSERT_EQ(yvar_count(slice), 0u);
+
+    // strided view takes every stride-th var.
+    yvar_t strided = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_array_stride(arr, 1, 10, 3, strided));
+    ASSERT_TRUE(yvar_is_strided_array(strided));
+    ASSERT_EQ(yvar_count(strided), 3u);
+    ASSERT_EQ(yvar_array_size(strided), 3u);
+    ASSERT_TRUE(yvar_array_get(strided, 2, item));
+    ASSERT_TRUE(yvar_get_int32(item, value));
+    ASSERT_EQ(value, 7);
+    yvar_t undefined = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_array_get(strided, 3, undefined));
+    ASSERT_TRUE(yvar_is_undefined(undefined));
+
+    // view of a strided view multiplies strides.
+    yvar_t nested = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_array_stride(strided, 0, 3, 2, nested));
+    ASSERT_TRUE(yvar_is_strided_array(nested));
+    ASSERT_EQ(yvar_count(nested), 2u);
+    ASSERT_TRUE(yvar_array_get(nested, 1, item));
+    ASSERT_TRUE(yvar_get_int32(item, value));
+    ASSERT_EQ(value, 7);
+
+    // foreach walks viewed vars only.
+    int cnt = 0;
+    FOREACH_YVAR_ARRAY(strided, viewed) {
+        ASSERT_TRUE(yvar_get_int32(*viewed, value));
+        ASSERT_EQ(value, 1 + cnt * 3);
+        cnt++;
+    }
+    ASSERT_EQ(cnt, 3);
+
+    // pin and clone copy viewed vars only.
+    yvar_t * pinned = NULL;
+    yvar_t * cloned = NULL;
+    yvar_t raw_expected[3];
+    yvar_t expected = YVAR_EMPTY();
+    yvar_int32(raw_expected[0], 1);
+    yvar_int32(raw_expected[1], 4);
+    yvar_int32(raw_expected[2], 7);
+    yvar_array(expected, raw_expected);
+    ASSERT_TRUE(yvar_pin(pinned, strided));
+    ASSERT_TRUE(yvar_is_array(*pinned));
+    ASSERT_NE(pinned->data.yarray_data.yvars, raw_vars + 1);
+    ASSERT_TRUE(yvar_equal(*pinned, expected));
+    ASSERT_TRUE(yvar_unpin(pinned));
+    ASSERT_TRUE(yvar_clone(cloned, strided));
+    ASSERT_TRUE(yvar_equal(*cloned, expected));
+
+    ASSERT_TRUE(yvar_array_slice(arr, 4, 7, slice));
+    ASSERT_TRUE(yvar_pin(pinned, slice));
+    ASSERT_EQ(yvar_count(*pinned), 3u);
+    ASSERT_TRUE(yvar_equal(*pinned, slice));
+    ASSERT_FALSE(yvar_array_slice(arr, 0, 1, *pinned));
+    ASSERT_TRUE(yvar_unpin(pinned));
+
+    // chunks cover array in order.
+    ysize_t offset = 0;
+    ysize_t sizes = 0;
+    int chunks = 0;
+    yvar_t chunk = YVAR_EMPTY();
+
+    while (yvar_array_chunk(arr, 4, offset, chunk)) {
+        ASSERT_TRUE(yvar_array_get(chunk, 0, item));
+        ASSERT_TRUE(yvar_get_int32(item, value));
+        ASSERT_EQ(value, chunks * 4);
+        sizes += yvar_count(chunk);
+        chunks++;
+    }
+
+    ASSERT_EQ(chunks, 3);
+    ASSERT_EQ(sizes, 10u);
+    ASSERT_EQ(offset, 10u);
+
+    // packed array can be sliced but not strided.
+    yint64_t raw_ids[] = {10, 20, 30, 40};
+    yvar_t ids = YVAR_EMPTY();
+    yint64_t id;
+    yvar_packed_array(ids, YVAR_TYPE_INT64, raw_ids);
+    ASSERT_TRUE(yvar_array_slice(ids, 1, 3, slice));
+    ASSERT_TRUE(yvar_is_packed_array(slice));
+    ASSERT_EQ(yvar_count(slice), 2u);
+    ASSERT_TRUE(yvar_array_get(slice, 1, item));
+    ASSERT_TRUE(yvar_get_int64(item, id));
+    ASSERT_EQ(id, 30);
+    ASSERT_FALSE(yvar_array_stride(ids, 0, 4, 2, strided));
+
+    yuki_clean_up();
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, VarEncodeAndView) {
+    yuki_init(YUKI_CFG_FILE);
+
+    // hashed map
+    const int size = 40;
+    char key_strs[size][16];
+    yvar_t raw_key_value[size][2];
+
+    for (int i = 0; i < size; i++) {
+        snprintf(key_strs[i], sizeof(key_strs[i]), "column_%d", i);
+        yvar_cstr_with_size(raw_key_value[i][0], key_strs[i], strlen(key_strs[i]));
+        yvar_int32(raw_key_value[i][1], i);
+    }
+
+    yvar_t * map = NULL;
+    ASSERT_TRUE(yvar_map_smart_clone(map, raw_key_value));
+
+    // rows sharing one keys var
+    yvar_t raw_keys[2];
+    yvar_t raw_values[3][2];
+    yvar_t keys = YVAR_EMPTY();
+    yvar_t values[3];
+    yvar_t raw_rows[3];
+    yvar_t rows = YVAR_EMPTY();
+    yvar_cstr(raw_keys[0], "uid");
+    yvar_cstr(raw_keys[1], "a long column name");
+    yvar_array(keys, raw_keys);
+
+    for (int i = 0; i < 3; i++) {
+        yvar_int32(raw_values[i][0], i);
+        yvar_cstr(raw_values[i][1], "a value longer than inline str");
+        yvar_array(values[i], raw_values[i]);
+        yvar_map(raw_rows[i], keys, values[i]);
+    }
+
+    yvar_array(rows, raw_rows);
+
+    yvar_t list = YVAR_EMPTY();
+    yvar_list(list);
+
+    for (yint32_t i = 0; i < 20; i++) {
+        yvar_t value = YVAR_EMPTY();
+        yvar_int32(value, i);
+        ASSERT_TRUE(yvar_list_push_back(list, value));
+    }
+
+    yint64_t raw_ids[] = {10, 20, 30};
+    yvar_t ids = YVAR_EMPTY();
+    yvar_packed_array(ids, YVAR_TYPE_INT64, raw_ids);
+
+    yvar_t raw_ints[6];
+    yvar_t ints = YVAR_EMPTY();
+    yvar_t strided = YVAR_EMPTY();
+
+    for (int i = 0; i < 6; i++) {
+        yvar_int32(raw_ints[i], i);
+    }
+
+    yvar_array(ints, raw_ints);
+    ASSERT_TRUE(yvar_array_stride(ints, 0, 6, 2, strided));
+
+    yvar_t raw_root[6];
+    yvar_t root = YVAR_EMPTY();
+    raw_root[0] = *map;
+    raw_root[1] = rows;
+    raw_root[2] = list;
+    raw_root[3] = ids;
+    raw_root[4] = strided;
+    yvar_cstr(raw_root[5], "short");
+    yvar_array(root, raw_root);
+
+    ysize_t encoded_size = yvar_encoded_size(root);
+    ASSERT_GT(encoded_size, 0u);
+    ASSERT_EQ(encoded_size % 8, 0u);
+
+    yuint64_t * buf = (yuint64_t *)malloc(encoded_size);
+    yuint64_t * copy = (yuint64_t *)malloc(encoded_size);
+    ASSERT_FALSE(yvar_encode(root, buf, encoded_size - 8));
+    ASSERT_TRUE(yvar_encode(root, buf, encoded_size));
+
+    // buffer is viewed in place at encoded address. it's never written.
+    // buffer at any other address is refused and must be copied.
+    memcpy(copy, buf, encoded_size);
+    yvar_t * views[2] = {NULL, NULL};
+    ASSERT_TRUE(yvar_view(views[0], buf, encoded_size));
+    ASSERT_EQ((void *)views[0], (void *)((char *)buf + 24));
+    ASSERT_FALSE(yvar_view(views[1], copy, encoded_size));
+    ASSERT_EQ(memcmp(copy, buf, encoded_size), 0);
+    ASSERT_TRUE(yvar_view_copy(views[1], copy, encoded_size));
+    ASSERT_EQ(memcmp(copy, buf, encoded_size), 0);
+    ASSERT_TRUE(yvar_equal(*views[1], *views[0]));
+    memset(buf, 0, encoded_size);
+    memset(copy, 0, encoded_size);
+
+    yvar_t * view = views[1];
+    yvar_t item = YVAR_EMPTY();
+    yvar_t key = YVAR_EMPTY();
+    yvar_t value = YVAR_EMPTY();
+    yint32_t int32_value;
+    ASSERT_TRUE(yvar_is_array(*view));
+    ASSERT_EQ(yvar_count(*view), 6u);
+
+    ASSERT_TRUE(yvar_array_get(*view, 0, item));
+    ASSERT_TRUE(yvar_has_option(item, YVAR_OPTION_HASHED));
+    ASSERT_FALSE(yvar_has_option(item, YVAR_OPTION_HOLD_RESOURCE));
+    ASSERT_TRUE(yvar_equal(item, *map));
+    yvar_cstr(key, "column_33");
+    ASSERT_TRUE(yvar_map_get(item, key, value));
+    ASSERT_TRUE(yvar_get_int32(value, int32_value));
+    ASSERT_EQ(int32_value, 33);
+
+    ASSERT_TRUE(yvar_array_get(*view, 1, item));
+    ASSERT_TRUE(yvar_equal(item, rows));
+    ASSERT_EQ(item.data.yarray_data.yvars[0].data.ymap_data.keys, item.data.yarray_data.yvars[2].data.ymap_data.keys);
+
+    ASSERT_TRUE(yvar_array_get(*view, 2, item));
+    ASSERT_TRUE(yvar_equal(item, list));
+
+    ASSERT_TRUE(yvar_array_get(*view, 3, item));
+    ASSERT_TRUE(yvar_equal(item, ids));
+
+    // strided array is encoded as a generic array.
+    yvar_t * expected = NULL;
+    ASSERT_TRUE(yvar_clone(expected, strided));
+    ASSERT_TRUE(yvar_array_get(*view, 4, item));
+    ASSERT_TRUE(yvar_is_array(item));
+    ASSERT_TRUE(yvar_equal(item, *expected));
+
+    // item is readonly now as strided view is.
+    yvar_t short_str = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_array_get(*view, 5, short_str));
+    ASSERT_TRUE(yvar_equal(short_str, raw_root[5]));
+
+    // bad buffers are rejected.
+    ASSERT_TRUE(yvar_encode(root, buf, encoded_size));
+    ASSERT_FALSE(yvar_view(views[0], buf, encoded_size - 8));
+
+    ASSERT_TRUE(yvar_encode(root, buf, encoded_size));
+    buf[0] ^= 1;
+    ASSERT_FALSE(yvar_view(views[0], buf, encoded_size));
+
+    // root is the first var after 24-byte header. corrupt pointer to its vars.
+    ASSERT_TRUE(yvar_encode(root, buf, encoded_size));
+    buf[3 + 2] += 8;
+    ASSERT_FALSE(yvar_view(views[0], buf, encoded_size));
+
+    ASSERT_TRUE(yvar_encode(root, buf, encoded_size));
+    ((yvar_t *)(buf + 3))->options |= YVAR_OPTION_PINNED;
+    ASSERT_FALSE(yvar_view(views[0], buf, encoded_size));
+    ASSERT_FALSE(yvar_view_copy(views[0], buf, encoded_size));
+
+    // encoded var doesn't depend on garbage in buffer or in unused bytes of vars.
+    memset(buf, 0xAA, encoded_size);
+    ASSERT_TRUE(yvar_encode(root, buf, encoded_size));
+    memcpy(copy, buf, encoded_size);
+    memset(buf, 0x55, encoded_size);
+    ASSERT_TRUE(yvar_encode(root, buf, encoded_size));
+    ASSERT_EQ(memcmp(copy, buf, encoded_size), 0);
+
+    yvar_t dirty;
+    memset(&dirty, 0xCC, sizeof(dirty));
+    yvar_int32(dirty, 7);
+    ASSERT_TRUE(yvar_encode(dirty, buf, yvar_encoded_size(dirty)));
+    yvar_t expected_dirty;
+    memset(&expected_dirty, 0, sizeof(expected_dirty));
+    yvar_int32(expected_dirty, 7);
+    ASSERT_EQ(memcmp(buf + 3, &expected_dirty, sizeof(yvar_t)), 0);
+
+    // a readonly mapping can be viewed at encoded address.
+    void * mapped = mmap(NULL, encoded_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(mapped, MAP_FAILED);
+    ASSERT_TRUE(yvar_encode(root, mapped, encoded_size));
+    ASSERT_EQ(mprotect(mapped, encoded_size, PROT_READ), 0);
+    yvar_t mapped_ids = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_view(views[0], mapped, encoded_size));
+    ASSERT_TRUE(yvar_array_get(*views[0], 3, mapped_ids));
+    ASSERT_TRUE(yvar_equal(mapped_ids, ids));
+    ASSERT_TRUE(yvar_view_copy(views[1], mapped, encoded_size));
+    ASSERT_TRUE(yvar_equal(*views[1], *views[0]));
+    ASSERT_EQ(munmap(mapped, encoded_size), 0);
+
+    free(buf);
+    free(copy);
+
+    yuki_clean_up();
+    yuki_shutdown();
+}
+
 TEST(YukiVarTest, VarMapCloneAndPin) {
     yuki_init(YUKI_CFG_FILE);
 
@@ -477,6 +1456,479 @@ TEST(YukiVarTest, VarMapCloneAndPin) {
     yuki_shutdown();
 }
 
+TEST(YukiVarTest, VarCloneInternStr) {
+    yuki_init(YUKI_CFG_FILE);
+
+    // strs with embedded '\0'
+    static const char raw_str1[] = {'a', '\0', 'b'};
+    static const char raw_str2[] = {'a', '\0', 'c'};
+    yvar_t str1 = YVAR_EMPTY();
+    yvar_t str2 = YVAR_EMPTY();
+    yvar_cstr_with_size(str1, raw_str1, sizeof(raw_str1));
+    yvar_cstr_with_size(str2, raw_str2, sizeof(raw_str2));
+    ASSERT_FALSE(yvar_equal(str1, str2));
+    ASSERT_EQ(yvar_compare(str1, str2), -1);
+
+    // short str is stored inside var
+    yvar_t * new_str1 = NULL;
+    ASSERT_TRUE(yvar_clone(new_str1, str1));
+    ASSERT_TRUE(yvar_has_option(*new_str1, YVAR_OPTION_INLINE));
+    ASSERT_FALSE(yvar_has_option(*new_str1, YVAR_OPTION_HASHED));
+    ASSERT_EQ(yvar_cstr_strlen(*new_str1), sizeof(raw_str1));
+    ASSERT_EQ(yvar_cstr_buffer(*new_str1)[2], 'b');
+    ASSERT_TRUE(yvar_equal(*new_str1, str1));
+    ASSERT_FALSE(yvar_equal(*new_str1, str2));
+
+    // long str has a cached hash
+    static const char raw_long_str[] = "a str longer than inline str";
+    yvar_t long_str = YVAR_EMPTY();
+    yvar_cstr(long_str, raw_long_str);
+
+    yvar_t * new_long_str = NULL;
+    ASSERT_TRUE(yvar_clone(new_long_str, long_str));
+    ASSERT_FALSE(yvar_has_option(*new_long_str, YVAR_OPTION_INLINE));
+    ASSERT_TRUE(yvar_has_option(*new_long_str, YVAR_OPTION_HASHED));
+    ASSERT_TRUE(yvar_equal(*new_long_str, long_str));
+    ASSERT_STREQ(yvar_cstr_buffer(*new_long_str), raw_long_str);
+
+    // buffer of a str which is not inline can be assigned thru reference
+    static const char raw_other_str[] = "another str";
+    yvar_t ref_str = YVAR_EMPTY();
+    yvar_cstr(ref_str, "abc");
+    yvar_cstr_buffer_ref(ref_str) = raw_other_str;
+    ASSERT_EQ(yvar_cstr_buffer(ref_str), raw_other_str);
+
+    // rows share one keys var, like rows in a result set
+    const int field_cnt = 10;
+    const int row_cnt = 3;
+    char field_strs[field_cnt][16];
+    yvar_t field_raw_keys[field_cnt];
+    yvar_t raw_values[row_cnt][field_cnt];
+
+    for (int i = 0; i < field_cnt; i++) {
+        snprintf(field_strs[i], sizeof(field_strs[i]), "field_%d", i);
+        yvar_cstr_with_size(field_raw_keys[i], field_strs[i], strlen(field_strs[i]));
+
+        for (int r = 0; r < row_cnt; r++) {
+            yvar_int32(raw_values[r][i], r * 100 + i);
+        }
+    }
+
+    yvar_t field_keys = YVAR_EMPTY();
+    yvar_array(field_keys, field_raw_keys);
+    yvar_t value_arrays[row_cnt];
+    yvar_t rows[row_cnt];
+
+    for (int r = 0; r < row_cnt; r++) {
+        yvar_array(value_arrays[r], raw_values[r]);
+        yvar_map(rows[r], field_keys, value_arrays[r]);
+    }
+
+    yvar_t result = YVAR_EMPTY();
+    yvar_array(result, rows);
+
+    yvar_t * new_result = NULL;
+    ASSERT_TRUE(yvar_clone(new_result, result));
+    ASSERT_TRUE(yvar_equal(*new_result, result));
+
+    yvar_t row0 = YVAR_EMPTY();
+    yvar_t row = YVAR_EMPTY();
+    yvar_t key = YVAR_EMPTY();
+    yvar_t value = YVAR_EMPTY();
+    yint32_t int32_value;
+    ASSERT_TRUE(yvar_array_get(*new_result, 0, row0));
+
+    for (int r = 0; r < row_cnt; r++) {
+        ASSERT_TRUE(yvar_array_get(*new_result, r, row));
+        ASSERT_EQ(row.data.ymap_data.keys, row0.data.ymap_data.keys);
+        ASSERT_TRUE(yvar_has_option(row, YVAR_OPTION_HASHED));
+
+        for (int i = 0; i < field_cnt; i++) {
+            yvar_cstr_with_size(key, field_strs[i], strlen(field_strs[i]));
+            ASSERT_TRUE(yvar_map_get(row, key, value));
+            ASSERT_TRUE(yvar_get_int32(value, int32_value));
+            ASSERT_EQ(int32_value, r * 100 + i);
+        }
+    }
+
+    // same str in an array is interned
+    yvar_t same_strs[] = {long_str, str2, long_str};
+    yvar_t str_array = YVAR_EMPTY();
+    yvar_array(str_array, same_strs);
+    yvar_t * new_str_array = NULL;
+    ASSERT_TRUE(yvar_clone(new_str_array, str_array));
+
+    yvar_t item0 = YVAR_EMPTY();
+    yvar_t item2 = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_array_get(*new_str_array, 0, item0));
+    ASSERT_TRUE(yvar_array_get(*new_str_array, 2, item2));
+    ASSERT_EQ(yvar_cstr_buffer(item0), yvar_cstr_buffer(item2));
+    ASSERT_NE(yvar_cstr_buffer(item0), raw_long_str);
+    ASSERT_TRUE(yvar_has_option(item0, YVAR_OPTION_INTERNED));
+
+    // unshared str gets its own chars. other strs are not changed.
+    ASSERT_TRUE(yvar_str_unshare(item0));
+    ASSERT_FALSE(yvar_has_option(item0, YVAR_OPTION_INTERNED | YVAR_OPTION_HASHED));
+    ASSERT_NE(yvar_cstr_buffer(item0), yvar_cstr_buffer(item2));
+    ASSERT_TRUE(yvar_equal(item0, item2));
+    yvar_str_buffer(item0)[0] = '#';
+    ASSERT_FALSE(yvar_equal(item0, item2));
+    ASSERT_STREQ(yvar_cstr_buffer(item2), raw_long_str);
+
+    yuki_clean_up();
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, VarMapHashIndex) {
+    yuki_init(YUKI_CFG_FILE);
+
+    const int size = 40;
+    char key_strs[size][16];
+    yvar_t raw_key_value[size + 1][2];
+
+    for (int i = 0; i < size; i++) {
+        snprintf(key_strs[i], sizeof(key_strs[i]), "column_%d", i);
+        yvar_cstr_with_size(raw_key_value[i][0], key_strs[i], strlen(key_strs[i]));
+        yvar_int32(raw_key_value[i][1], i);
+    }
+
+    // duplicated key. first one wins.
+    yvar_cstr_with_size(raw_key_value[size][0], key_strs[10], strlen(key_strs[10]));
+    yvar_int32(raw_key_value[size][1], -1);
+
+    yvar_t * maps[2] = {NULL, NULL};
+    ASSERT_TRUE(yvar_map_smart_clone(maps[0], raw_key_value));
+    ASSERT_TRUE(yvar_map_smart_pin(maps[1], raw_key_value));
+
+    for (int m = 0; m < 2; m++) {
+        ASSERT_TRUE(yvar_has_option(*maps[m], YVAR_OPTION_HASHED));
+        ASSERT_EQ(yvar_count(*maps[m]), (ysize_t)size + 1);
+
+        yvar_t key = YVAR_EMPTY();
+        yvar_t value = YVAR_EMPTY();
+        yint32_t int32_value;
+
+        for (int i = 0; i < size; i++) {
+            yvar_cstr_with_size(key, key_strs[i], strlen(key_strs[i]));
+            ASSERT_TRUE(yvar_map_get(*maps[m], key, value));
+            ASSERT_TRUE(yvar_get_int32(value, int32_value));
+            ASSERT_EQ(int32_value, i);
+        }
+
+        yvar_cstr(key, "column_100");
+        ASSERT_FALSE(yvar_map_get(*maps[m], key, value));
+        ASSERT_TRUE(yvar_is_undefined(value));
+
+        // key of another type never matches
+        yvar_int32(key, 10);
+        ASSERT_FALSE(yvar_map_get(*maps[m], key, value));
+    }
+
+    ASSERT_TRUE(yvar_unpin(maps[1]));
+
+    // small map is not indexed
+    yvar_t small_key = YVAR_EMPTY();
+    yvar_t small_value = YVAR_EMPTY();
+    yvar_cstr(small_key, "uid");
+    yvar_int32(small_value, 1);
+    yvar_map_kv_t small_key_value = {
+        {small_key, small_value},
+    };
+    yvar_t * small_map = NULL;
+    ASSERT_TRUE(yvar_map_smart_clone(small_map, small_key_value));
+    ASSERT_FALSE(yvar_has_option(*small_map, YVAR_OPTION_HASHED));
+
+    yuki_clean_up();
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, VarMapSorted) {
+    yuki_init(YUKI_CFG_FILE);
+
+    yvar_t lhs = YVAR_EMPTY();
+    yvar_t rhs = YVAR_EMPTY();
+    yvar_cstr(lhs, "abc");
+    yvar_cstr(rhs, "abd");
+    ASSERT_EQ(yvar_compare(lhs, rhs), -1);
+    ASSERT_EQ(yvar_compare(rhs, lhs), 1);
+    ASSERT_EQ(yvar_compare(lhs, lhs), 0);
+    yvar_int32(lhs, -5);
+    yvar_int32(rhs, 3);
+    ASSERT_EQ(yvar_compare(lhs, rhs), -1);
+
+    const int size = 40;
+    char key_strs[size][16];
+    yvar_t raw_key_value[size + 1][2];
+
+    // insert keys in reversed order
+    for (int i = 0; i < size; i++) {
+        snprintf(key_strs[i], sizeof(key_strs[i]), "column_%02d", i);
+        yvar_cstr_with_size(raw_key_value[size - 1 - i][0], key_strs[i], strlen(key_strs[i]));
+        yvar_int32(raw_key_value[size - 1 - i][1], i);
+    }
+
+    // duplicated key. sort is stable, so that first one wins.
+    yvar_cstr_with_size(raw_key_value[size][0], key_strs[10], strlen(key_strs[10]));
+    yvar_int32(raw_key_value[size][1], -1);
+
+    yvar_t * maps[2] = {NULL, NULL};
+    ASSERT_TRUE(yvar_map_smart_sorted_clone(maps[0], raw_key_value));
+    ASSERT_TRUE(yvar_map_smart_sorted_pin(maps[1], raw_key_value));
+
+    for (int m = 0; m < 2; m++) {
+        ASSERT_TRUE(yvar_has_option(*maps[m], YVAR_OPTION_SORTED));
+        ASSERT_FALSE(yvar_has_option(*maps[m], YVAR_OPTION_HASHED));
+        ASSERT_EQ(yvar_count(*maps[m]), (ysize_t)size + 1);
+
+        yvar_t key = YVAR_EMPTY();
+        yvar_t value = YVAR_EMPTY();
+        yint32_t int32_value;
+
+        for (int i = 0; i < size; i++) {
+            yvar_cstr_with_size(key, key_strs[i], strlen(key_strs[i]));
+            ASSERT_TRUE(yvar_map_get(*maps[m], key, value));
+            ASSERT_TRUE(yvar_get_int32(value, int32_value));
+            ASSERT_EQ(int32_value, i);
+        }
+
+        // keys in [column_05, column_08)
+        yvar_t lower = YVAR_EMPTY();
+        yvar_t upper = YVAR_EMPTY();
+        yvar_t keys = YVAR_EMPTY();
+        yvar_t values = YVAR_EMPTY();
+        yvar_cstr_with_size(lower, key_strs[5], strlen(key_strs[5]));
+        yvar_cstr_with_size(upper, key_strs[8], strlen(key_strs[8]));
+        ASSERT_TRUE(yvar_map_range(*maps[m], lower, upper, keys, values));
+        ASSERT_EQ(yvar_count(keys), 3u);
+
+        int i = 5;
+        FOREACH_YVAR_ARRAY(values, v) {
+            ASSERT_TRUE(yvar_get_int32(*v, int32_value));
+            ASSERT_EQ(int32_value, i);
+            i++;
+        }
+
+        // no upper bound
+        ASSERT_TRUE(yvar_map_range_from(*maps[m], lower, keys, values));
+        ASSERT_EQ(yvar_count(keys), (ysize_t)size + 1 - 5);
+
+        // no lower bound
+        ASSERT_TRUE(yvar_map_range_to(*maps[m], upper, keys, values));
+        ASSERT_EQ(yvar_count(keys), 8u);
+
+        ASSERT_TRUE(yvar_map_range_all(*maps[m], keys, values));
+        ASSERT_EQ(yvar_count(keys), (ysize_t)size + 1);
+
+        yvar_cstr(key, "column_100");
+        ASSERT_FALSE(yvar_map_get(*maps[m], key, value));
+        ASSERT_TRUE(yvar_is_undefined(value));
+    }
+
+    ASSERT_TRUE(yvar_unpin(maps[1]));
+
+    // range only works on sorted map
+    yvar_t * map = NULL;
+    yvar_t keys = YVAR_EMPTY();
+    yvar_t values = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_map_smart_clone(map, raw_key_value));
+    ASSERT_FALSE(yvar_map_range_all(*map, keys, values));
+
+    yuki_clean_up();
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, VarArraySortAndSet) {
+    yuki_init(YUKI_CFG_FILE);
+
+    // large int array is sorted by radix sort
+    const int size = 1000;
+    yvar_t ids[size];
+
+    for (int i = 0; i < size; i++) {
+        yvar_int64(ids[i], (yint64_t)((i * 7919) % size) - size / 2);
+    }
+
+    yvar_t id_array = YVAR_EMPTY();
+    yvar_array(id_array, ids);
+    ASSERT_TRUE(yvar_array_sort(id_array));
+    ASSERT_TRUE(yvar_has_option(id_array, YVAR_OPTION_SORTED));
+
+    yint64_t int64_value;
+    yint64_t expected = -size / 2;
+    FOREACH_YVAR_ARRAY(id_array, v) {
+        ASSERT_TRUE(yvar_get_int64(*v, int64_value));
+        ASSERT_EQ(int64_value, expected);
+        expected++;
+    }
+
+    // strings and mixed types
+    yvar_t strs[5];
+    yvar_cstr(strs[0], "pear");
+    yvar_cstr(strs[1], "apple");
+    yvar_uint32(strs[2], 3);
+    yvar_cstr(strs[3], "pear");
+    yvar_cstr(strs[4], "banana");
+
+    yvar_t str_array = YVAR_EMPTY();
+    yvar_array(str_array, strs);
+    ASSERT_TRUE(yvar_array_unique(str_array));
+    ASSERT_EQ(yvar_count(str_array), 4u);
+
+    yvar_t item = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_array_get(str_array, 0, item));
+    ASSERT_TRUE(yvar_is_uint32(item));
+    ASSERT_TRUE(yvar_array_get(str_array, 1, item));
+    ASSERT_STREQ(yvar_cstr_buffer(item), "apple");
+    ASSERT_TRUE(yvar_array_get(str_array, 3, item));
+    ASSERT_STREQ(yvar_cstr_buffer(item), "pear");
+
+    // set operations work on unsorted arrays with duplicated vars
+    yvar_t lhs_items[6];
+    yvar_t rhs_items[4];
+    yint32_t lhs_values[] = {5, 1, 3, 3, 9, 7};
+    yint32_t rhs_values[] = {3, 4, 9, 5};
+
+    for (int i = 0; i < 6; i++) {
+        yvar_int32(lhs_items[i], lhs_values[i]);
+    }
+
+    for (int i = 0; i < 4; i++) {
+        yvar_int32(rhs_items[i], rhs_values[i]);
+    }
+
+    yvar_t lhs = YVAR_EMPTY();
+    yvar_t rhs = YVAR_EMPTY();
+    yvar_t output = YVAR_EMPTY();
+    yvar_array(lhs, lhs_items);
+    yvar_array(rhs, rhs_items);
+
+    yint32_t int32_value;
+    yint32_t intersect_values[] = {3, 5, 9};
+    ASSERT_TRUE(yvar_array_intersect(lhs, rhs, output));
+    ASSERT_EQ(yvar_count(output), 3u);
+
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(yvar_array_get(output, i, item));
+        ASSERT_TRUE(yvar_get_int32(item, int32_value));
+        ASSERT_EQ(int32_value, intersect_values[i]);
+    }
+
+    yint32_t union_values[] = {1, 3, 4, 5, 7, 9};
+    ASSERT_TRUE(yvar_array_union(lhs, rhs, output));
+    ASSERT_EQ(yvar_count(output), 6u);
+
+    for (int i = 0; i < 6; i++) {
+        ASSERT_TRUE(yvar_array_get(output, i, item));
+        ASSERT_TRUE(yvar_get_int32(item, int32_value));
+        ASSERT_EQ(int32_value, union_values[i]);
+    }
+
+    // inputs are not modified
+    ASSERT_TRUE(yvar_array_get(lhs, 0, item));
+    ASSERT_TRUE(yvar_get_int32(item, int32_value));
+    ASSERT_EQ(int32_value, 5);
+
+    // sort uses no thread memory. open detach window and slab free lists are kept.
+    void * slab = ybuffer_slab_alloc(sizeof(yvar_t));
+    ASSERT_TRUE(slab);
+    ybuffer_slab_free(slab, sizeof(yvar_t));
+
+    ybuffer_mark_t mark;
+    ybuffer_t * chain = NULL;
+    ASSERT_TRUE(ybuffer_detach_begin(&mark));
+    yvar_array(lhs, lhs_items);
+    yvar_array(id_array, ids);
+    ASSERT_TRUE(yvar_array_sort(lhs));
+    ASSERT_TRUE(yvar_array_sort(id_array));
+    ASSERT_TRUE(yvar_array_union(lhs, rhs, output));
+    ASSERT_TRUE(ybuffer_detach(&mark, &chain));
+    ASSERT_TRUE(ybuffer_adopt(chain));
+    ASSERT_EQ(ybuffer_slab_alloc(sizeof(yvar_t)), slab);
+
+    yuki_clean_up();
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, GrowableArray) {
+    yuki_init(YUKI_CFG_FILE);
+
+    yvar_t array = YVAR_EMPTY();
+    yvar_t item = YVAR_EMPTY();
+    yvar_array_with_size(array, NULL, 0);
+
+    const int size = 1000;
+
+    for (int i = 0; i < size; i++) {
+        yvar_int32(item, i);
+        ASSERT_TRUE(yvar_array_push_back(array, item));
+    }
+
+    ASSERT_TRUE(yvar_has_option(array, YVAR_OPTION_GROWABLE));
+    ASSERT_EQ(yvar_count(array), (ysize_t)size);
+    ASSERT_GE(yvar_array_capacity(array), (ysize_t)size);
+
+    yint32_t int32_value;
+    int expected = 0;
+    FOREACH_YVAR_ARRAY(array, v) {
+        ASSERT_TRUE(yvar_get_int32(*v, int32_value));
+        ASSERT_EQ(int32_value, expected);
+        expected++;
+    }
+
+    // latest block in arena grows and shrinks in place
+    ASSERT_TRUE(yvar_array_shrink(array));
+    ASSERT_EQ(yvar_array_capacity(array), (ysize_t)size);
+
+    yvar_t * yvars = array.data.yarray_data.yvars;
+    ASSERT_TRUE(yvar_array_reserve(array, size + 10));
+    ASSERT_EQ(array.data.yarray_data.yvars, yvars);
+    ASSERT_EQ(yvar_array_capacity(array), (ysize_t)size + 10);
+
+    // cloned array is fixed size
+    yvar_t * new_array = NULL;
+    ASSERT_TRUE(yvar_clone(new_array, array));
+    ASSERT_FALSE(yvar_has_option(*new_array, YVAR_OPTION_GROWABLE));
+    ASSERT_TRUE(yvar_equal(*new_array, array));
+
+    // fixed size array becomes growable on push
+    yvar_t raw_items[2];
+    yvar_int32(raw_items[0], 1);
+    yvar_int32(raw_items[1], 2);
+    yvar_t fixed = YVAR_EMPTY();
+    yvar_array(fixed, raw_items);
+    yvar_int32(item, 3);
+    ASSERT_TRUE(yvar_array_push_back(fixed, item));
+    ASSERT_EQ(yvar_count(fixed), 3u);
+    ASSERT_NE(fixed.data.yarray_data.yvars, raw_items);
+    ASSERT_TRUE(yvar_array_get(fixed, 2, item));
+    ASSERT_TRUE(yvar_get_int32(item, int32_value));
+    ASSERT_EQ(int32_value, 3);
+
+    // copies grow apart. spare capacity stays with original array.
+    yvar_t copy = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_assign(copy, fixed));
+    ASSERT_FALSE(yvar_has_option(copy, YVAR_OPTION_GROWABLE));
+    yvar_int32(item, 4);
+    ASSERT_TRUE(yvar_array_push_back(fixed, item));
+    yvar_int32(item, 5);
+    ASSERT_TRUE(yvar_array_push_back(copy, item));
+    ASSERT_EQ(yvar_count(fixed), 4u);
+    ASSERT_EQ(yvar_count(copy), 4u);
+    ASSERT_TRUE(yvar_array_get(fixed, 3, item));
+    ASSERT_TRUE(yvar_get_int32(item, int32_value));
+    ASSERT_EQ(int32_value, 4);
+    ASSERT_TRUE(yvar_array_get(copy, 3, item));
+    ASSERT_TRUE(yvar_get_int32(item, int32_value));
+    ASSERT_EQ(int32_value, 5);
+
+    // readonly array cannot grow
+    yvar_set_option(fixed, YVAR_OPTION_READONLY);
+    ASSERT_FALSE(yvar_array_push_back(fixed, item));
+
+    yuki_clean_up();
+    yuki_shutdown();
+}
+
 TEST(YukiVarTest, VarArrayOfArrayCloneAndPin) {
     yuki_init(YUKI_CFG_FILE);
 
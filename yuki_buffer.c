@@ -1,63 +1,331 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <assert.h>
 
 #include "libconfig.h"
 #include "yuki.h"
 
+#define YBUFFER_CONFIG_PATH_ARENA_CHUNK_SIZE     YUKI_CONFIG_SECTION_YBUFFER "/arena_chunk_size"
+#define YBUFFER_CONFIG_PATH_ARENA_MAX_CHUNK_SIZE YUKI_CONFIG_SECTION_YBUFFER "/arena_max_chunk_size"
+#define YBUFFER_CONFIG_PATH_CACHE_MAX_BYTES      YUKI_CONFIG_SECTION_YBUFFER "/cache_max_bytes"
+#define YBUFFER_CONFIG_PATH_CACHE_MAX_CHUNKS     YUKI_CONFIG_SECTION_YBUFFER "/cache_max_chunks"
+#define YBUFFER_CONFIG_PATH_CHUNK_CACHE_LINE_ALIGN YUKI_CONFIG_SECTION_YBUFFER "/chunk_cache_line_align"
+#define YBUFFER_CONFIG_PATH_MMAP_THRESHOLD       YUKI_CONFIG_SECTION_YBUFFER "/mmap_threshold"
+#define YBUFFER_CONFIG_PATH_MMAP_HUGE_PAGE       YUKI_CONFIG_SECTION_YBUFFER "/mmap_huge_page"
+#define YBUFFER_CONFIG_PATH_RECLAIM_MODE         YUKI_CONFIG_SECTION_YBUFFER "/reclaim_mode"
+#define YBUFFER_CONFIG_PATH_RECLAIM_THRESHOLD    YUKI_CONFIG_SECTION_YBUFFER "/reclaim_threshold"
+#define YBUFFER_CONFIG_PATH_RECLAIM_EPOCHS       YUKI_CONFIG_SECTION_YBUFFER "/reclaim_epochs"
+
+#define YBUFFER_DEFAULT_ARENA_CHUNK_SIZE     (8 * 1024)
+#define YBUFFER_DEFAULT_ARENA_MAX_CHUNK_SIZE (1024 * 1024)
+#define YBUFFER_DEFAULT_CACHE_MAX_BYTES      (4 * 1024 * 1024)
+#define YBUFFER_DEFAULT_CACHE_MAX_CHUNKS     8
+#define YBUFFER_DEFAULT_CHUNK_CACHE_LINE_ALIGN 0
+#define YBUFFER_DEFAULT_MMAP_THRESHOLD       0
+#define YBUFFER_DEFAULT_MMAP_HUGE_PAGE       0
+#define YBUFFER_DEFAULT_RECLAIM_MODE         "none"
+#define YBUFFER_DEFAULT_RECLAIM_THRESHOLD    (64 * 1024 * 1024)
+#define YBUFFER_DEFAULT_RECLAIM_EPOCHS       1
+
+#define YBUFFER_RECLAIM_MODE_NONE      0
+#define YBUFFER_RECLAIM_MODE_THRESHOLD 1
+#define YBUFFER_RECLAIM_MODE_EPOCH     2
+
+// smallest size class is 64 bytes. class n holds chunks of at least (64 << n) bytes.
+#define YBUFFER_CACHE_MIN_CLASS_SHIFT 6
+
+// objects up to 256 bytes can live in slab pools. each refill takes about one page from arena.
+#define YBUFFER_SLAB_MAX_OBJECT_SIZE (YBUFFER_SLAB_CLASS_COUNT * _YBUFFER_ALLOC_ALIGN)
+#define YBUFFER_SLAB_PAGE_SIZE       4096
+
+// global buffers are spread over shards to avoid contention on one mutex.
+// each thread sticks to one shard. buffer records its shard in cookie.
+#define YBUFFER_GLOBAL_SHARD_COUNT 16
+#define YBUFFER_CACHE_LINE_SIZE    64
+#define YBUFFER_PAGE_SIZE          4096
+#define YBUFFER_HUGE_PAGE_SIZE     (2 * 1024 * 1024)
+
+// global pointers destroyed at thread clean up are kept in a growable array.
+#define YBUFFER_DEFERRED_MIN_CAPACITY 16
+
+// global buffer of the pointer of its first element.
+#define _YBUFFER_GLOBAL_POINTER_TO_BUFFER(p) \
+    ((ybuffer_t*)((char*)(p) - ybuffer_round_up(sizeof(ybuffer_cookie_t)) - sizeof(ybuffer_t)))
+
+typedef struct _ybuffer_global_shard_t {
+    pthread_mutex_t mutex;
+    ybuffer_t * chain;
+} __attribute__((aligned(YBUFFER_CACHE_LINE_SIZE))) ybuffer_global_shard_t;
+
 static pthread_key_t g_ybuffer_thread_key;
-static pthread_mutex_t g_ybuffer_global_buffer_mutex = PTHREAD_MUTEX_INITIALIZER;
-static ybool_t g_ybuffer_global_buffer_inited = yfalse;
+static ybuffer_global_shard_t g_ybuffer_global_shards[YBUFFER_GLOBAL_SHARD_COUNT];
+static ybool_t g_ybuffer_global_shards_created = yfalse;
+static volatile ybool_t g_ybuffer_global_buffer_inited = yfalse;
 static ybool_t g_ybuffer_inited = yfalse;
-static ybuffer_t * g_ybuffer_global_chain = NULL;
+static yuint32_t g_ybuffer_global_next_shard = 0;
+static ybuffer_stats_t g_ybuffer_stats;
+
+static yint32_t g_ybuffer_arena_chunk_size = YBUFFER_DEFAULT_ARENA_CHUNK_SIZE;
+static yint32_t g_ybuffer_arena_max_chunk_size = YBUFFER_DEFAULT_ARENA_MAX_CHUNK_SIZE;
+static yint32_t g_ybuffer_cache_max_bytes = YBUFFER_DEFAULT_CACHE_MAX_BYTES;
+static yint32_t g_ybuffer_cache_max_chunks = YBUFFER_DEFAULT_CACHE_MAX_CHUNKS;
+static yint32_t g_ybuffer_chunk_cache_line_align = YBUFFER_DEFAULT_CHUNK_CACHE_LINE_ALIGN;
+static yint32_t g_ybuffer_mmap_threshold = YBUFFER_DEFAULT_MMAP_THRESHOLD;
+static yint32_t g_ybuffer_mmap_huge_page = YBUFFER_DEFAULT_MMAP_HUGE_PAGE;
+static ysize_t g_ybuffer_page_size = YBUFFER_PAGE_SIZE;
+static yint32_t g_ybuffer_reclaim_mode = YBUFFER_RECLAIM_MODE_NONE;
+static yint32_t g_ybuffer_reclaim_threshold = YBUFFER_DEFAULT_RECLAIM_THRESHOLD;
+static yint32_t g_ybuffer_reclaim_epochs = YBUFFER_DEFAULT_RECLAIM_EPOCHS;
+
+// process-wide stats are only touched on chunk level operations.
+#define _YBUFFER_STATS_ADD(field, delta) __sync_add_and_fetch(&g_ybuffer_stats.field, (delta))
+#define _YBUFFER_STATS_SUB(field, delta) __sync_sub_and_fetch(&g_ybuffer_stats.field, (delta))
+#define _YBUFFER_STATS_READ(field) __sync_add_and_fetch(&g_ybuffer_stats.field, 0)
 
-static void _ybuffer_thread_clean_up(void * head)
+#define _YBUFFER_IS_POWER_OF_TWO(n) ((n) && !((n) & ((n) - 1)))
+#define _YBUFFER_ALIGN_UP(n, align) (((n) + (align) - 1) & ~((ysize_t)(align) - 1))
+
+static void _ybuffer_stats_update_peak(ysize_t * peak, ysize_t value)
 {
-    if (!head) {
-        YUKI_LOG_DEBUG("buffer chain is empty");
+    ysize_t old = *peak;
+
+    while (value > old && !__sync_bool_compare_and_swap(peak, old, value)) {
+        old = *peak;
+    }
+}
+
+/**
+ * add requested bytes of current thread to process stats.
+ */
+static void _ybuffer_stats_flush(ybuffer_thread_data_t * data)
+{
+    if (data->stats.requested_bytes > data->flushed_requested) {
+        _YBUFFER_STATS_ADD(requested_bytes, data->stats.requested_bytes - data->flushed_requested);
+    }
+
+    data->flushed_requested = data->stats.requested_bytes;
+}
+
+static void _ybuffer_stats_chunk_acquired(ybuffer_thread_data_t * data, ysize_t size)
+{
+    data->stats.reserved_bytes += size;
+    data->stats.chunk_count++;
+
+    if (data->stats.reserved_bytes > data->stats.peak_reserved_bytes) {
+        data->stats.peak_reserved_bytes = data->stats.reserved_bytes;
+    }
+
+    _ybuffer_stats_update_peak(&g_ybuffer_stats.peak_reserved_bytes, _YBUFFER_STATS_ADD(reserved_bytes, size));
+    _YBUFFER_STATS_ADD(chunk_count, 1);
+    _ybuffer_stats_flush(data);
+}
+
+static void _ybuffer_stats_chunk_released(ybuffer_thread_data_t * data, ysize_t size)
+{
+    data->stats.reserved_bytes -= size;
+    data->stats.chunk_count--;
+    _YBUFFER_STATS_SUB(reserved_bytes, size);
+    _YBUFFER_STATS_SUB(chunk_count, 1);
+}
+
+static void _ybuffer_stats_wasted(ybuffer_thread_data_t * data, ysize_t size)
+{
+    if (size) {
+        data->stats.wasted_bytes += size;
+        _YBUFFER_STATS_ADD(wasted_bytes, size);
+    }
+}
+
+/**
+ * return chunk memory to system.
+ */
+static void _ybuffer_chunk_free(ybuffer_t * buffer)
+{
+    if (buffer->flags & YBUFFER_FLAG_MMAP) {
+        munmap(buffer, sizeof(ybuffer_t) + buffer->size);
         return;
     }
 
-    ybuffer_t * buffer = (ybuffer_t*)head;
+    free(buffer);
+}
+
+/**
+ * free a chain owned by thread data.
+ */
+static void _ybuffer_chain_free(ybuffer_thread_data_t * data, ybuffer_t * buffer)
+{
     ybuffer_t * next = NULL;
 
     while (buffer) {
         next = buffer->next;
-        free(buffer);
+        _ybuffer_stats_chunk_released(data, buffer->size);
+        _ybuffer_chunk_free(buffer);
         buffer = next;
     }
 }
 
-static void _ybuffer_global_clean_up()
+static inline ysize_t _ybuffer_cache_class_size(yint32_t index)
+{
+    return (ysize_t)1 << (index + YBUFFER_CACHE_MIN_CLASS_SHIFT);
+}
+
+/**
+ * smallest size class which can hold size bytes.
+ * return -1 if size is too large.
+ */
+static yint32_t _ybuffer_cache_class_ceil(ysize_t size)
+{
+    yint32_t index = 0;
+
+    while (index < YBUFFER_CACHE_CLASS_COUNT && _ybuffer_cache_class_size(index) < size) {
+        index++;
+    }
+
+    return index < YBUFFER_CACHE_CLASS_COUNT? index: -1;
+}
+
+/**
+ * largest size class not larger than size.
+ * return -1 if size is too small.
+ */
+static yint32_t _ybuffer_cache_class_floor(ysize_t size)
+{
+    yint32_t index = -1;
+
+    while (index + 1 < YBUFFER_CACHE_CLASS_COUNT && _ybuffer_cache_class_size(index + 1) <= size) {
+        index++;
+    }
+
+    return index;
+}
+
+/**
+ * return a chunk to thread cache.
+ * chunk is freed if cache reaches its limits.
+ */
+static void _ybuffer_chunk_release(ybuffer_thread_data_t * data, ybuffer_t * buffer)
 {
-    if (!g_ybuffer_global_chain) {
-        YUKI_LOG_DEBUG("global buffer chain is empty");
+    yint32_t index = _ybuffer_cache_class_floor(buffer->size);
+    _ybuffer_stats_chunk_released(data, buffer->size);
+
+    if (index < 0 || data->cache_count[index] >= (yuint32_t)g_ybuffer_cache_max_chunks
+        || data->stats.cached_bytes + buffer->size > (ysize_t)g_ybuffer_cache_max_bytes) {
+        _ybuffer_chunk_free(buffer);
         return;
     }
 
-    // no matter sucess or not, clean up global buffer
-    pthread_mutex_lock(&g_ybuffer_global_buffer_mutex);
-    g_ybuffer_global_buffer_inited = yfalse;
-    pthread_mutex_unlock(&g_ybuffer_global_buffer_mutex);
+    buffer->next = data->cache[index];
+    data->cache[index] = buffer;
+    data->cache_count[index]++;
+    data->stats.cached_bytes += buffer->size;
+    _YBUFFER_STATS_ADD(cached_bytes, buffer->size);
+}
 
-    ybuffer_t * buffer = g_ybuffer_global_chain;
+static void _ybuffer_chain_release(ybuffer_thread_data_t * data, ybuffer_t * buffer)
+{
     ybuffer_t * next = NULL;
-    ybuffer_cookie_t * cookie = NULL;
 
     while (buffer) {
         next = buffer->next;
+        _ybuffer_chunk_release(data, buffer);
+        buffer = next;
+    }
+}
 
-        // destroy padding
-        YUKI_ASSERT(buffer->size >= ybuffer_round_up(sizeof(ybuffer_cookie_t)));
-        cookie = (ybuffer_cookie_t*)buffer->buffer;
-        cookie->padding = 0;
+static ybool_t _ybuffer_global_destroy(ybuffer_thread_data_t * data, ybuffer_t * buffer);
 
-        free(buffer);
-        buffer = next;
+/**
+ * destroy global pointers deferred by ybuffer_destroy_global_pointer_later().
+ * buffers dropped to 0 reference join thread chain and are released with it.
+ */
+static void _ybuffer_deferred_release(ybuffer_thread_data_t * data)
+{
+    yuint32_t index;
+
+    // global buffers are all freed on shutdown
+    if (g_ybuffer_global_buffer_inited) {
+        for (index = 0; index < data->deferred_count; index++) {
+            _ybuffer_global_destroy(data, _YBUFFER_GLOBAL_POINTER_TO_BUFFER(data->deferred[index]));
+        }
+    }
+
+    data->deferred_count = 0;
+}
+
+static void _ybuffer_thread_clean_up(void * thread_data)
+{
+    if (!thread_data) {
+        YUKI_LOG_DEBUG("buffer chain is empty");
+        return;
+    }
+
+    ybuffer_thread_data_t * data = (ybuffer_thread_data_t*)thread_data;
+    ybuffer_t * buffer = NULL;
+    ybuffer_t * next = NULL;
+    yint32_t index;
+
+    _ybuffer_deferred_release(data);
+    _ybuffer_stats_flush(data);
+    _ybuffer_chain_free(data, data->chain);
+
+    for (index = 0; index < YBUFFER_CACHE_CLASS_COUNT; index++) {
+        for (buffer = data->cache[index]; buffer; buffer = next) {
+            next = buffer->next;
+            _YBUFFER_STATS_SUB(cached_bytes, buffer->size);
+            _ybuffer_chunk_free(buffer);
+        }
     }
 
-    g_ybuffer_global_chain = NULL;
+    free(data->deferred);
+    free(data);
+}
+
+static void _ybuffer_global_clean_up()
+{
+    ybuffer_t * buffer = NULL;
+    ybuffer_t * next = NULL;
+    ybuffer_cookie_t * cookie = NULL;
+    ybuffer_global_shard_t * shard = NULL;
+    yuint32_t index;
+
+    // no matter sucess or not, clean up global buffer
+    for (index = 0; index < YBUFFER_GLOBAL_SHARD_COUNT; index++) {
+        pthread_mutex_lock(&g_ybuffer_global_shards[index].mutex);
+    }
+
+    g_ybuffer_global_buffer_inited = yfalse;
+
+    for (index = 0; index < YBUFFER_GLOBAL_SHARD_COUNT; index++) {
+        pthread_mutex_unlock(&g_ybuffer_global_shards[index].mutex);
+    }
+
+    for (index = 0; index < YBUFFER_GLOBAL_SHARD_COUNT; index++) {
+        shard = &g_ybuffer_global_shards[index];
+        buffer = shard->chain;
+
+        while (buffer) {
+            next = buffer->next;
+
+            // destroy padding
+            YUKI_ASSERT(buffer->size >= ybuffer_round_up(sizeof(ybuffer_cookie_t)));
+            cookie = (ybuffer_cookie_t*)buffer->buffer;
+            cookie->padding = 0;
+            _YBUFFER_STATS_SUB(global_pinned_bytes, buffer->size);
+
+            free(buffer);
+            buffer = next;
+        }
+
+        shard->chain = NULL;
+    }
 }
 
 static inline ybool_t ybuffer_inited()
@@ -65,80 +333,909 @@ static inline ybool_t ybuffer_inited()
     return g_ybuffer_inited;
 }
 
-static void _ybuffer_thread_chain_add(ybuffer_t * buffer)
-{
-    // add memory to free list
-    ybuffer_t * head = (ybuffer_t*)pthread_getspecific(g_ybuffer_thread_key);
+static inline ybool_t _ybuffer_arena_enabled()
+{
+    return g_ybuffer_arena_chunk_size > 0;
+}
+
+static ybuffer_thread_data_t * _ybuffer_thread_data()
+{
+    ybuffer_thread_data_t * data = (ybuffer_thread_data_t*)pthread_getspecific(g_ybuffer_thread_key);
+
+    if (data) {
+        return data;
+    }
+
+    data = (ybuffer_thread_data_t*)malloc(sizeof(ybuffer_thread_data_t));
+
+    if (!data) {
+        YUKI_LOG_FATAL("out of memory. [size: %lu]", sizeof(ybuffer_thread_data_t));
+        return NULL;
+    }
+
+    memset(data, 0, sizeof(ybuffer_thread_data_t));
+    data->next_chunk_size = g_ybuffer_arena_chunk_size;
+    data->global_shard = __sync_fetch_and_add(&g_ybuffer_global_next_shard, 1) % YBUFFER_GLOBAL_SHARD_COUNT;
+
+    int error = pthread_setspecific(g_ybuffer_thread_key, data);
+
+    if (error) {
+        YUKI_LOG_FATAL("cannot set thread data for ybuffer. [err: %d]", error);
+        free(data);
+        return NULL;
+    }
+
+    return data;
+}
+
+static ybool_t _ybuffer_thread_chain_add(ybuffer_thread_data_t * data, ybuffer_t * buffer)
+{
+    if (!data) {
+        return yfalse;
+    }
+
+    // newest chunk is always the head of chain
+    buffer->epoch = data->epoch;
+    buffer->next = data->chain;
+    data->chain = buffer;
+    return ytrue;
+}
+
+/**
+ * map a large chunk directly from system.
+ * mapping is rounded up to whole pages, or whole huge pages if mmap_huge_page is set.
+ */
+static ybuffer_t * _ybuffer_chunk_mmap(ysize_t size)
+{
+    ysize_t actual = _YBUFFER_ALIGN_UP(sizeof(ybuffer_t) + size, g_ybuffer_page_size);
+    ybool_t huge_page = g_ybuffer_mmap_huge_page && actual >= YBUFFER_HUGE_PAGE_SIZE;
+
+    if (huge_page) {
+        actual = _YBUFFER_ALIGN_UP(actual, YBUFFER_HUGE_PAGE_SIZE);
+    }
+
+    void * memory = mmap(NULL, actual, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (memory == MAP_FAILED) {
+        YUKI_LOG_FATAL("cannot map memory. [size: %lu] [actual: %lu] [err: %d]", size, actual, errno);
+        return NULL;
+    }
+
+#ifdef MADV_HUGEPAGE
+    // a hint only. kernel may not support transparent huge page.
+    if (huge_page && madvise(memory, actual, MADV_HUGEPAGE)) {
+        YUKI_LOG_DEBUG("cannot advise huge page. [err: %d]", errno);
+    }
+#endif
+
+    ybuffer_t * ptr = (ybuffer_t*)memory;
+    ptr->size = actual - sizeof(ybuffer_t);
+    ptr->offset = 0;
+    ptr->flags = YBUFFER_FLAG_MMAP;
+    return ptr;
+}
+
+/**
+ * allocate chunk memory from system. chunk may be larger than size.
+ */
+static ybuffer_t * _ybuffer_chunk_alloc(ysize_t size)
+{
+    ybuffer_t * ptr = NULL;
+
+    if (g_ybuffer_mmap_threshold && sizeof(ybuffer_t) + size >= (ysize_t)g_ybuffer_mmap_threshold) {
+        return _ybuffer_chunk_mmap(size);
+    }
+
+    if (g_ybuffer_chunk_cache_line_align) {
+        // chunk occupies whole cache lines so that it never shares a line with other threads' memory
+        ysize_t actual = _YBUFFER_ALIGN_UP(sizeof(ybuffer_t) + size, YBUFFER_CACHE_LINE_SIZE);
+        void * memory = NULL;
+
+        if (posix_memalign(&memory, YBUFFER_CACHE_LINE_SIZE, actual)) {
+            YUKI_LOG_FATAL("out of memory. [size: %lu] [actual: %lu]", size, actual);
+            return NULL;
+        }
+
+        ptr = (ybuffer_t*)memory;
+        size = actual - sizeof(ybuffer_t);
+    } else {
+        ptr = (ybuffer_t*)malloc(sizeof(ybuffer_t) + size);
+
+        if (!ptr) {
+            YUKI_LOG_FATAL("out of memory. [size: %lu] [actual: %lu]", size, sizeof(ybuffer_t) + size);
+            return NULL;
+        }
+    }
+
+    ptr->size = size;
+    ptr->offset = 0;
+    ptr->flags = 0;
+    return ptr;
+}
+
+/**
+ * allocate a raw chunk with given capacity and add it to thread chain.
+ */
+static ybuffer_t * _ybuffer_chunk_create(ysize_t size)
+{
+    ybuffer_thread_data_t * data = _ybuffer_thread_data();
+
+    if (!data) {
+        return NULL;
+    }
+
+    ybuffer_t * ptr = NULL;
+    yint32_t index = _ybuffer_cache_class_ceil(size);
+
+    if (index >= 0 && _ybuffer_cache_class_size(index) <= (ysize_t)g_ybuffer_cache_max_bytes) {
+        // round up to size class so that chunk can be reused by same request later
+        size = _ybuffer_cache_class_size(index);
+        ptr = data->cache[index];
+
+        if (ptr) {
+            data->cache[index] = ptr->next;
+            data->cache_count[index]--;
+            data->stats.cached_bytes -= ptr->size;
+            _YBUFFER_STATS_SUB(cached_bytes, ptr->size);
+
+            ptr->offset = 0;
+            ptr->epoch = data->epoch;
+            ptr->next = data->chain;
+            data->chain = ptr;
+            _ybuffer_stats_chunk_acquired(data, ptr->size);
+            return ptr;
+        }
+    }
+
+    ptr = _ybuffer_chunk_alloc(size);
+
+    if (!ptr) {
+        return NULL;
+    }
+
+    size = ptr->size;
+
+    ptr->epoch = data->epoch;
+    ptr->next = data->chain;
+    data->chain = ptr;
+    _ybuffer_stats_chunk_acquired(data, size);
+    return ptr;
+}
+
+/**
+ * bump allocate rounded size from thread arena.
+ * a new chunk is opened when active chunk is full. chunk size grows geometrically
+ * up to arena_max_chunk_size. request larger than next chunk gets a dedicated chunk
+ * and leaves active chunk untouched.
+ */
+static void * _ybuffer_arena_alloc(ysize_t size)
+{
+    ybuffer_thread_data_t * data = _ybuffer_thread_data();
+
+    if (!data) {
+        return NULL;
+    }
+
+    ybuffer_t * active = data->active;
+
+    data->stats.requested_bytes += size;
+
+    if (!active || active->offset + size > active->size) {
+        if (size > data->next_chunk_size) {
+            ybuffer_t * chunk = _ybuffer_chunk_create(size);
+
+            if (!chunk) {
+                return NULL;
+            }
+
+            chunk->offset = size;
+            _ybuffer_stats_wasted(data, chunk->size - size);
+            return chunk->buffer;
+        }
+
+        if (active) {
+            _ybuffer_stats_wasted(data, active->size - active->offset);
+        }
+
+        active = _ybuffer_chunk_create(data->next_chunk_size);
+
+        if (!active) {
+            return NULL;
+        }
+
+        data->active = active;
+
+        if (data->next_chunk_size < (ysize_t)g_ybuffer_arena_max_chunk_size) {
+            data->next_chunk_size *= 2;
+
+            if (data->next_chunk_size > (ysize_t)g_ybuffer_arena_max_chunk_size) {
+                data->next_chunk_size = g_ybuffer_arena_max_chunk_size;
+            }
+        }
+    }
+
+    char * ret = active->buffer + active->offset;
+    active->offset += size;
+    return (void *)ret;
+}
+
+/**
+ * carve size bytes of thread memory.
+ * memory comes from arena, or from a dedicated chunk if arena is disabled.
+ */
+static void * _ybuffer_carve(ysize_t size)
+{
+    if (_ybuffer_arena_enabled()) {
+        return _ybuffer_arena_alloc(size);
+    }
+
+    // chunk may be larger than requested. the rest is wasted.
+    ybuffer_thread_data_t * data = _ybuffer_thread_data();
+    ybuffer_t * chunk = _ybuffer_chunk_create(size);
+
+    if (!chunk) {
+        return NULL;
+    }
+
+    chunk->offset = size;
+    data->stats.requested_bytes += size;
+    _ybuffer_stats_wasted(data, chunk->size - chunk->offset);
+    return chunk->buffer;
+}
+
+ybool_t _ybuffer_init(config_t * config)
+{
+    if (ybuffer_inited()) {
+        return ytrue;
+    }
+
+    _YTABLE_CONFIG_INT_OPTIONAL(config, YBUFFER_CONFIG_PATH_ARENA_CHUNK_SIZE,
+        g_ybuffer_arena_chunk_size, YBUFFER_DEFAULT_ARENA_CHUNK_SIZE);
+    _YTABLE_CONFIG_INT_OPTIONAL(config, YBUFFER_CONFIG_PATH_ARENA_MAX_CHUNK_SIZE,
+        g_ybuffer_arena_max_chunk_size, YBUFFER_DEFAULT_ARENA_MAX_CHUNK_SIZE);
+
+    if (g_ybuffer_arena_chunk_size < 0 || g_ybuffer_arena_max_chunk_size < 0) {
+        YUKI_LOG_FATAL("arena chunk size must not be negative");
+        return yfalse;
+    }
+
+    g_ybuffer_arena_chunk_size = ybuffer_round_up(g_ybuffer_arena_chunk_size);
+
+    _YTABLE_CONFIG_INT_OPTIONAL(config, YBUFFER_CONFIG_PATH_CACHE_MAX_BYTES,
+        g_ybuffer_cache_max_bytes, YBUFFER_DEFAULT_CACHE_MAX_BYTES);
+    _YTABLE_CONFIG_INT_OPTIONAL(config, YBUFFER_CONFIG_PATH_CACHE_MAX_CHUNKS,
+        g_ybuffer_cache_max_chunks, YBUFFER_DEFAULT_CACHE_MAX_CHUNKS);
+
+    if (g_ybuffer_cache_max_bytes < 0 || g_ybuffer_cache_max_chunks < 0) {
+        YUKI_LOG_FATAL("chunk cache limits must not be negative");
+        return yfalse;
+    }
+
+    _YTABLE_CONFIG_INT_OPTIONAL(config, YBUFFER_CONFIG_PATH_CHUNK_CACHE_LINE_ALIGN,
+        g_ybuffer_chunk_cache_line_align, YBUFFER_DEFAULT_CHUNK_CACHE_LINE_ALIGN);
+    _YTABLE_CONFIG_INT_OPTIONAL(config, YBUFFER_CONFIG_PATH_MMAP_THRESHOLD,
+        g_ybuffer_mmap_threshold, YBUFFER_DEFAULT_MMAP_THRESHOLD);
+    _YTABLE_CONFIG_INT_OPTIONAL(config, YBUFFER_CONFIG_PATH_MMAP_HUGE_PAGE,
+        g_ybuffer_mmap_huge_page, YBUFFER_DEFAULT_MMAP_HUGE_PAGE);
+
+    if (g_ybuffer_mmap_threshold < 0) {
+        YUKI_LOG_FATAL("mmap threshold must not be negative");
+        return yfalse;
+    }
+
+    const char * reclaim_mode = NULL;
+    _YTABLE_CONFIG_STRING_OPTIONAL(config, YBUFFER_CONFIG_PATH_RECLAIM_MODE,
+        reclaim_mode, YBUFFER_DEFAULT_RECLAIM_MODE);
+
+    if (!strcmp(reclaim_mode, "none")) {
+        g_ybuffer_reclaim_mode = YBUFFER_RECLAIM_MODE_NONE;
+    } else if (!strcmp(reclaim_mode, "threshold")) {
+        g_ybuffer_reclaim_mode = YBUFFER_RECLAIM_MODE_THRESHOLD;
+    } else if (!strcmp(reclaim_mode, "epoch")) {
+        g_ybuffer_reclaim_mode = YBUFFER_RECLAIM_MODE_EPOCH;
+    } else {
+        YUKI_LOG_FATAL("invalid reclaim mode '%s'", reclaim_mode);
+        return yfalse;
+    }
+
+    _YTABLE_CONFIG_INT_OPTIONAL(config, YBUFFER_CONFIG_PATH_RECLAIM_THRESHOLD,
+        g_ybuffer_reclaim_threshold, YBUFFER_DEFAULT_RECLAIM_THRESHOLD);
+    _YTABLE_CONFIG_INT_OPTIONAL(config, YBUFFER_CONFIG_PATH_RECLAIM_EPOCHS,
+        g_ybuffer_reclaim_epochs, YBUFFER_DEFAULT_RECLAIM_EPOCHS);
+
+    if (g_ybuffer_reclaim_threshold < 0 || g_ybuffer_reclaim_epochs < 1) {
+        YUKI_LOG_FATAL("reclaim threshold must not be negative and reclaim epochs must be positive");
+        return yfalse;
+    }
+
+    long page_size = sysconf(_SC_PAGESIZE);
+    g_ybuffer_page_size = page_size > 0? (ysize_t)page_size: YBUFFER_PAGE_SIZE;
+
+    if (g_ybuffer_arena_max_chunk_size < g_ybuffer_arena_chunk_size) {
+        YUKI_LOG_WARNING("arena_max_chunk_size is less than arena_chunk_size. use arena_chunk_size instead");
+        g_ybuffer_arena_max_chunk_size = g_ybuffer_arena_chunk_size;
+    }
+
+    int error = 0;
+    yuint32_t index;
+
+    if (!g_ybuffer_global_shards_created) {
+        for (index = 0; index < YBUFFER_GLOBAL_SHARD_COUNT; index++) {
+            error = pthread_mutex_init(&g_ybuffer_global_shards[index].mutex, NULL);
+
+            if (error) {
+                YUKI_LOG_FATAL("cannot create mutex for global buffer. [err: %d]", error);
+                return yfalse;
+            }
+
+            g_ybuffer_global_shards[index].chain = NULL;
+        }
+
+        g_ybuffer_global_shards_created = ytrue;
+    }
+
+    error = pthread_key_create(&g_ybuffer_thread_key, &_ybuffer_thread_clean_up);
+
+    if (error) {
+        YUKI_LOG_FATAL("cannot create thread key for ybuffer. [err: %d]", error);
+        return yfalse;
+    }
+
+    g_ybuffer_global_buffer_inited = ytrue;
+    g_ybuffer_inited = ytrue;
+    return ytrue;
+}
+
+void _ybuffer_clean_up()
+{
+    if (!ybuffer_inited()) {
+        return;
+    }
+
+    ybuffer_thread_data_t * data = (ybuffer_thread_data_t*)pthread_getspecific(g_ybuffer_thread_key);
+
+    if (!data) {
+        YUKI_LOG_DEBUG("buffer chain is empty");
+        return;
+    }
+
+    if (data->active) {
+        _ybuffer_stats_wasted(data, data->active->size - data->active->offset);
+    }
+
+    _ybuffer_deferred_release(data);
+
+    // chunks are kept in thread cache for next request
+    _ybuffer_chain_release(data, data->chain);
+    _ybuffer_stats_flush(data);
+    memset(data->slabs, 0, sizeof(data->slabs));
+    data->detaching = yfalse;
+    data->chain = NULL;
+    data->active = NULL;
+    data->next_chunk_size = g_ybuffer_arena_chunk_size;
+}
+
+void _ybuffer_shutdown()
+{
+    if (!ybuffer_inited()) {
+        return;
+    }
+
+    _ybuffer_global_clean_up();
+
+    // other threads release their data when they exit
+    void * data = pthread_getspecific(g_ybuffer_thread_key);
+    pthread_setspecific(g_ybuffer_thread_key, NULL);
+    _ybuffer_thread_clean_up(data);
+
+    g_ybuffer_inited = yfalse;
+}
+
+/**
+ * create a managed buffer.
+ * buffer is carved from thread arena unless arena is disabled
+ * by setting arena_chunk_size to 0.
+ * @note
+ * this buffer is available in current thread.
+ * do NEVER use it cross thread.
+ */
+ybuffer_t * ybuffer_create(ysize_t size)
+{
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return NULL;
+    }
+
+    ysize_t rounded = ybuffer_round_up(size);
+    ybuffer_t * ptr = (ybuffer_t*)_ybuffer_carve(sizeof(ybuffer_t) + rounded);
+
+    if (!ptr) {
+        return NULL;
+    }
+
+    // sub-buffer is not linked to thread chain. its memory is owned by a chunk.
+    ptr->size = rounded;
+    ptr->offset = 0;
+    ptr->flags = 0;
+    ptr->next = NULL;
+    return ptr;
+}
+
+/**
+ * create a managed buffer whose first byte is aligned to align.
+ * align must be a power of two. buffer can hold size bytes
+ * allocated by ybuffer_alloc_aligned() with same align.
+ * @note
+ * this buffer is available in current thread.
+ * do NEVER use it cross thread.
+ */
+ybuffer_t * ybuffer_create_aligned(ysize_t size, ysize_t align)
+{
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return NULL;
+    }
+
+    if (!_YBUFFER_IS_POWER_OF_TWO(align)) {
+        YUKI_LOG_FATAL("invalid param");
+        return NULL;
+    }
+
+    if (align <= _YBUFFER_ALLOC_ALIGN) {
+        return ybuffer_create(size);
+    }
+
+    // reserve enough padding to slide header forward until buffer is aligned
+    ysize_t rounded = ybuffer_round_up(size);
+    ysize_t reserved = sizeof(ybuffer_t) + align - _YBUFFER_ALLOC_ALIGN + rounded;
+    char * memory = (char *)_ybuffer_carve(reserved);
+
+    if (!memory) {
+        return NULL;
+    }
+
+    ysize_t address = _YBUFFER_ALIGN_UP((ysize_t)memory + sizeof(ybuffer_t), align);
+    ybuffer_t * ptr = (ybuffer_t*)(address - sizeof(ybuffer_t));
+    YUKI_ASSERT(ptr->buffer + rounded <= memory + reserved);
+
+    ptr->size = rounded;
+    ptr->offset = 0;
+    ptr->flags = 0;
+    ptr->next = NULL;
+    return ptr;
+}
+
+/**
+ * allocate a fixed-size object from thread slab pool.
+ * objects of same size are packed in arena pages and reused thru ybuffer_slab_free().
+ * memory is available in current thread until yuki_clean_up() is called.
+ */
+void * ybuffer_slab_alloc(ysize_t size)
+{
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return NULL;
+    }
+
+    ysize_t rounded = ybuffer_round_up(size);
+
+    if (!rounded || rounded > YBUFFER_SLAB_MAX_OBJECT_SIZE) {
+        return ybuffer_simple_alloc(size);
+    }
+
+    ybuffer_thread_data_t * data = _ybuffer_thread_data();
+
+    if (!data) {
+        return NULL;
+    }
+
+    // slab pages are not moved by ybuffer_detach(). bypass them.
+    if (data->detaching) {
+        return ybuffer_simple_alloc(size);
+    }
+
+    ybuffer_slab_t * slab = &data->slabs[rounded / _YBUFFER_ALLOC_ALIGN - 1];
+    void * ret = slab->free_list;
+
+    if (ret) {
+        slab->free_list = *(void **)ret;
+        return ret;
+    }
+
+    if (slab->cursor + rounded > slab->end) {
+        ysize_t page_size = (YBUFFER_SLAB_PAGE_SIZE / rounded) * rounded;
+        char * page = (char *)ybuffer_simple_alloc(page_size);
+
+        if (!page) {
+            return NULL;
+        }
+
+        slab->cursor = page;
+        slab->end = page + page_size;
+    }
+
+    ret = slab->cursor;
+    slab->cursor += rounded;
+    return ret;
+}
+
+/**
+ * return an object to thread slab pool.
+ * pointer must be allocated by ybuffer_slab_alloc() with same size in current thread.
+ */
+void ybuffer_slab_free(void * pointer, ysize_t size)
+{
+    if (!pointer) {
+        return;
+    }
+
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return;
+    }
+
+    ysize_t rounded = ybuffer_round_up(size);
+
+    if (!rounded || rounded > YBUFFER_SLAB_MAX_OBJECT_SIZE) {
+        return;
+    }
+
+    ybuffer_thread_data_t * data = _ybuffer_thread_data();
+
+    if (!data || data->detaching) {
+        return;
+    }
+
+    ybuffer_slab_t * slab = &data->slabs[rounded / _YBUFFER_ALLOC_ALIGN - 1];
+    *(void **)pointer = slab->free_list;
+    slab->free_list = pointer;
+}
+
+/**
+ * save current state of thread buffer.
+ * all memory allocated in current thread after this call can be released
+ * by ybuffer_rewind() with the same mark.
+ */
+ybool_t ybuffer_mark(ybuffer_mark_t * mark)
+{
+    if (!mark) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return yfalse;
+    }
+
+    ybuffer_thread_data_t * data = _ybuffer_thread_data();
+
+    if (!data) {
+        return yfalse;
+    }
+
+    mark->chain = data->chain;
+    mark->active = data->active;
+    mark->offset = data->active? data->active->offset: 0;
+    mark->next_chunk_size = data->next_chunk_size;
+    return ytrue;
+}
+
+/**
+ * release all memory allocated in current thread since mark was made.
+ * released chunks are returned to thread cache for reuse.
+ * slab pools are emptied as well. objects freed to slab before the mark
+ * are not reused until yuki_clean_up().
+ * @note
+ * global buffers destroyed after the mark live in thread chain
+ * and are released as well.
+ * rewinding cancels pending ybuffer_detach_begin().
+ * mark becomes invalid after yuki_clean_up() or rewinding to an earlier mark.
+ */
+ybool_t ybuffer_rewind(const ybuffer_mark_t * mark)
+{
+    if (!mark) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return yfalse;
+    }
+
+    ybuffer_thread_data_t * data = _ybuffer_thread_data();
+
+    if (!data) {
+        return yfalse;
+    }
+
+    ybuffer_t * buffer = data->chain;
+
+    // mark must point to a chunk in current chain
+    while (buffer != mark->chain) {
+        if (!buffer) {
+            YUKI_LOG_WARNING("mark is not made in current thread or is out of date");
+            return yfalse;
+        }
+
+        buffer = buffer->next;
+    }
+
+    if (mark->active) {
+        buffer = mark->chain;
+
+        while (buffer && buffer != mark->active) {
+            buffer = buffer->next;
+        }
+
+        if (!buffer) {
+            YUKI_LOG_WARNING("active chunk of mark is out of date");
+            return yfalse;
+        }
+    }
+
+    ybuffer_t * next = NULL;
+    buffer = data->chain;
+
+    while (buffer != mark->chain) {
+        next = buffer->next;
+        _ybuffer_chunk_release(data, buffer);
+        buffer = next;
+    }
+
+    data->chain = mark->chain;
+    data->active = mark->active;
+    data->next_chunk_size = mark->next_chunk_size;
+
+    // chunk of an earlier epoch must not take new allocation
+    if (data->active && data->active->epoch != data->epoch) {
+        data->active = NULL;
+    }
+
+    // slab objects may live in released chunks. drop all of them.
+    memset(data->slabs, 0, sizeof(data->slabs));
+    data->detaching = yfalse;
+
+    if (mark->active) {
+        mark->active->offset = mark->offset;
+    }
+
+    return ytrue;
+}
+
+/**
+ * start collecting memory which will be handed to another thread.
+ * all memory allocated in current thread after this call lives in new chunks,
+ * which are unlinked by ybuffer_detach() with the same mark.
+ * e.g.
+ * ybuffer_mark_t mark;
+ * ybuffer_t * chain;
+ * ybuffer_detach_begin(&mark);
+ * ytable_fetch_one(ytable, result);
+ * ybuffer_detach(&mark, &chain);
+ * // pass result and chain to a worker thread, which calls ybuffer_adopt(chain).
+ */
+ybool_t ybuffer_detach_begin(ybuffer_mark_t * mark)
+{
+    if (!ybuffer_mark(mark)) {
+        return yfalse;
+    }
+
+    ybuffer_thread_data_t * data = _ybuffer_thread_data();
+
+    if (data->detaching) {
+        YUKI_LOG_WARNING("ybuffer_detach_begin() cannot be nested");
+        return yfalse;
+    }
+
+    // active chunk is kept by current thread. following allocation opens a new chunk.
+    if (data->active) {
+        _ybuffer_stats_wasted(data, data->active->size - data->active->offset);
+    }
+
+    data->active = NULL;
+    data->detaching = ytrue;
+    return ytrue;
+}
+
+/**
+ * unlink chunks allocated since ybuffer_detach_begin() from thread chain.
+ * chunks are returned in chain. chain is NULL if nothing is allocated.
+ * current thread continues bump allocation in the chunk active before the mark,
+ * and next chunk is sized as if the window were never opened.
+ * @note
+ * chain is owned by nobody until ybuffer_adopt() is called.
+ * memory in chain MUST NOT be used by current thread any more.
+ */
+ybool_t ybuffer_detach(const ybuffer_mark_t * mark, ybuffer_t ** chain)
+{
+    if (!mark || !chain) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return yfalse;
+    }
+
+    ybuffer_thread_data_t * data = _ybuffer_thread_data();
+
+    if (!data) {
+        return yfalse;
+    }
+
+    if (!data->detaching) {
+        YUKI_LOG_WARNING("ybuffer_detach_begin() is not called");
+        return yfalse;
+    }
+
+    ybuffer_t * buffer = data->chain;
+    ybuffer_t * last = NULL;
+
+    while (buffer != mark->chain) {
+        if (!buffer) {
+            YUKI_LOG_WARNING("mark is not made in current thread or is out of date");
+            return yfalse;
+        }
+
+        _ybuffer_stats_chunk_released(data, buffer->size);
+        last = buffer;
+        buffer = buffer->next;
+    }
+
+    if (last) {
+        last->next = NULL;
+        *chain = data->chain;
+    } else {
+        *chain = NULL;
+    }
+
+    data->chain = mark->chain;
+    data->active = mark->active;
+    data->detaching = yfalse;
+
+    // chunks grown inside the window are gone. growth starts over from the size at mark.
+    data->next_chunk_size = mark->next_chunk_size;
+
+    if (mark->active) {
+        YUKI_ASSERT(mark->active->offset == mark->offset);
+    }
+
+    return ytrue;
+}
+
+/**
+ * take ownership of a chain detached by ybuffer_detach() in any thread.
+ * chunks are linked to current thread chain and released
+ * by yuki_clean_up() in current thread.
+ */
+ybool_t ybuffer_adopt(ybuffer_t * chain)
+{
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return yfalse;
+    }
+
+    ybuffer_thread_data_t * data = _ybuffer_thread_data();
+
+    if (!data) {
+        return yfalse;
+    }
+
+    ybuffer_t * next = NULL;
 
-    if (head) {
-        buffer->next = head->next;
-        head->next = buffer;
-    } else {
-        buffer->next = NULL;
-        pthread_setspecific(g_ybuffer_thread_key, buffer);
+    while (chain) {
+        next = chain->next;
+        chain->epoch = data->epoch;
+        chain->next = data->chain;
+        data->chain = chain;
+        _ybuffer_stats_chunk_acquired(data, chain->size);
+        chain = next;
     }
+
+    return ytrue;
 }
 
-ybool_t _ybuffer_init(config_t * config)
+/**
+ * tell ybuffer that no thread memory of current thread is in use.
+ * if reclaim_mode is not "none" and reserved bytes of current thread exceed
+ * reclaim_threshold, all thread memory is released as yuki_clean_up() does.
+ * @note
+ * ybuffer never calls it by itself. caller must make sure nothing allocated
+ * in current thread is still used, e.g. a ytable_t got from ytable_instance().
+ * it does nothing while a ybuffer_detach_begin() is pending.
+ */
+ybool_t ybuffer_safe_point()
 {
-    (void)config;
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return yfalse;
+    }
 
-    if (ybuffer_inited()) {
+    if (g_ybuffer_reclaim_mode == YBUFFER_RECLAIM_MODE_NONE) {
         return ytrue;
     }
 
-    int error = pthread_key_create(&g_ybuffer_thread_key, &_ybuffer_thread_clean_up);
+    ybuffer_thread_data_t * data = (ybuffer_thread_data_t*)pthread_getspecific(g_ybuffer_thread_key);
 
-    if (error) {
-        YUKI_LOG_FATAL("cannot create thread key for ybuffer. [err: %d]", error);
-        return yfalse;
+    if (!data || data->detaching || data->stats.reserved_bytes <= (ysize_t)g_ybuffer_reclaim_threshold) {
+        return ytrue;
     }
 
-    g_ybuffer_global_buffer_inited = ytrue;
-    g_ybuffer_inited = ytrue;
+    YUKI_LOG_DEBUG("reclaim thread memory at safe point. [reserved: %lu]", data->stats.reserved_bytes);
+    _ybuffer_clean_up();
     return ytrue;
 }
 
-void _ybuffer_clean_up()
-{
-    ybuffer_t * head = (ybuffer_t*)pthread_getspecific(g_ybuffer_thread_key);
-    pthread_setspecific(g_ybuffer_thread_key, NULL);
-    _ybuffer_thread_clean_up(head);
-}
-
-void _ybuffer_shutdown()
-{
-    _ybuffer_global_clean_up();
-    g_ybuffer_inited = yfalse;
-}
-
 /**
- * create a managed buffer.
+ * start a new epoch in current thread if reclaim_mode is "epoch".
+ * caller declares that memory allocated more than reclaim_epochs epochs ago is not in use.
+ * such chunks are released if reserved bytes of current thread exceed reclaim_threshold.
+ * e.g. with default reclaim_epochs 1, a server calling it after every request
+ * keeps memory of current and previous request only.
  * @note
- * this buffer is available in current thread.
- * do NEVER use it cross thread.
+ * ybuffer never advances epoch by itself. caller must make sure no live object,
+ * e.g. a ytable_t got from ytable_instance(), is allocated in an expired epoch.
+ * marks made before released chunks become invalid.
+ * use yvar_pin() or ytable_pin() to keep data across epochs.
  */
-ybuffer_t * ybuffer_create(ysize_t size)
+ybool_t ybuffer_epoch_advance()
 {
     if (!g_ybuffer_inited) {
         YUKI_LOG_FATAL("ybuffer is not init-ed");
-        return NULL;
+        return yfalse;
     }
 
-    ysize_t rounded = ybuffer_round_up(size);
-    ybuffer_t * ptr = (ybuffer_t*)malloc(sizeof(ybuffer_t) + rounded);
+    if (g_ybuffer_reclaim_mode != YBUFFER_RECLAIM_MODE_EPOCH) {
+        return ytrue;
+    }
 
-    if (!ptr) {
-        YUKI_LOG_FATAL("out of memory. [size: %lu] [actual: %lu]", size, sizeof(ybuffer_t) + rounded);
-        return NULL;
+    ybuffer_thread_data_t * data = (ybuffer_thread_data_t*)pthread_getspecific(g_ybuffer_thread_key);
+
+    // detaching chunks must stay in chain until ybuffer_detach()
+    if (!data || data->detaching) {
+        return ytrue;
     }
 
-    ptr->size = rounded;
-    ptr->offset = 0;
+    data->epoch++;
+
+    // chunks never mix epochs. next allocation opens a new chunk.
+    if (data->active) {
+        _ybuffer_stats_wasted(data, data->active->size - data->active->offset);
+        data->active = NULL;
+    }
 
-    _ybuffer_thread_chain_add(ptr);
+    if (data->stats.reserved_bytes <= (ysize_t)g_ybuffer_reclaim_threshold) {
+        return ytrue;
+    }
 
-    return ptr;
+    // chain is ordered by epoch. find first expired chunk and release the rest.
+    ybuffer_t * buffer = data->chain;
+    ybuffer_t * prev = NULL;
+
+    while (buffer && data->epoch - buffer->epoch <= (yuint32_t)g_ybuffer_reclaim_epochs) {
+        prev = buffer;
+        buffer = buffer->next;
+    }
+
+    if (!buffer) {
+        return ytrue;
+    }
+
+    if (prev) {
+        prev->next = NULL;
+    } else {
+        data->chain = NULL;
+    }
+
+    _ybuffer_chain_release(data, buffer);
+    _ybuffer_stats_flush(data);
+
+    // slab objects may live in released chunks. drop all of them.
+    memset(data->slabs, 0, sizeof(data->slabs));
+    return ytrue;
 }
 
 /**
@@ -156,6 +1253,12 @@ ybuffer_t * ybuffer_create_global(ysize_t size)
         return NULL;
     }
 
+    ybuffer_thread_data_t * data = _ybuffer_thread_data();
+
+    if (!data) {
+        return NULL;
+    }
+
     ysize_t rounded = ybuffer_round_up(size);
     ysize_t cookie_size = ybuffer_round_up(sizeof(ybuffer_cookie_t));
     ybuffer_t * ptr = (ybuffer_t*)malloc(sizeof(ybuffer_t) + cookie_size + rounded);
@@ -168,10 +1271,15 @@ ybuffer_t * ybuffer_create_global(ysize_t size)
     // first element in buffer is the pointer points to previous buffer.
     ptr->size = rounded + cookie_size;
     ptr->offset = cookie_size;
+    ptr->flags = 0;
     ybuffer_cookie_t * cookie = (ybuffer_cookie_t*)ptr->buffer;
     cookie->padding = YBUFFER_COOKIE_PADDING;
+    cookie->shard = data->global_shard;
+    cookie->refs = 1;
+    cookie->prev = NULL;
 
-    int ret = pthread_mutex_lock(&g_ybuffer_global_buffer_mutex);
+    ybuffer_global_shard_t * shard = &g_ybuffer_global_shards[cookie->shard];
+    int ret = pthread_mutex_lock(&shard->mutex);
 
     if (ret) {
         YUKI_LOG_FATAL("cannot wait global buffer mutex. [err: %d]", ret);
@@ -180,28 +1288,24 @@ ybuffer_t * ybuffer_create_global(ysize_t size)
     }
 
     if (!g_ybuffer_global_buffer_inited) {
+        pthread_mutex_unlock(&shard->mutex);
         YUKI_LOG_TRACE("cannot create global buffer as ybuffer is shutting down");
         free(ptr);
         return NULL;
     }
 
-    // add memory to global free list
-    if (g_ybuffer_global_chain) {
-        ptr->next = g_ybuffer_global_chain->next;
-
-        if (ptr->next) {
-            ((ybuffer_cookie_t*)ptr->next->buffer)->prev = ptr;
-        }
+    // add memory to head of shard chain
+    ptr->next = shard->chain;
 
-        g_ybuffer_global_chain->next = ptr;
-        cookie->prev = g_ybuffer_global_chain;
-    } else {
-        ptr->next = NULL;
-        cookie->prev = NULL;
-        g_ybuffer_global_chain = ptr;
+    if (ptr->next) {
+        ((ybuffer_cookie_t*)ptr->next->buffer)->prev = ptr;
     }
 
-    pthread_mutex_unlock(&g_ybuffer_global_buffer_mutex);
+    shard->chain = ptr;
+    pthread_mutex_unlock(&shard->mutex);
+
+    _ybuffer_stats_update_peak(&g_ybuffer_stats.peak_global_pinned_bytes,
+        _YBUFFER_STATS_ADD(global_pinned_bytes, ptr->size));
 
     return ptr;
 }
@@ -226,10 +1330,107 @@ void * ybuffer_alloc(ybuffer_t * buffer, ysize_t size)
     return (void *)ret;
 }
 
+/**
+ * allocate memory from buffer and align it to align.
+ * align must be a power of two. padding bytes are consumed from buffer.
+ */
+void * ybuffer_alloc_aligned(ybuffer_t * buffer, ysize_t size, ysize_t align)
+{
+    if (!buffer || !_YBUFFER_IS_POWER_OF_TWO(align)) {
+        YUKI_LOG_FATAL("invalid param");
+        return NULL;
+    }
+
+    if (align <= _YBUFFER_ALLOC_ALIGN) {
+        return ybuffer_alloc(buffer, size);
+    }
+
+    ysize_t rounded = ybuffer_round_up(size);
+    ysize_t address = (ysize_t)(buffer->buffer + buffer->offset);
+    ysize_t padding = _YBUFFER_ALIGN_UP(address, align) - address;
+
+    if (buffer->offset + padding + rounded > buffer->size) {
+        YUKI_LOG_FATAL("not enough memory in buffer pool");
+        return NULL;
+    }
+
+    char * ret = buffer->buffer + buffer->offset + padding;
+    buffer->offset += padding + rounded;
+    return (void *)ret;
+}
+
+/**
+ * allocate memory from thread arena.
+ * memory is available in current thread until yuki_clean_up() is called.
+ */
 void * ybuffer_simple_alloc(ysize_t size)
 {
-    ybuffer_t * buffer = ybuffer_create(size);
-    return ybuffer_alloc(buffer, size);
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return NULL;
+    }
+
+    return _ybuffer_carve(ybuffer_round_up(size));
+}
+
+/**
+ * whether small buffers are bump allocated from thread arena.
+ * if so, many ybuffer_simple_alloc() calls cost no more than one big call.
+ */
+ybool_t ybuffer_arena_enabled()
+{
+    return _ybuffer_arena_enabled();
+}
+
+/**
+ * resize memory allocated by ybuffer_simple_alloc() in place.
+ * it works only if pointer is the latest allocation in thread arena and arena has enough room.
+ * if it returns yfalse, memory is not changed and pointer is still valid.
+ */
+ybool_t ybuffer_simple_resize(void * pointer, ysize_t old_size, ysize_t new_size)
+{
+    if (!pointer) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return yfalse;
+    }
+
+    if (!_ybuffer_arena_enabled()) {
+        return yfalse;
+    }
+
+    ybuffer_thread_data_t * data = _ybuffer_thread_data();
+
+    if (!data || !data->active) {
+        return yfalse;
+    }
+
+    ybuffer_t * active = data->active;
+    old_size = ybuffer_round_up(old_size);
+    new_size = ybuffer_round_up(new_size);
+
+    if ((char *)pointer + old_size != active->buffer + active->offset) {
+        YUKI_LOG_DEBUG("pointer is not the latest allocation");
+        return yfalse;
+    }
+
+    ysize_t offset = active->offset - old_size;
+
+    if (offset + new_size > active->size) {
+        YUKI_LOG_DEBUG("no room in active chunk");
+        return yfalse;
+    }
+
+    if (new_size > old_size) {
+        data->stats.requested_bytes += new_size - old_size;
+    }
+
+    active->offset = offset + new_size;
+    return ytrue;
 }
 
 ysize_t ybuffer_available_size(const ybuffer_t * buffer)
@@ -243,16 +1444,11 @@ ysize_t ybuffer_available_size(const ybuffer_t * buffer)
 }
 
 /**
- * remove a global buffer from global chain
- * and add it to thread chain.
+ * drop one reference of a global buffer.
+ * last reference removes buffer from global chain and adds it to chain of given thread data.
  */
-ybool_t ybuffer_destroy_global(ybuffer_t * buffer)
+static ybool_t _ybuffer_global_destroy(ybuffer_thread_data_t * data, ybuffer_t * buffer)
 {
-    if (!buffer) {
-        YUKI_LOG_FATAL("invalid buffer pool");
-        return yfalse;
-    }
-
     ybuffer_cookie_t * cookie = (ybuffer_cookie_t*)buffer->buffer;
 
     if (YBUFFER_COOKIE_PADDING != cookie->padding) {
@@ -260,7 +1456,22 @@ ybool_t ybuffer_destroy_global(ybuffer_t * buffer)
         return yfalse;
     }
 
-    int ret = pthread_mutex_lock(&g_ybuffer_global_buffer_mutex);
+    // shard is set before buffer is published in a chain and never changes afterwards.
+    // it must be read before locking as it tells which mutex to lock.
+    yuint32_t shard_index = cookie->shard;
+
+    if (shard_index >= YBUFFER_GLOBAL_SHARD_COUNT) {
+        YUKI_LOG_WARNING("try to destroy a global buffer with invalid shard. [shard: %u]", shard_index);
+        return yfalse;
+    }
+
+    // buffer is still shared by others
+    if (__sync_sub_and_fetch(&cookie->refs, 1)) {
+        return ytrue;
+    }
+
+    ybuffer_global_shard_t * shard = &g_ybuffer_global_shards[shard_index];
+    int ret = pthread_mutex_lock(&shard->mutex);
 
     if (ret) {
         YUKI_LOG_FATAL("cannot lock global buffer mutex. [err: %d]", ret);
@@ -269,11 +1480,12 @@ ybool_t ybuffer_destroy_global(ybuffer_t * buffer)
 
     if (YBUFFER_COOKIE_PADDING != cookie->padding) {
         YUKI_LOG_DEBUG("current buffer is destroyed by other thread");
-        pthread_mutex_unlock(&g_ybuffer_global_buffer_mutex);
+        pthread_mutex_unlock(&shard->mutex);
         return ytrue;
     }
 
     if (!g_ybuffer_global_buffer_inited) {
+        pthread_mutex_unlock(&shard->mutex);
         YUKI_LOG_TRACE("cannot destroy buffer as ybuffer is shutting down");
         return yfalse;
     }
@@ -289,15 +1501,42 @@ ybool_t ybuffer_destroy_global(ybuffer_t * buffer)
     if (prev) {
         prev->next = next;
     } else {
-        g_ybuffer_global_chain = next;
+        shard->chain = next;
+    }
+
+    pthread_mutex_unlock(&shard->mutex);
+    _YBUFFER_STATS_SUB(global_pinned_bytes, buffer->size);
+
+    if (!_ybuffer_thread_chain_add(data, buffer)) {
+        YUKI_LOG_WARNING("cannot move global buffer to thread chain. memory is leaked");
+        return ytrue;
     }
 
-    pthread_mutex_unlock(&g_ybuffer_global_buffer_mutex);
+    _ybuffer_stats_chunk_acquired(data, buffer->size);
 
-    _ybuffer_thread_chain_add(buffer);
     return ytrue;
 }
 
+/**
+ * remove a global buffer from global chain
+ * and add it to thread chain.
+ * if buffer is shared thru ybuffer_retain_global_pointer(), only one reference is dropped.
+ */
+ybool_t ybuffer_destroy_global(ybuffer_t * buffer)
+{
+    if (!buffer) {
+        YUKI_LOG_FATAL("invalid buffer pool");
+        return yfalse;
+    }
+
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return yfalse;
+    }
+
+    return _ybuffer_global_destroy(_ybuffer_thread_data(), buffer);
+}
+
 /**
  * destroy buffer through the pointer of first element allocated in global buffer.
  * it's typically used by yvar_unpin() to unpin a pinned yvar.
@@ -309,6 +1548,143 @@ ybool_t ybuffer_destroy_global_pointer(void * pointer)
         return yfalse;
     }
 
-    ybuffer_t * buffer = (ybuffer_t*)((char*)pointer - ybuffer_round_up(sizeof(ybuffer_cookie_t)) - sizeof(ybuffer_t));
-    return ybuffer_destroy_global(buffer);
+    return ybuffer_destroy_global(_YBUFFER_GLOBAL_POINTER_TO_BUFFER(pointer));
+}
+
+/**
+ * destroy buffer through global pointer when current thread cleans up.
+ * pointer is valid until then, as memory allocated from thread arena.
+ */
+ybool_t ybuffer_destroy_global_pointer_later(void * pointer)
+{
+    if (!pointer) {
+        YUKI_LOG_FATAL("invalid pointer");
+        return yfalse;
+    }
+
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return yfalse;
+    }
+
+    ybuffer_thread_data_t * data = _ybuffer_thread_data();
+
+    if (!data) {
+        return yfalse;
+    }
+
+    if (data->deferred_count == data->deferred_capacity) {
+        yuint32_t capacity = data->deferred_capacity? data->deferred_capacity * 2: YBUFFER_DEFERRED_MIN_CAPACITY;
+        void ** deferred = (void **)realloc(data->deferred, capacity * sizeof(void *));
+
+        if (!deferred) {
+            YUKI_LOG_FATAL("out of memory. [size: %lu]", capacity * sizeof(void *));
+            return yfalse;
+        }
+
+        data->deferred = deferred;
+        data->deferred_capacity = capacity;
+    }
+
+    data->deferred[data->deferred_count++] = pointer;
+    return ytrue;
+}
+
+/**
+ * add a reference to global buffer thru the pointer of first element allocated in it.
+ * buffer is destroyed when every reference is dropped by ybuffer_destroy_global_pointer().
+ */
+ybool_t ybuffer_retain_global_pointer(void * pointer)
+{
+    if (!pointer) {
+        YUKI_LOG_FATAL("invalid pointer");
+        return yfalse;
+    }
+
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return yfalse;
+    }
+
+    ybuffer_cookie_t * cookie = (ybuffer_cookie_t*)_YBUFFER_GLOBAL_POINTER_TO_BUFFER(pointer)->buffer;
+
+    if (YBUFFER_COOKIE_PADDING != cookie->padding) {
+        YUKI_LOG_WARNING("try to retain an invalid global buffer");
+        return yfalse;
+    }
+
+    __sync_add_and_fetch(&cookie->refs, 1);
+    return ytrue;
+}
+
+/**
+ * get memory statistics.
+ * thread_stats is filled with statistics of current thread and
+ * process_stats is filled with statistics of all threads. either can be NULL.
+ */
+ybool_t ybuffer_stats(ybuffer_stats_t * thread_stats, ybuffer_stats_t * process_stats)
+{
+    if (!thread_stats && !process_stats) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return yfalse;
+    }
+
+    ybuffer_thread_data_t * data = _ybuffer_thread_data();
+
+    if (!data) {
+        return yfalse;
+    }
+
+    _ybuffer_stats_flush(data);
+
+    if (thread_stats) {
+        *thread_stats = data->stats;
+    }
+
+    if (process_stats) {
+        process_stats->requested_bytes = _YBUFFER_STATS_READ(requested_bytes);
+        process_stats->reserved_bytes = _YBUFFER_STATS_READ(reserved_bytes);
+        process_stats->chunk_count = _YBUFFER_STATS_READ(chunk_count);
+        process_stats->wasted_bytes = _YBUFFER_STATS_READ(wasted_bytes);
+        process_stats->cached_bytes = _YBUFFER_STATS_READ(cached_bytes);
+        process_stats->global_pinned_bytes = _YBUFFER_STATS_READ(global_pinned_bytes);
+        process_stats->peak_reserved_bytes = _YBUFFER_STATS_READ(peak_reserved_bytes);
+        process_stats->peak_global_pinned_bytes = _YBUFFER_STATS_READ(peak_global_pinned_bytes);
+    }
+
+    return ytrue;
+}
+
+/**
+ * reset accumulated statistics of current thread and process.
+ * peaks restart from current usage.
+ */
+ybool_t ybuffer_stats_reset()
+{
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return yfalse;
+    }
+
+    ybuffer_thread_data_t * data = _ybuffer_thread_data();
+
+    if (!data) {
+        return yfalse;
+    }
+
+    data->stats.requested_bytes = 0;
+    data->stats.wasted_bytes = 0;
+    data->stats.peak_reserved_bytes = data->stats.reserved_bytes;
+    data->flushed_requested = 0;
+
+    __sync_lock_test_and_set(&g_ybuffer_stats.requested_bytes, 0);
+    __sync_lock_test_and_set(&g_ybuffer_stats.wasted_bytes, 0);
+    __sync_lock_test_and_set(&g_ybuffer_stats.peak_reserved_bytes, _YBUFFER_STATS_READ(reserved_bytes));
+    __sync_lock_test_and_set(&g_ybuffer_stats.peak_global_pinned_bytes, _YBUFFER_STATS_READ(global_pinned_bytes));
+    return ytrue;
 }
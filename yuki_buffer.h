@@ -9,16 +9,37 @@ extern "C" {
 
 #define YBUFFER_COOKIE_PADDING ((yuint64_t)0xF3C18304DC21A5B7ULL)
 
+#define YBUFFER_FLAG_MMAP 0x1 /**< chunk is mapped by mmap() and must be released by munmap(). */
+
 #define ybuffer_smart_alloc(b, t) (t*)ybuffer_alloc((b), sizeof(t))
+#define ybuffer_slab_smart_alloc(t) (t*)ybuffer_slab_alloc(sizeof(t))
+#define ybuffer_slab_smart_free(p, t) ybuffer_slab_free((p), sizeof(t))
 #define ybuffer_round_up(s) (((s) + _YBUFFER_ALLOC_ALIGN - 1) & ~(_YBUFFER_ALLOC_ALIGN - 1))
 
 ybuffer_t * ybuffer_create(ysize_t size);
+ybuffer_t * ybuffer_create_aligned(ysize_t size, ysize_t align);
 ybuffer_t * ybuffer_create_global(ysize_t size);
 void * ybuffer_alloc(ybuffer_t * buffer, ysize_t size);
+void * ybuffer_alloc_aligned(ybuffer_t * buffer, ysize_t size, ysize_t align);
 void * ybuffer_simple_alloc(ysize_t size);
+ybool_t ybuffer_simple_resize(void * pointer, ysize_t old_size, ysize_t new_size);
+ybool_t ybuffer_arena_enabled();
+void * ybuffer_slab_alloc(ysize_t size);
+void ybuffer_slab_free(void * pointer, ysize_t size);
 ysize_t ybuffer_available_size(const ybuffer_t * buffer);
 ybool_t ybuffer_destroy_global(ybuffer_t * buffer);
 ybool_t ybuffer_destroy_global_pointer(void * pointer);
+ybool_t ybuffer_destroy_global_pointer_later(void * pointer);
+ybool_t ybuffer_retain_global_pointer(void * pointer);
+ybool_t ybuffer_mark(ybuffer_mark_t * mark);
+ybool_t ybuffer_rewind(const ybuffer_mark_t * mark);
+ybool_t ybuffer_detach_begin(ybuffer_mark_t * mark);
+ybool_t ybuffer_detach(const ybuffer_mark_t * mark, ybuffer_t ** chain);
+ybool_t ybuffer_adopt(ybuffer_t * chain);
+ybool_t ybuffer_safe_point();
+ybool_t ybuffer_epoch_advance();
+ybool_t ybuffer_stats(ybuffer_stats_t * thread_stats, ybuffer_stats_t * process_stats);
+ybool_t ybuffer_stats_reset();
 
 #ifdef __cplusplus
 }
@@ -638,6 +638,8 @@ static ybool_t _ytable_fecth_hash_key(const ytable_t * ytable, yvar_t ** hash_ke
             return yfalse;
         }
 
+        ysize_t hash_key_len = strlen(config->hash_key);
+
         // TODO: find hash key in conditions
         FOREACH_YVAR_ARRAY(*table_data, value) {
             YUKI_ASSERT(yvar_is_array(*value) && yvar_count(*value) == 3);
@@ -648,7 +650,9 @@ static ybool_t _ytable_fecth_hash_key(const ytable_t * ytable, yvar_t ** hash_ke
             YUKI_ASSERT(yvar_like_string(the_field));
 
             // TODO: find hash key
-            if (!strcmp(yvar_cstr_buffer(the_field),config->hash_key)) {
+            // compare length first
+            if (yvar_cstr_strlen(the_field) == hash_key_len
+                && !memcmp(yvar_cstr_buffer(the_field), config->hash_key, hash_key_len)) {
 
                 yvar_t the_op = YVAR_EMPTY();
                 yvar_t the_value = YVAR_EMPTY();
@@ -1113,6 +1117,23 @@ static ybool_t _ytable_sql_delete_builder(ytable_t * ytable)
     return ytrue;
 }
 
+/**
+ * numeric fields stored as int var in result.
+ */
+static ybool_t _ytable_is_int_field(enum enum_field_types type)
+{
+    switch (type) {
+        case MYSQL_TYPE_TINY:
+        case MYSQL_TYPE_SHORT:
+        case MYSQL_TYPE_LONG:
+        case MYSQL_TYPE_INT24:
+        case MYSQL_TYPE_LONGLONG:
+            return ytrue;
+        default:
+            return yfalse;
+    }
+}
+
 static ybool_t _ytable_sql_select_result_parser(const ytable_t * ytable, ytable_mysql_res_t * mysql_res, yvar_t ** result)
 {
     // TODO: finish it
@@ -1172,17 +1193,12 @@ static ybool_t _ytable_sql_select_result_parser(const ytable_t * ytable, ytable_
 
             is_unsigned = field_flags[i] & UNSIGNED_FLAG;
 
-            if (IS_NUM(field_types[i])) {
-                errno = 0;
-
-                if (is_unsigned) {
-                    temp_unsigned = strtoull(row[i], NULL, 10);
-                } else {
-                    temp_signed = strtoll(row[i], NULL, 10);
-                }
+            if (_ytable_is_int_field(field_types[i])) {
+                yvar_t cell = YVAR_EMPTY();
+                yvar_cstr_with_size(cell, row[i], lengths[i]);
 
-                if (errno) {
-                    YUKI_LOG_WARNING("cannot convert numeric field to int. [errno: %d]", errno);
+                if (is_unsigned? !yvar_parse_uint64(cell, temp_unsigned): !yvar_parse_int64(cell, temp_signed)) {
+                    YUKI_LOG_WARNING("cannot convert numeric field to int. [value: %.*s]", (int)lengths[i], row[i]);
                     return yfalse;
                 }
             }
@@ -1967,28 +1983,71 @@ ytable_t * ytable_reset(ytable_t * ytable)
     return ytable;
 }
 
-ytable_t * _ytable_select(ytable_t * ytable, const yvar_t * fields)
+/**
+ * check whether a var can be taken over by ytable without cloning.
+ * ytable lives in thread arena. a pinned var would never be unpinned, unless it's frozen.
+ */
+static ybool_t _ytable_can_move_var(const yvar_t * yvar)
 {
-    if (!ytable || !fields) {
-        YUKI_LOG_FATAL("invalid param");
-        _ytable_set_last_error(ytable, YTABLE_ERROR_INVALID_PARAM);
-        return ytable;
+    if (!yvar || !yvar_has_option(*yvar, YVAR_OPTION_HOLD_RESOURCE)) {
+        return yfalse;
+    }
+
+    if (yvar_has_option(*yvar, YVAR_OPTION_PINNED) && !yvar_has_option(*yvar, YVAR_OPTION_FROZEN)) {
+        YUKI_LOG_DEBUG("pinned var cannot be moved into ytable");
+        return yfalse;
+    }
+
+    return ytrue;
+}
+
+/**
+ * move a var into ytable. reference of a frozen var is dropped in yuki_clean_up().
+ */
+static ybool_t _ytable_move_var(yvar_t ** dst, yvar_t ** src)
+{
+    if (!yvar_move(*dst, *src)) {
+        return yfalse;
+    }
+
+    if (yvar_has_option(**dst, YVAR_OPTION_FROZEN) && !ybuffer_destroy_global_pointer_later(*dst)) {
+        YUKI_LOG_WARNING("cannot defer releasing frozen var");
+        return yfalse;
     }
 
+    return ytrue;
+}
+
+static ybool_t _ytable_select_prepare(ytable_t * ytable, const yvar_t * fields)
+{
     if (!yvar_is_array(*fields)) {
         YUKI_LOG_DEBUG("fields must be array");
         _ytable_set_last_error(ytable, YTABLE_ERROR_INVALID_FIELD);
-        return ytable;
+        return yfalse;
     }
 
     if (!_ytable_check_verb(ytable)) {
         YUKI_LOG_DEBUG("verb is set before");
-        return ytable;
+        return yfalse;
     }
 
     // TODO: validate fields
 
     ytable->verb = YTABLE_VERB_SELECT;
+    return ytrue;
+}
+
+ytable_t * _ytable_select(ytable_t * ytable, const yvar_t * fields)
+{
+    if (!ytable || !fields) {
+        YUKI_LOG_FATAL("invalid param");
+        _ytable_set_last_error(ytable, YTABLE_ERROR_INVALID_PARAM);
+        return ytable;
+    }
+
+    if (!_ytable_select_prepare(ytable, fields)) {
+        return ytable;
+    }
 
     if (!yvar_clone(ytable->fields, *fields)) {
         YUKI_LOG_FATAL("cannot clone field");
@@ -2000,6 +2059,32 @@ ytable_t * _ytable_select(ytable_t * ytable, const yvar_t * fields)
     return ytable;
 }
 
+/**
+ * same as _ytable_select() but takes over fields without cloning it.
+ * fields is set to NULL on success.
+ */
+ytable_t * _ytable_select_move(ytable_t * ytable, yvar_t ** fields)
+{
+    if (!ytable || !fields || !_ytable_can_move_var(*fields)) {
+        YUKI_LOG_FATAL("invalid param");
+        _ytable_set_last_error(ytable, YTABLE_ERROR_INVALID_PARAM);
+        return ytable;
+    }
+
+    if (!_ytable_select_prepare(ytable, *fields)) {
+        return ytable;
+    }
+
+    if (!_ytable_move_var(&ytable->fields, fields)) {
+        YUKI_LOG_FATAL("cannot move field");
+        _ytable_set_last_error(ytable, YTABLE_ERROR_CANNOT_CLONE_VAR);
+        return ytable;
+    }
+
+    _ytable_set_last_error(ytable, YTABLE_ERROR_SUCCESS);
+    return ytable;
+}
+
 ytable_t * _ytable_insert(ytable_t * ytable, const yvar_t * values)
 {
     if (!ytable || !values) {
@@ -2154,36 +2239,45 @@ ytable_t * _ytable_delete(ytable_t * ytable)
     return ytable;
 }
 
-ytable_t * _ytable_where(ytable_t * ytable, const yvar_t * conditions)
+static ybool_t _ytable_where_prepare(ytable_t * ytable)
 {
-    if (!ytable || !conditions) {
-        YUKI_LOG_FATAL("invalid param");
-        _ytable_set_last_error(ytable, YTABLE_ERROR_INVALID_PARAM);
-        return ytable;
-    }
-
     if (!_ytable_sql_is_valid_verb(ytable->verb)) {
         YUKI_LOG_FATAL("verb must be set before using where");
         _ytable_set_last_error(ytable, YTABLE_ERROR_INVALID_VERB);
-        return ytable;
+        return yfalse;
     }
 
     if (YTABLE_VERB_INSERT == ytable->verb) {
         YUKI_LOG_DEBUG("%s verb does not support where condition",
             _ytable_sql_get_verb(ytable->verb));
         _ytable_set_last_error(ytable, YTABLE_ERROR_INVALID_VERB);
-        return ytable;
+        return yfalse;
     }
 
     // TODO: support multiple where conditions
     if (ytable->conditions) {
         YUKI_LOG_DEBUG("only one condition can be used currently");
         _ytable_set_last_error(ytable, YTABLE_ERROR_NOT_IMPLEMENTED);
-        return ytable;
+        return yfalse;
     }
 
     // TODO: check conditions
 
+    return ytrue;
+}
+
+ytable_t * _ytable_where(ytable_t * ytable, const yvar_t * conditions)
+{
+    if (!ytable || !conditions) {
+        YUKI_LOG_FATAL("invalid param");
+        _ytable_set_last_error(ytable, YTABLE_ERROR_INVALID_PARAM);
+        return ytable;
+    }
+
+    if (!_ytable_where_prepare(ytable)) {
+        return ytable;
+    }
+
     if (!yvar_clone(ytable->conditions, *conditions)) {
         YUKI_LOG_FATAL("cannot clone condition");
         _ytable_set_last_error(ytable, YTABLE_ERROR_CANNOT_CLONE_VAR);
@@ -2194,35 +2288,43 @@ ytable_t * _ytable_where(ytable_t * ytable, const yvar_t * conditions)
     return ytable;
 }
 
-ytable_t * _ytable_where_using_triple_array(ytable_t * ytable, yvar_triple_array_t conditions, ysize_t size)
+/**
+ * same as _ytable_where() but takes over conditions without cloning it.
+ * conditions is set to NULL on success.
+ */
+ytable_t * _ytable_where_move(ytable_t * ytable, yvar_t ** conditions)
 {
-    if (!ytable || !conditions || !size) {
+    if (!ytable || !conditions || !_ytable_can_move_var(*conditions)) {
         YUKI_LOG_FATAL("invalid param");
         _ytable_set_last_error(ytable, YTABLE_ERROR_INVALID_PARAM);
         return ytable;
     }
 
-    if (!_ytable_sql_is_valid_verb(ytable->verb)) {
-        YUKI_LOG_FATAL("verb must be set before using where");
-        _ytable_set_last_error(ytable, YTABLE_ERROR_INVALID_VERB);
+    if (!_ytable_where_prepare(ytable)) {
         return ytable;
     }
 
-    if (YTABLE_VERB_INSERT == ytable->verb) {
-        YUKI_LOG_DEBUG("%s verb does not support where condition",
-            _ytable_sql_get_verb(ytable->verb));
-        _ytable_set_last_error(ytable, YTABLE_ERROR_INVALID_VERB);
+    if (!_ytable_move_var(&ytable->conditions, conditions)) {
+        YUKI_LOG_FATAL("cannot move condition");
+        _ytable_set_last_error(ytable, YTABLE_ERROR_CANNOT_CLONE_VAR);
         return ytable;
     }
 
-    // TODO: support multiple where conditions
-    if (ytable->conditions) {
-        YUKI_LOG_DEBUG("only one condition can be used currently");
-        _ytable_set_last_error(ytable, YTABLE_ERROR_NOT_IMPLEMENTED);
+    _ytable_set_last_error(ytable, YTABLE_ERROR_SUCCESS);
+    return ytable;
+}
+
+ytable_t * _ytable_where_using_triple_array(ytable_t * ytable, yvar_triple_array_t conditions, ysize_t size)
+{
+    if (!ytable || !conditions || !size) {
+        YUKI_LOG_FATAL("invalid param");
+        _ytable_set_last_error(ytable, YTABLE_ERROR_INVALID_PARAM);
         return ytable;
     }
 
-    // TODO: check conditions
+    if (!_ytable_where_prepare(ytable)) {
+        return ytable;
+    }
 
     yvar_t raw_cond[size];
     ysize_t index;
@@ -2330,6 +2432,7 @@ ytable_t * ytable_set_option(ytable_t * ytable, ytable_option_t option, const yv
 
 /**
  * pin ytable_t variable to global memory chain.
+ * frozen fields, conditions and order_by are shared by reference instead of copied.
  * @return the pinned ytable pointer. NULL if failed.
  */
 ytable_t * _ytable_pin(ytable_t * ytable)
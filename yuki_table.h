@@ -37,10 +37,12 @@ extern "C" {
 #define _YTABLE_SQL_INT_MAXLEN 20U
 
 #define ytable_select(ytable, fields) _ytable_select((ytable), &(fields))
+#define ytable_select_move(ytable, fields) _ytable_select_move((ytable), &(fields))
 #define ytable_insert(ytable, values) _ytable_insert((ytable), &(values))
 #define ytable_update(ytable, values) _ytable_update((ytable), &(values))
 #define ytable_delete(ytable) _ytable_delete((ytable))
 #define ytable_where(ytable, conditions) _ytable_where((ytable), &(conditions))
+#define ytable_where_move(ytable, conditions) _ytable_where_move((ytable), &(conditions))
 #define ytable_fetch_one(ytable, result) _ytable_fetch_one((ytable), &(result))
 #define ytable_fetch_all(ytable, result) _ytable_fetch_all((ytable), &(result))
 #define ytable_fetch_insert_id(ytable, insert_id) _ytable_fetch_insert_id((ytable), &(insert_id))
@@ -74,6 +76,7 @@ extern "C" {
 ytable_t * ytable_instance(const char * table_name);
 ytable_t * ytable_reset(ytable_t * ytable);
 ytable_t * _ytable_select(ytable_t * ytable, const yvar_t * fields);
+ytable_t * _ytable_select_move(ytable_t * ytable, yvar_t ** fields);
 ytable_t * _ytable_insert(ytable_t * ytable, const yvar_t * values);
 ytable_t * _ytable_insert_using_map_kv(ytable_t * ytable, yvar_map_kv_t values, ysize_t size);
 ytable_t * _ytable_insert(ytable_t * ytable, const yvar_t * values);
@@ -81,6 +84,7 @@ ytable_t * _ytable_update(ytable_t * ytable, const yvar_t * values);
 ytable_t * _ytable_update_using_triple_array(ytable_t * ytable, yvar_triple_array_t values, ysize_t size);
 ytable_t * _ytable_delete(ytable_t * ytable);
 ytable_t * _ytable_where(ytable_t * ytable, const yvar_t * conditions);
+ytable_t * _ytable_where_move(ytable_t * ytable, yvar_t ** conditions);
 ytable_t * _ytable_where_using_triple_array(ytable_t * ytable, yvar_triple_array_t conditions, ysize_t size);
 
 ybool_t _ytable_fetch_one(ytable_t * ytable, yvar_t ** result);
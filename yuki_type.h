@@ -66,6 +66,8 @@ typedef enum _YVAR_TYPE {
     YVAR_TYPE_ARRAY,
     YVAR_TYPE_LIST,
     YVAR_TYPE_MAP,
+    YVAR_TYPE_PACKED_ARRAY,
+    YVAR_TYPE_STRIDED_ARRAY,
     YVAR_TYPE_MAX, // max
 } YVAR_TYPE;
 
@@ -78,8 +80,25 @@ typedef enum _YVAR_OPTIONS {
     YVAR_OPTION_HOLD_RESOURCE = 0x2, /**< need to free memory */
     YVAR_OPTION_SORTED = 0x4, /**< array is sorted */
     YVAR_OPTION_PINNED = 0x8, /**< var is pinned. pinned var cannot be modified until upinned. */
+    YVAR_OPTION_HASHED = 0x10, /**< map has a hash index, or str has a cached hash */
+    YVAR_OPTION_INLINE = 0x20, /**< str chars are stored inside var */
+    YVAR_OPTION_GROWABLE = 0x40, /**< array has capacity in thread arena and can grow. copy by yvar_assign() drops it. */
+    YVAR_OPTION_FROZEN = 0x80, /**< var is pinned and shared by reference. clone and pin take a reference only. */
+    YVAR_OPTION_INTERNED = 0x100, /**< str chars belong to a clone and may be shared by other strs. chars are read-only. */
 } YVAR_OPTIONS;
 
+/**
+ * compare operators of array kernels, i.e. 'item op value'.
+ */
+typedef enum _yvar_cmp_t {
+    YVAR_CMP_EQ = 0,
+    YVAR_CMP_NE,
+    YVAR_CMP_LT,
+    YVAR_CMP_LE,
+    YVAR_CMP_GT,
+    YVAR_CMP_GE,
+} yvar_cmp_t;
+
 typedef int8_t ybool_t;
 typedef int8_t yint8_t;
 typedef uint8_t yuint8_t;
@@ -106,11 +125,42 @@ typedef struct _ystr_t {
     char * str;
 } ystr_t;
 
+#define YVAR_INLINE_STR_MAX_SIZE 14
+
+/**
+ * short str stored inside var. chars end with '\0'.
+ * it has the same size as ycstr_t on 64-bit platform.
+ */
+typedef struct _yinline_str_t {
+    char str[YVAR_INLINE_STR_MAX_SIZE + 1];
+    yuint8_t size;
+} yinline_str_t;
+
 typedef struct _yarray_t {
     ysize_t size;
     struct _yvar_t * yvars;
 } yarray_t;
 
+/**
+ * array of int-like values of one type stored as a native C array.
+ * item_type is a var type between YVAR_TYPE_INT_MIN and YVAR_TYPE_INT_MAX.
+ */
+typedef struct _ypacked_array_t {
+    yuint32_t size;
+    yuint8_t item_type;
+    void * items;
+} ypacked_array_t;
+
+/**
+ * readonly view of every stride-th var in an array.
+ * vars are owned by viewed array. clone and pin copy them to a generic array.
+ */
+typedef struct _ystrided_array_t {
+    yuint32_t size;
+    yuint32_t stride;
+    struct _yvar_t * yvars;
+} ystrided_array_t;
+
 typedef struct _ylist_t {
     struct _ylist_node_t * head;
     struct _ylist_node_t * tail;
@@ -126,10 +176,29 @@ typedef struct _ymap_t {
     struct _yvar_t * values;
 } ymap_t;
 
+/**
+ * slot of map hash index.
+ */
+typedef struct _ymap_index_slot_t {
+    yuint32_t hash;
+    yuint32_t index;    /**< index of key plus 1. 0 means empty slot. */
+} ymap_index_slot_t;
+
+/**
+ * hash index of a map. built when map is cloned or pinned.
+ * header lives right before keys var and slots live right before header.
+ * it has no pointer so that it's still valid after memory is copied.
+ */
+typedef struct _ymap_index_t {
+    yuint32_t mask;     /**< slot count minus 1. slot count is power of 2. */
+    yuint32_t count;    /**< number of keys. */
+} ymap_index_t;
+
 typedef struct _yvar_t {
     yuint8_t type;
     yuint8_t version;
     yvar_option_t options;
+    yuint32_t frozen_offset;    /**< offset of data from frozen var in its global buffer. only valid if var is FROZEN. */
 
     union {
         yint8_t yundefined_data; // should be always 0
@@ -144,7 +213,10 @@ typedef struct _yvar_t {
         yuint64_t yuint64_data;
         ycstr_t ycstr_data;
         ystr_t ystr_data;
+        yinline_str_t yinline_str_data;
         yarray_t yarray_data;
+        ypacked_array_t ypacked_array_data;
+        ystrided_array_t ystrided_array_data;
         ylist_t ylist_data;
         ymap_t ymap_data;
     } data;
@@ -153,15 +225,27 @@ typedef struct _yvar_t {
 typedef yvar_t yvar_map_kv_t[][2];
 typedef yvar_t yvar_triple_array_t[][3];
 
+#define YLIST_NODE_CAPACITY 8
+#define YLIST_NODE_FLAG_SLAB 0x1 /**< node is taken from thread slab pool and can be returned to it. */
+
+/**
+ * unrolled list node. vars in yvars[begin, end) are in use.
+ */
 typedef struct _ylist_node_t {
     struct _ylist_node_t * prev;
     struct _ylist_node_t * next;
-    yvar_t yvar;
+    yuint16_t begin;
+    yuint16_t end;
+    yuint32_t flags; /**< YLIST_NODE_FLAG_*. */
+    ysize_t count; /**< number of vars in list. only valid in head node. */
+    yvar_t yvars[YLIST_NODE_CAPACITY];
 } ylist_node_t;
 
 typedef struct _ybuffer_t {
     ysize_t size;
     ysize_t offset;
+    yuint32_t flags;
+    yuint32_t epoch;
     struct _ybuffer_t * next;
     char buffer[];
 } ybuffer_t;
@@ -172,8 +256,68 @@ typedef struct _ybuffer_t {
 typedef struct _ybuffer_cookie_t {
     ybuffer_t * prev;
     yuint64_t padding;
+    yuint32_t shard;    /**< index of global chain shard owning this buffer. immutable once buffer is created. */
+    yuint32_t refs;     /**< owners of a shared buffer. buffer is destroyed by the last one. */
 } ybuffer_cookie_t;
 
+/**
+ * memory statistics of ybuffer.
+ * requested, wasted and peak values are accumulated since last ybuffer_stats_reset().
+ */
+typedef struct _ybuffer_stats_t {
+    ysize_t requested_bytes;            /**< bytes handed out by thread arena. */
+    ysize_t reserved_bytes;             /**< bytes of chunks held by thread chains. */
+    ysize_t chunk_count;                /**< number of chunks held by thread chains. */
+    ysize_t wasted_bytes;               /**< unused tail bytes of retired arena chunks. */
+    ysize_t cached_bytes;               /**< bytes of chunks kept in free-chunk cache. */
+    ysize_t global_pinned_bytes;        /**< bytes of live global buffers. process-wide only. */
+    ysize_t peak_reserved_bytes;        /**< peak of reserved_bytes. */
+    ysize_t peak_global_pinned_bytes;   /**< peak of global_pinned_bytes. process-wide only. */
+} ybuffer_stats_t;
+
+#define YBUFFER_CACHE_CLASS_COUNT 24
+#define YBUFFER_SLAB_CLASS_COUNT  32
+
+/**
+ * pool of fixed-size objects carved from thread arena.
+ */
+typedef struct _ybuffer_slab_t {
+    void * free_list;   /**< objects returned by ybuffer_slab_free(). */
+    char * cursor;      /**< next unused object in current page. */
+    char * end;         /**< end of current page. */
+} ybuffer_slab_t;
+
+/**
+ * per-thread buffer state.
+ */
+typedef struct _ybuffer_thread_data_t {
+    ybuffer_t * chain;          /**< all chunks owned by current thread. newest first. */
+    ybuffer_t * active;         /**< chunk used by bump allocation. */
+    ysize_t next_chunk_size;    /**< size of next arena chunk. grows geometrically. */
+    yuint32_t global_shard;     /**< global chain shard used by current thread. */
+    ybool_t detaching;          /**< set between ybuffer_detach_begin() and ybuffer_detach(). */
+    yuint32_t epoch;            /**< current epoch. advanced by ybuffer_epoch_advance(). */
+    ysize_t flushed_requested;  /**< requested bytes already added to process stats. */
+    ybuffer_stats_t stats;      /**< statistics of current thread. */
+    ybuffer_slab_t slabs[YBUFFER_SLAB_CLASS_COUNT];      /**< slab pools. one per 8-byte object size. */
+    ybuffer_t * cache[YBUFFER_CACHE_CLASS_COUNT];        /**< free chunks bucketed by size class. */
+    yuint32_t cache_count[YBUFFER_CACHE_CLASS_COUNT];    /**< number of chunks in each bucket. */
+    void ** deferred;           /**< global pointers to destroy when current thread cleans up. */
+    yuint32_t deferred_count;   /**< number of pointers in deferred. */
+    yuint32_t deferred_capacity;
+} ybuffer_thread_data_t;
+
+/**
+ * checkpoint of thread buffer state.
+ * created by ybuffer_mark() and consumed by ybuffer_rewind().
+ */
+typedef struct _ybuffer_mark_t {
+    ybuffer_t * chain;
+    ybuffer_t * active;
+    ysize_t offset;
+    ysize_t next_chunk_size;
+} ybuffer_mark_t;
+
 typedef enum _ytable_hash_method_t {
     YTABLE_HASH_METHOD_INVALID,
     YTABLE_HASH_METHOD_DEFAULT,
@@ -1,75 +1,482 @@
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 
 #include "yuki.h"
 
+// map with fewer keys is scanned linearly.
+#define YVAR_MAP_INDEX_MIN_SIZE 8
+// smaller int array is sorted by merge sort.
+#define YVAR_ARRAY_RADIX_SORT_MIN_SIZE 64
+// temp memory of sort and merge up to this size lives on stack.
+#define YVAR_SCRATCH_STACK_SIZE 1024
+
+#define _YVAR_COMPARE_VALUE(l, r) ((l) < (r)? -1: ((l) > (r)? 1: 0))
+
+// cloned str has its hash right before chars.
+#define YVAR_STR_HASH_SIZE ybuffer_round_up(sizeof(yuint32_t))
+#define _YVAR_STR_HASH(yvar) (*(const yuint32_t *)((yvar)->data.ycstr_data.str - YVAR_STR_HASH_SIZE))
+#define _YVAR_STR_SIZE(yvar) (((yvar)->options & YVAR_OPTION_INLINE)? \
+    (ysize_t)(yvar)->data.yinline_str_data.size: (yvar)->data.ycstr_data.size)
+
+// growable array has its capacity right before vars.
+#define YVAR_ARRAY_CAPACITY_SIZE ybuffer_round_up(sizeof(ysize_t))
+#define YVAR_ARRAY_MIN_CAPACITY 8
+#define _YVAR_ARRAY_CAPACITY(yvar) (*(ysize_t *)((char *)(yvar)->data.yarray_data.yvars - YVAR_ARRAY_CAPACITY_SIZE))
+
+// packed array item size of int-like var types. 0 means type cannot be packed.
+#define _YVAR_PACKED_ITEM_SIZE(t) ((t) >= YVAR_TYPE_INT_MIN && (t) <= YVAR_TYPE_INT_MAX? g_yvar_packed_item_size[(t)]: 0)
+#define _YVAR_PACKED_ARRAY_MEM_SIZE(yvar) ((ysize_t)(yvar)->data.ypacked_array_data.size * \
+    _YVAR_PACKED_ITEM_SIZE((yvar)->data.ypacked_array_data.item_type))
+
+// index-th var in a strided array
+#define _YVAR_STRIDED_ARRAY_VAR(yvar, index) ((yvar)->data.ystrided_array_data.yvars + \
+    (ysize_t)(index) * (yvar)->data.ystrided_array_data.stride)
+
+// direct mapped caches to intern strs and map keys in one clone. size must be power of 2.
+#define YVAR_CLONE_STR_CACHE_SIZE 32
+#define YVAR_CLONE_KEYS_CACHE_SIZE 8
+#define _YVAR_CLONE_CACHE_SLOT(p, n) ((((uintptr_t)(p) >> 4) ^ (uintptr_t)(p)) & ((n) - 1))
+
+/**
+ * intern caches of a clone. memory size counting and cloning must use caches
+ * in the same way, so that cloned var fits the buffer exactly.
+ */
+typedef struct _yvar_clone_context_t {
+    struct {
+        const char * src;
+        ysize_t size;
+        char * dst;
+    } strs[YVAR_CLONE_STR_CACHE_SIZE];
+    struct {
+        const yvar_t * src;
+        yvar_t * dst;
+        ybool_t hashed;
+    } keys[YVAR_CLONE_KEYS_CACHE_SIZE];
+    ybool_t share_frozen;   /**< frozen vars are shared by reference instead of being copied. */
+} yvar_clone_context_t;
+
+// encoded var starts with a header. "YVAR" in little endian.
+#define YVAR_ENCODED_MAGIC 0x52415659
+// nesting limit of encoded var, so that a bad buffer cannot overflow stack.
+#define YVAR_ENCODED_MAX_DEPTH 256
+#define YVAR_ENCODED_HEADER_SIZE ybuffer_round_up(sizeof(yvar_encoded_header_t))
+// options only make sense for vars in memory owned by yuki.
+#define YVAR_ENCODED_INVALID_OPTIONS (YVAR_OPTION_HOLD_RESOURCE | YVAR_OPTION_PINNED | \
+    YVAR_OPTION_GROWABLE | YVAR_OPTION_FROZEN)
+
+/**
+ * header of an encoded var. root var follows header.
+ * pointers in encoded vars are valid when buffer is at base address.
+ * buffer at any other address must be copied by yvar_view_copy() before use.
+ */
+typedef struct _yvar_encoded_header_t {
+    yuint32_t magic;
+    yuint8_t version;
+    yuint8_t pointer_size;
+    yuint16_t reserved;
+    yuint64_t size;     /**< size of encoded var including header. */
+    yuint64_t base;     /**< address of buffer which pointers are relative to. */
+} yvar_encoded_header_t;
+
+/**
+ * state of encoding. vars are laid out in the order they are visited.
+ * if buf is NULL, nothing is written and offset counts encoded size.
+ */
+typedef struct _yvar_encode_context_t {
+    char * buf;
+    ysize_t size;
+    ysize_t offset;
+    const yvar_t * keys_src;    /**< keys of last map. rows of a result set share it. */
+    yvar_t * keys_dst;
+    ybool_t keys_hashed;
+} yvar_encode_context_t;
+
+/**
+ * state of viewing an encoded buffer. it walks vars in the same order as encoding.
+ */
+typedef struct _yvar_view_context_t {
+    char * buf;
+    ysize_t size;
+    ysize_t offset;
+    yuint64_t base;
+    ysize_t keys_offset;        /**< offset of keys of last map. 0 if there is no map yet. */
+    ybool_t keys_hashed;
+    ybool_t relocate;           /**< buf is a private copy. pointers are rewritten to point into it. */
+} yvar_view_context_t;
+
 // forward declaration as _yvar_clone_internal_element() uses it.
-static ybool_t _yvar_list_push_back_internal(ybuffer_t * buffer, yvar_t * list, const yvar_t * var, ybool_t need_clone);
+static ybool_t _yvar_list_push_back_internal(ybuffer_t * buffer, yvar_t * list, const yvar_t * var);
 
 static ybool_t _ybool_to_str(ybool_t ybool, char * output, ysize_t size)
 {
     YUKI_ASSERT(output && size);
 
-    char buf[16];
-    int n = snprintf(buf, sizeof(buf), ybool? "true": "false");
+    const char * str = ybool? "true": "false";
+    ysize_t n = ybool? 4: 5;
 
-    if (n < 0) {
-        YUKI_LOG_FATAL("snprintf fails with err %d", n);
+    if (n >= size) {
+        YUKI_LOG_WARNING("buffer length is too small. [required: %u] [actual: %u]", n + 1, size);
         return yfalse;
     }
 
+    memcpy(output, str, n + 1);
+    return ytrue;
+}
+
+// "00" to "99". two digits are written at a time.
+static const char g_yvar_digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const yuint8_t g_yvar_packed_item_size[YVAR_TYPE_INT_MAX + 1] = {
+    0,
+    sizeof(ybool_t),
+    sizeof(yint8_t),
+    sizeof(yuint8_t),
+    sizeof(yint16_t),
+    sizeof(yuint16_t),
+    sizeof(yint32_t),
+    sizeof(yuint32_t),
+    sizeof(yint64_t),
+    sizeof(yuint64_t),
+};
+
+// 20 digits of max uint64, 1 sign and 1 '\0'.
+#define YVAR_INT_STR_BUF_SIZE 24
+
+/**
+ * write digits of value backward. return first char.
+ */
+static char * _yuint64_to_digits(yuint64_t value, char * end)
+{
+    char * p = end;
+
+    while (value >= 100) {
+        const char * pair = g_yvar_digit_pairs + (value % 100) * 2;
+        value /= 100;
+        *--p = pair[1];
+        *--p = pair[0];
+    }
+
+    if (value >= 10) {
+        const char * pair = g_yvar_digit_pairs + value * 2;
+        *--p = pair[1];
+        *--p = pair[0];
+    } else {
+        *--p = (char)('0' + value);
+    }
+
+    return p;
+}
+
+static ybool_t _yint_to_str(yuint64_t abs_value, ybool_t negative, char * output, ysize_t size)
+{
+    YUKI_ASSERT(output && size);
+
+    char buf[YVAR_INT_STR_BUF_SIZE];
+    char * end = buf + sizeof(buf);
+    char * p = _yuint64_to_digits(abs_value, end);
+
+    if (negative) {
+        *--p = '-';
+    }
+
+    ysize_t n = end - p;
+
     if (n >= size) {
-        YUKI_LOG_WARNING("buffer length is too small. [required: %d] [actual: %u]", n + 1, size);
+        YUKI_LOG_WARNING("buffer length is too small. [required: %u] [actual: %u]", n + 1, size);
         return yfalse;
     }
 
-    strncpy(output, buf, n + 1);
+    memcpy(output, p, n);
+    output[n] = '\0';
     return ytrue;
 }
 
-#define _YUKI_INT_TYPE_TO_STR_FUNCTION(t, s) \
+// abs value is computed in unsigned so that min value does not overflow.
+#define _YUKI_INT_TYPE_TO_STR_FUNCTION(t) \
     static ybool_t _##t##_to_str(t##_t t, char * output, ysize_t size) \
     { \
-        YUKI_ASSERT(output && size); \
-        \
-        char buf[32]; \
-        int n = snprintf(buf, sizeof(buf), s, t); \
-        \
-        if (n < 0) { \
-            YUKI_LOG_FATAL("snprintf fails with err %d", n); \
-            return yfalse; \
-        } \
-        \
-        if (n >= size) { \
-            YUKI_LOG_WARNING("buffer length is too small. [required: %d] [actual: %u]", n + 1, size); \
-            return yfalse; \
-        } \
-        \
-        strncpy(output, buf, n + 1); \
-        return ytrue; \
+        return _yint_to_str(t < 0? (yuint64_t)0 - (yuint64_t)t: (yuint64_t)t, t < 0, output, size); \
+    }
+
+#define _YUKI_UINT_TYPE_TO_STR_FUNCTION(t) \
+    static ybool_t _##t##_to_str(t##_t t, char * output, ysize_t size) \
+    { \
+        return _yint_to_str((yuint64_t)t, yfalse, output, size); \
+    }
+
+_YUKI_INT_TYPE_TO_STR_FUNCTION(yint8)
+_YUKI_UINT_TYPE_TO_STR_FUNCTION(yuint8)
+_YUKI_INT_TYPE_TO_STR_FUNCTION(yint16)
+_YUKI_UINT_TYPE_TO_STR_FUNCTION(yuint16)
+_YUKI_INT_TYPE_TO_STR_FUNCTION(yint32)
+_YUKI_UINT_TYPE_TO_STR_FUNCTION(yuint32)
+_YUKI_INT_TYPE_TO_STR_FUNCTION(yint64)
+_YUKI_UINT_TYPE_TO_STR_FUNCTION(yuint64)
+
+/**
+ * parse a decimal str. only an optional sign and digits are allowed.
+ * abs value is returned with overflow checking.
+ */
+static ybool_t _ystr_to_digits(const char * str, ysize_t size, yuint64_t * abs_value, ybool_t * negative)
+{
+    YUKI_ASSERT(abs_value && negative);
+
+    const char * p = str;
+    const char * end = str + size;
+    yuint64_t value = 0;
+
+    *negative = yfalse;
+
+    if (p != end && (*p == '-' || *p == '+')) {
+        *negative = *p == '-';
+        p++;
+    }
+
+    if (p == end) {
+        YUKI_LOG_DEBUG("str is not a number");
+        return yfalse;
+    }
+
+    for (; p != end; p++) {
+        yuint32_t digit = (yuint32_t)(unsigned char)*p - '0';
+
+        if (digit > 9) {
+            YUKI_LOG_DEBUG("str is not a number");
+            return yfalse;
+        }
+
+        // 1844674407370955161 is max uint64 / 10.
+        if (value > 1844674407370955161ULL || (value == 1844674407370955161ULL && digit > 5)) {
+            YUKI_LOG_DEBUG("value is overflow");
+            return yfalse;
+        }
+
+        value = value * 10 + digit;
+    }
+
+    *abs_value = value;
+    return ytrue;
+}
+
+static ybool_t _ycstr_to_str(const yvar_t * yvar, char * output, ysize_t size)
+{
+    YUKI_ASSERT(yvar && output && size);
+
+    ysize_t len = _YVAR_STR_SIZE(yvar);
+
+    if (len + 1 > size) {
+        YUKI_LOG_WARNING("buffer length is too small. [required: %u] [actual: %u]", len, size);
+        return yfalse;
+    }
+
+    strncpy(output, yvar_cstr_buffer(*yvar), len);
+    output[len] = '\0';
+    return ytrue;
+}
+
+/**
+ * hash a var for map index. vars equal by yvar_equal() always have same hash.
+ */
+static yuint32_t _yvar_hash(const yvar_t * yvar)
+{
+    if (yvar_like_string(*yvar) && yvar_has_option(*yvar, YVAR_OPTION_HASHED)) {
+        return _YVAR_STR_HASH(yvar);
+    }
+
+    // FNV-1a
+    yuint32_t hash = 2166136261U ^ yvar->type;
+    const unsigned char * p = NULL;
+    ysize_t size = 0;
+
+    switch (yvar->type) {
+        case YVAR_TYPE_CSTR:
+        case YVAR_TYPE_STR:
+            p = (const unsigned char *)yvar_cstr_buffer(*yvar);
+            size = p? _YVAR_STR_SIZE(yvar): 0;
+            break;
+        case YVAR_TYPE_BOOL:
+        case YVAR_TYPE_INT8:
+        case YVAR_TYPE_UINT8:
+            p = (const unsigned char *)&yvar->data.yuint8_data;
+            size = sizeof(yuint8_t);
+            break;
+        case YVAR_TYPE_INT16:
+        case YVAR_TYPE_UINT16:
+            p = (const unsigned char *)&yvar->data.yuint16_data;
+            size = sizeof(yuint16_t);
+            break;
+        case YVAR_TYPE_INT32:
+        case YVAR_TYPE_UINT32:
+            p = (const unsigned char *)&yvar->data.yuint32_data;
+            size = sizeof(yuint32_t);
+            break;
+        case YVAR_TYPE_INT64:
+        case YVAR_TYPE_UINT64:
+            p = (const unsigned char *)&yvar->data.yuint64_data;
+            size = sizeof(yuint64_t);
+            break;
+        default:
+            // compound keys are rare. they share one hash value.
+            break;
+    }
+
+    while (size--) {
+        hash = (hash ^ *p++) * 16777619U;
+    }
+
+    return hash;
+}
+
+/**
+ * slot count of hash index for a map.
+ * return 0 if map is too small to be indexed or is sorted.
+ */
+static ysize_t _yvar_map_index_capacity(const yvar_t * map)
+{
+    ysize_t count = yvar_count(*map->data.ymap_data.keys);
+
+    // sorted map uses binary search instead
+    if (count < YVAR_MAP_INDEX_MIN_SIZE || yvar_has_option(*map, YVAR_OPTION_SORTED)) {
+        return 0;
+    }
+
+    // keep load factor under 0.5
+    ysize_t capacity = YVAR_MAP_INDEX_MIN_SIZE;
+
+    while (capacity < count * 2) {
+        capacity <<= 1;
     }
 
-_YUKI_INT_TYPE_TO_STR_FUNCTION(yint8,   "%d")
-_YUKI_INT_TYPE_TO_STR_FUNCTION(yuint8,  "%u")
-_YUKI_INT_TYPE_TO_STR_FUNCTION(yint16,  "%d")
-_YUKI_INT_TYPE_TO_STR_FUNCTION(yuint16, "%u")
-_YUKI_INT_TYPE_TO_STR_FUNCTION(yint32,  "%" PRId32)
-_YUKI_INT_TYPE_TO_STR_FUNCTION(yuint32, "%" PRIu32)
-_YUKI_INT_TYPE_TO_STR_FUNCTION(yint64,  "%" PRId64)
-_YUKI_INT_TYPE_TO_STR_FUNCTION(yuint64, "%" PRIu64)
+    return capacity;
+}
+
+static ysize_t _yvar_map_index_mem_size(const yvar_t * map)
+{
+    ysize_t capacity = _yvar_map_index_capacity(map);
+
+    if (!capacity) {
+        return 0;
+    }
+
+    return ybuffer_round_up(capacity * sizeof(ymap_index_slot_t)) + ybuffer_round_up(sizeof(ymap_index_t));
+}
+
+static inline ymap_index_t * _yvar_map_index(const yvar_t * keys)
+{
+    return (ymap_index_t *)((char *)keys - ybuffer_round_up(sizeof(ymap_index_t)));
+}
+
+static inline ymap_index_slot_t * _yvar_map_index_slots(const ymap_index_t * index)
+{
+    return (ymap_index_slot_t *)((char *)index - ybuffer_round_up((index->mask + 1) * sizeof(ymap_index_slot_t)));
+}
+
+/**
+ * build hash index of keys with capacity slots. memory of index must be right before keys var.
+ */
+static void _yvar_map_index_build(const yvar_t * keys, ysize_t capacity)
+{
+    ymap_index_t * index = _yvar_map_index(keys);
+    ymap_index_slot_t * slots;
+    ysize_t i = 0;
+
+    index->mask = (yuint32_t)(capacity - 1);
+    index->count = (yuint32_t)yvar_count(*keys);
+    slots = _yvar_map_index_slots(index);
+    memset(slots, 0, capacity * sizeof(ymap_index_slot_t));
+
+    FOREACH_YVAR_ARRAY(*keys, key) {
+        yuint32_t hash = _yvar_hash(key);
+        yuint32_t pos = hash & index->mask;
+
+        // first key wins on duplicated keys, as linear scan does
+        while (slots[pos].index) {
+            pos = (pos + 1) & index->mask;
+        }
+
+        slots[pos].hash = hash;
+        slots[pos].index = (yuint32_t)(i + 1);
+        i++;
+    }
+}
+
+/**
+ * get memory of a var allocated right after var itself when var was pinned.
+ * return NULL if var has no memory.
+ */
+static const void * _yvar_frozen_data(const yvar_t * yvar)
+{
+    YUKI_ASSERT(yvar);
 
-static ybool_t _ycstr_to_str(const ycstr_t * ycstr, char * output, ysize_t size)
+    switch (yvar->type) {
+        case YVAR_TYPE_ARRAY:
+            return yvar->data.yarray_data.yvars;
+        case YVAR_TYPE_LIST:
+            return yvar->data.ylist_data.head;
+        case YVAR_TYPE_PACKED_ARRAY:
+            return yvar->data.ypacked_array_data.items;
+        case YVAR_TYPE_MAP:
+            return yvar->data.ymap_data.keys;
+        case YVAR_TYPE_STR:
+        case YVAR_TYPE_CSTR:
+            return yvar_has_option(*yvar, YVAR_OPTION_INLINE)? NULL: yvar->data.ycstr_data.str;
+    }
+
+    return NULL;
+}
+
+/**
+ * get the var returned by yvar_freeze() which owns memory of a frozen var.
+ * frozen var may be a copy of it stored in an array or list.
+ * return NULL if var is not frozen or has no memory to share.
+ */
+static yvar_t * _yvar_frozen_root(const yvar_t * yvar)
+{
+    YUKI_ASSERT(yvar);
+
+    if (!yvar_has_option(*yvar, YVAR_OPTION_FROZEN)) {
+        return NULL;
+    }
+
+    const char * data = (const char *)_yvar_frozen_data(yvar);
+
+    if (!data) {
+        return NULL;
+    }
+
+    return (yvar_t *)(data - yvar->frozen_offset);
+}
+
+/**
+ * take a reference of a frozen var. it's dropped when current thread cleans up.
+ */
+static ybool_t _yvar_frozen_retain_until_clean_up(yvar_t * root)
 {
-    YUKI_ASSERT(ycstr && output && size);
+    YUKI_ASSERT(root);
 
-    if (ycstr->size + 1 > size) {
-        YUKI_LOG_WARNING("buffer length is too small. [required: %u] [actual: %u]", ycstr->size, size);
+    if (!ybuffer_retain_global_pointer(root)) {
+        YUKI_LOG_WARNING("cannot retain frozen var");
+        return yfalse;
+    }
+
+    if (!ybuffer_destroy_global_pointer_later(root)) {
+        YUKI_LOG_WARNING("cannot defer release of frozen var");
+        ybuffer_destroy_global_pointer(root);
         return yfalse;
     }
 
-    strncpy(output, ycstr->str, ycstr->size);
-    output[ycstr->size] = '\0';
     return ytrue;
 }
 
@@ -77,17 +484,22 @@ static ybool_t _ycstr_to_str(const ycstr_t * ycstr, char * output, ysize_t size)
  * count size of memory of a var recursively.
  * especially, if yvar is NULL, return 0.
  */
-static ysize_t _yvar_mem_size(const yvar_t * yvar)
+static ysize_t _yvar_mem_size(const yvar_t * yvar, yvar_clone_context_t * context)
 {
     YUKI_ASSERT(yvar);
 
     ysize_t size = ybuffer_round_up(sizeof(yvar_t));
 
+    // frozen var is shared. only var itself is copied.
+    if (context->share_frozen && _yvar_frozen_root(yvar)) {
+        return size;
+    }
+
     switch (yvar->type) {
         case YVAR_TYPE_ARRAY:
         {
             FOREACH_YVAR_ARRAY(*yvar, value) {
-                size += _yvar_mem_size(value);
+                size += _yvar_mem_size(value, context);
             }
 
             ysize_t cnt = yvar_count(*yvar);
@@ -98,34 +510,114 @@ static ysize_t _yvar_mem_size(const yvar_t * yvar)
         }
         case YVAR_TYPE_LIST:
         {
+            // clone packs vars into full nodes.
+            ysize_t cnt = yvar_count(*yvar);
+
             FOREACH_YVAR_LIST(*yvar, value) {
-                size += _yvar_mem_size(value) + ybuffer_round_up(sizeof(ylist_node_t) - sizeof(yvar_t));
+                size += _yvar_mem_size(value, context) - ybuffer_round_up(sizeof(yvar_t));
+            }
+
+            size += ybuffer_round_up(sizeof(ylist_node_t)) * ((cnt + YLIST_NODE_CAPACITY - 1) / YLIST_NODE_CAPACITY);
+            break;
+        }
+        case YVAR_TYPE_PACKED_ARRAY:
+            size += ybuffer_round_up(_YVAR_PACKED_ARRAY_MEM_SIZE(yvar));
+            break;
+        case YVAR_TYPE_STRIDED_ARRAY:
+        {
+            // strided array is cloned to a generic array
+            ysize_t cnt = yvar->data.ystrided_array_data.size;
+            ysize_t index;
+
+            for (index = 0; index < cnt; index++) {
+                size += _yvar_mem_size(_YVAR_STRIDED_ARRAY_VAR(yvar, index), context) - ybuffer_round_up(sizeof(yvar_t));
             }
 
+            size += ybuffer_round_up(cnt * sizeof(yvar_t));
             break;
         }
         case YVAR_TYPE_MAP:
-            size += _yvar_mem_size(yvar->data.ymap_data.keys);
-            size += _yvar_mem_size(yvar->data.ymap_data.values);
+        {
+            const yvar_t * keys = yvar->data.ymap_data.keys;
+            ysize_t slot = _YVAR_CLONE_CACHE_SLOT(keys, YVAR_CLONE_KEYS_CACHE_SIZE);
+
+            // keys are shared with a map counted before
+            if (context->keys[slot].src != keys) {
+                context->keys[slot].src = keys;
+                context->keys[slot].dst = NULL;
+                size += _yvar_mem_size(keys, context);
+                size += _yvar_map_index_mem_size(yvar);
+            }
+
+            size += _yvar_mem_size(yvar->data.ymap_data.values, context);
             break;
+        }
         case YVAR_TYPE_STR:
         case YVAR_TYPE_CSTR:
-            size += ybuffer_round_up((yvar_cstr_strlen(*yvar)) + 1);
+        {
+            const char * str = yvar->data.ycstr_data.str;
+            ysize_t len = yvar_cstr_strlen(*yvar);
+            ysize_t slot = _YVAR_CLONE_CACHE_SLOT(str, YVAR_CLONE_STR_CACHE_SIZE);
+
+            // short str is stored inside var
+            if (yvar_has_option(*yvar, YVAR_OPTION_INLINE) || len <= YVAR_INLINE_STR_MAX_SIZE) {
+                break;
+            }
+
+            // str is interned
+            if (str && context->strs[slot].src == str && context->strs[slot].size == len) {
+                break;
+            }
+
+            if (str) {
+                context->strs[slot].src = str;
+                context->strs[slot].size = len;
+                context->strs[slot].dst = NULL;
+            }
+
+            size += ybuffer_round_up(YVAR_STR_HASH_SIZE + len + 1);
             break;
+        }
     }
 
     return size;
 }
 
+/**
+ * allocate memory for a clone.
+ * if buffer is NULL, memory is bump allocated from thread arena as clone goes.
+ */
+static inline void * _yvar_clone_alloc(ybuffer_t * buffer, ysize_t size)
+{
+    return buffer? ybuffer_alloc(buffer, size): ybuffer_simple_alloc(size);
+}
+
 /**
  * clone internal elements of a var in a given buffer.
+ * if buffer is NULL, clone in thread arena and take list nodes from thread slab pool.
+ * strs and map keys seen before in the same clone are interned thru context.
  */
-static ybool_t _yvar_clone_internal_element(ybuffer_t * buffer, yvar_t * new_var, const yvar_t * old_var)
+static ybool_t _yvar_clone_internal_element(ybuffer_t * buffer, yvar_t * new_var, const yvar_t * old_var,
+    yvar_clone_context_t * context)
 {
-    YUKI_ASSERT(buffer && new_var && old_var);
+    YUKI_ASSERT(new_var && old_var && context);
 
     yvar_memzero(*new_var);
 
+    // frozen element, e.g. a frozen id list in where conditions, is shared instead of copied.
+    if (context->share_frozen) {
+        yvar_t * root = _yvar_frozen_root(old_var);
+
+        if (root) {
+            if (!_yvar_frozen_retain_until_clean_up(root)) {
+                return yfalse;
+            }
+
+            *new_var = *old_var;
+            return ytrue;
+        }
+    }
+
     if (!yvar_assign(*new_var, *old_var)) {
         YUKI_LOG_FATAL("cannot assign new value");
         return yfalse;
@@ -135,7 +627,7 @@ static ybool_t _yvar_clone_internal_element(ybuffer_t * buffer, yvar_t * new_var
     switch (old_var->type) {
         case YVAR_TYPE_ARRAY:
         {
-            yvar_t * yvars = (yvar_t*)ybuffer_alloc(buffer, old_var->data.yarray_data.size * sizeof(yvar_t));
+            yvar_t * yvars = (yvar_t*)_yvar_clone_alloc(buffer, old_var->data.yarray_data.size * sizeof(yvar_t));
 
             if (!yvars) {
                 YUKI_LOG_WARNING("out of memory");
@@ -145,7 +637,7 @@ static ybool_t _yvar_clone_internal_element(ybuffer_t * buffer, yvar_t * new_var
             ysize_t cnt = 0;
 
             FOREACH_YVAR_ARRAY(*old_var, value) {
-                if (!_yvar_clone_internal_element(buffer, yvars + cnt, value)) {
+                if (!_yvar_clone_internal_element(buffer, yvars + cnt, value, context)) {
                     YUKI_LOG_WARNING("fail to clone internal buffer");
                     return yfalse;
                 }
@@ -155,14 +647,22 @@ static ybool_t _yvar_clone_internal_element(ybuffer_t * buffer, yvar_t * new_var
 
             new_var->data.yarray_data.yvars = yvars;
 
+            // cloned array has no capacity
+            yvar_unset_option(*new_var, YVAR_OPTION_GROWABLE);
             break;
         }
         case YVAR_TYPE_LIST:
         {
             yvar_t list = YVAR_LIST();
+            yvar_t node = YVAR_EMPTY();
 
             FOREACH_YVAR_LIST(*old_var, value) {
-                if (!_yvar_list_push_back_internal(buffer, &list, value, ytrue)) {
+                if (!_yvar_clone_internal_element(buffer, &node, value, context)) {
+                    YUKI_LOG_WARNING("cannot clone value to node");
+                    return yfalse;
+                }
+
+                if (!_yvar_list_push_back_internal(buffer, &list, &node)) {
                     YUKI_LOG_WARNING("cannot add new node");
                     return yfalse;
                 }
@@ -173,102 +673,328 @@ static ybool_t _yvar_clone_internal_element(ybuffer_t * buffer, yvar_t * new_var
 
             break;
         }
-        case YVAR_TYPE_MAP:
+        case YVAR_TYPE_PACKED_ARRAY:
         {
-            yvar_t * keys = ybuffer_smart_alloc(buffer, yvar_t);
-
-            if (!keys) {
-                YUKI_LOG_WARNING("out of memory");
-                return yfalse;
-            }
+            ysize_t size = _YVAR_PACKED_ARRAY_MEM_SIZE(old_var);
 
-            if (!_yvar_clone_internal_element(buffer, keys, old_var->data.ymap_data.keys)) {
-                YUKI_LOG_WARNING("fail to clone internal buffer");
-                return yfalse;
+            if (!size) {
+                new_var->data.ypacked_array_data.items = NULL;
+                break;
             }
 
-            yvar_t * values = ybuffer_smart_alloc(buffer, yvar_t);
+            void * items = _yvar_clone_alloc(buffer, size);
 
-            if (!values) {
+            if (!items) {
                 YUKI_LOG_WARNING("out of memory");
                 return yfalse;
             }
 
-            if (!_yvar_clone_internal_element(buffer, values, old_var->data.ymap_data.values)) {
-                YUKI_LOG_WARNING("fail to clone internal buffer");
-                return yfalse;
-            }
-
-            new_var->data.ymap_data.keys = keys;
-            new_var->data.ymap_data.values = values;
-
+            memcpy(items, old_var->data.ypacked_array_data.items, size);
+            new_var->data.ypacked_array_data.items = items;
             break;
         }
-        case YVAR_TYPE_CSTR:
-        case YVAR_TYPE_STR:
+        case YVAR_TYPE_STRIDED_ARRAY:
         {
-            // the len includes '\0'
-            ysize_t len = yvar_cstr_strlen(*old_var) + 1;
-            char * dest = (char *)ybuffer_alloc(buffer, len);
+            ysize_t cnt = old_var->data.ystrided_array_data.size;
+            yvar_t * yvars = (yvar_t*)_yvar_clone_alloc(buffer, cnt * sizeof(yvar_t));
+            ysize_t index;
 
-            if (!dest) {
+            if (!yvars) {
                 YUKI_LOG_WARNING("out of memory");
                 return yfalse;
             }
 
-            strncpy(dest, yvar_cstr_buffer(*old_var), len);
-            yvar_str_buffer(*new_var) = dest;
+            for (index = 0; index < cnt; index++) {
+                if (!_yvar_clone_internal_element(buffer, yvars + index, _YVAR_STRIDED_ARRAY_VAR(old_var, index), context)) {
+                    YUKI_LOG_WARNING("fail to clone internal buffer");
+                    return yfalse;
+                }
+            }
+
+            // only viewed vars are copied. clone is a generic array.
+            yarray_t array = {cnt, yvars};
+            new_var->type = YVAR_TYPE_ARRAY;
+            new_var->data.yarray_data = array;
             break;
         }
-    }
-
-    return ytrue;
-}
+        case YVAR_TYPE_MAP:
+        {
+            const yvar_t * old_keys = old_var->data.ymap_data.keys;
+            ysize_t slot = _YVAR_CLONE_CACHE_SLOT(old_keys, YVAR_CLONE_KEYS_CACHE_SIZE);
+            yvar_t * keys = NULL;
+            ybool_t hashed = yfalse;
+
+            // maps sharing one keys var, e.g. rows in a result set, share cloned keys and index.
+            if (context->keys[slot].src == old_keys) {
+                YUKI_ASSERT(context->keys[slot].dst);
+                keys = context->keys[slot].dst;
+                hashed = context->keys[slot].hashed;
+            } else {
+                context->keys[slot].src = old_keys;
+                context->keys[slot].dst = NULL;
+
+                // index memory must be right before keys var. allocate them together.
+                ysize_t capacity = _yvar_map_index_capacity(old_var);
+                ysize_t index_size = _yvar_map_index_mem_size(old_var);
+                char * mem = (char *)_yvar_clone_alloc(buffer, index_size + sizeof(yvar_t));
+
+                if (!mem) {
+                    YUKI_LOG_WARNING("out of memory");
+                    return yfalse;
+                }
+
+                keys = (yvar_t *)(mem + index_size);
+
+                if (!_yvar_clone_internal_element(buffer, keys, old_keys, context)) {
+                    YUKI_LOG_WARNING("fail to clone internal buffer");
+                    return yfalse;
+                }
+
+                if (capacity) {
+                    _yvar_map_index_build(keys, capacity);
+                    hashed = ytrue;
+                }
+
+                // cache entry may be taken by nested maps in keys
+                if (context->keys[slot].src == old_keys) {
+                    context->keys[slot].dst = keys;
+                    context->keys[slot].hashed = hashed;
+                }
+            }
+
+            yvar_t * values = (yvar_t *)_yvar_clone_alloc(buffer, sizeof(yvar_t));
+
+            if (!values) {
+                YUKI_LOG_WARNING("out of memory");
+                return yfalse;
+            }
+
+            if (!_yvar_clone_internal_element(buffer, values, old_var->data.ymap_data.values, context)) {
+                YUKI_LOG_WARNING("fail to clone internal buffer");
+                return yfalse;
+            }
+
+            new_var->data.ymap_data.keys = keys;
+            new_var->data.ymap_data.values = values;
+
+            if (hashed) {
+                yvar_set_option(*new_var, YVAR_OPTION_HASHED);
+            } else {
+                yvar_unset_option(*new_var, YVAR_OPTION_HASHED);
+            }
+
+            break;
+        }
+        case YVAR_TYPE_CSTR:
+        case YVAR_TYPE_STR:
+        {
+            // chars have been copied by yvar_assign()
+            if (yvar_has_option(*old_var, YVAR_OPTION_INLINE)) {
+                break;
+            }
+
+            const char * str = old_var->data.ycstr_data.str;
+            ysize_t len = yvar_cstr_strlen(*old_var);
+            ysize_t slot = _YVAR_CLONE_CACHE_SLOT(str, YVAR_CLONE_STR_CACHE_SIZE);
+
+            // short str is stored inside var. it needs no memory and no cached hash.
+            if (len <= YVAR_INLINE_STR_MAX_SIZE) {
+                yinline_str_t inline_str;
+
+                if (len) {
+                    memcpy(inline_str.str, str, len);
+                }
+
+                inline_str.str[len] = '\0';
+                inline_str.size = (yuint8_t)len;
+                new_var->data.yinline_str_data = inline_str;
+                yvar_unset_option(*new_var, YVAR_OPTION_HASHED | YVAR_OPTION_INTERNED);
+                yvar_set_option(*new_var, YVAR_OPTION_INLINE);
+                break;
+            }
+
+            if (str && context->strs[slot].src == str && context->strs[slot].size == len) {
+                YUKI_ASSERT(context->strs[slot].dst);
+                yvar_str_buffer_ref(*new_var) = context->strs[slot].dst;
+                yvar_set_option(*new_var, YVAR_OPTION_HASHED | YVAR_OPTION_INTERNED);
+                break;
+            }
+
+            // hash is stored before chars. chars end with '\0'.
+            char * dest = (char *)_yvar_clone_alloc(buffer, YVAR_STR_HASH_SIZE + len + 1);
+
+            if (!dest) {
+                YUKI_LOG_WARNING("out of memory");
+                return yfalse;
+            }
+
+            dest += YVAR_STR_HASH_SIZE;
+
+            if (len) {
+                memcpy(dest, str, len);
+            }
+
+            dest[len] = '\0';
+            *(yuint32_t *)(dest - YVAR_STR_HASH_SIZE) = _yvar_hash(old_var);
+            yvar_str_buffer_ref(*new_var) = dest;
+
+            // later strs with the same source share chars. they are read-only since now.
+            yvar_set_option(*new_var, YVAR_OPTION_HASHED | YVAR_OPTION_INTERNED);
+
+            if (str) {
+                context->strs[slot].src = str;
+                context->strs[slot].size = len;
+                context->strs[slot].dst = dest;
+            }
+
+            break;
+        }
+    }
+
+    return ytrue;
+}
+
+/**
+ * get temp memory for sort and merge.
+ * stack memory of caller is used if it's large enough. otherwise, memory is malloc-ed.
+ * thread memory is not touched, so detach window and slab pools are left alone.
+ */
+static void * _yvar_scratch_alloc(void * stack, ysize_t stack_size, ysize_t size)
+{
+    if (size <= stack_size) {
+        return stack;
+    }
+
+    void * ptr = malloc(size);
+
+    if (!ptr) {
+        YUKI_LOG_WARNING("out of memory. [size: %lu]", size);
+    }
+
+    return ptr;
+}
+
+static void _yvar_scratch_free(void * stack, void * ptr)
+{
+    if (ptr != stack) {
+        free(ptr);
+    }
+}
+
+/**
+ * stable merge sort of src[order[0..size)] by key.
+ * order and tmp are index arrays with size items.
+ */
+static void _yvar_map_merge_sort(yvar_map_kv_t src, ysize_t order[], ysize_t tmp[], ysize_t size)
+{
+    if (size < 2) {
+        return;
+    }
+
+    ysize_t half = size / 2;
+    _yvar_map_merge_sort(src, order, tmp, half);
+    _yvar_map_merge_sort(src, order + half, tmp, size - half);
+
+    // already in order
+    if (_yvar_compare(&src[order[half - 1]][0], &src[order[half]][0]) <= 0) {
+        return;
+    }
+
+    ysize_t left = 0;
+    ysize_t right = half;
+    ysize_t index = 0;
+
+    while (left < half && right < size) {
+        // take left one on equal keys to keep sort stable
+        if (_yvar_compare(&src[order[right]][0], &src[order[left]][0]) < 0) {
+            tmp[index++] = order[right++];
+        } else {
+            tmp[index++] = order[left++];
+        }
+    }
+
+    while (left < half) {
+        tmp[index++] = order[left++];
+    }
+
+    memcpy(order, tmp, right * sizeof(ysize_t));
+}
 
 static ybool_t _yvar_map_assoc_array_sort(yvar_map_kv_t src, ysize_t src_size,
     yvar_t even_dst[], ysize_t even_size,
-    yvar_t odd_dst[], ysize_t odd_size)
+    yvar_t odd_dst[], ysize_t odd_size,
+    ybool_t need_sort)
 {
     YUKI_ASSERT(src && even_dst && odd_dst);
     YUKI_ASSERT(src_size == odd_size);
     YUKI_ASSERT(src_size == even_size);
 
-    // copy odd value to odd array, even to even array
     ysize_t index = 0;
+
+    if (!need_sort) {
+        // copy odd value to odd array, even to even array
+        for (; index < src_size; index++) {
+            // NOTE: don't use yvar_assign, as dst is not initialized.
+            even_dst[index] = src[index][0];
+            odd_dst[index] = src[index][1];
+        }
+
+        return ytrue;
+    }
+
+    // sort indexes in temp memory. values move together with keys.
+    yuint64_t stack[YVAR_SCRATCH_STACK_SIZE / sizeof(yuint64_t)];
+    ysize_t * order = (ysize_t *)_yvar_scratch_alloc(stack, sizeof(stack), 2 * src_size * sizeof(ysize_t));
+
+    if (!order) {
+        return yfalse;
+    }
+
+    ysize_t * tmp = order + src_size;
+
     for (; index < src_size; index++) {
-        // NOTE: don't use yvar_assign, as dst is not initialized.
-        even_dst[index] = src[index][0];
-        odd_dst[index] = src[index][1];
+        order[index] = index;
     }
 
-    // TODO: sort array
+    _yvar_map_merge_sort(src, order, tmp, src_size);
+
+    for (index = 0; index < src_size; index++) {
+        even_dst[index] = src[order[index]][0];
+        odd_dst[index] = src[order[index]][1];
+    }
 
+    _yvar_scratch_free(stack, order);
     return ytrue;
 }
 
-static ybool_t _yvar_clone_internal(ybuffer_t * buffer, yvar_t ** new_var, const yvar_t * old_var)
+/**
+ * clone a var in a buffer sized by _yvar_mem_size().
+ * if buffer is NULL, clone in thread arena in one pass.
+ * if share_frozen is true, frozen elements are shared until current thread cleans up.
+ */
+static ybool_t _yvar_clone_internal(ybuffer_t * buffer, yvar_t ** new_var, const yvar_t * old_var,
+    ybool_t share_frozen)
 {
     YUKI_ASSERT(new_var);
 
-    if (!buffer) {
-        YUKI_LOG_WARNING("out of memory");
-        return yfalse;
-    }
-
-    yvar_t * yvar = ybuffer_smart_alloc(buffer, yvar_t);
+    yvar_t * yvar = (yvar_t *)_yvar_clone_alloc(buffer, sizeof(yvar_t));
 
     if (!yvar) {
         YUKI_LOG_WARNING("out of memory");
         return yfalse;
     }
 
-    if (!_yvar_clone_internal_element(buffer, yvar, old_var)) {
+    yvar_clone_context_t context;
+    memset(&context, 0, sizeof(context));
+    context.share_frozen = share_frozen;
+
+    if (!_yvar_clone_internal_element(buffer, yvar, old_var, &context)) {
         YUKI_LOG_WARNING("fail to clone internal element");
         return yfalse;
     }
 
     // buffer MUST be empty.
-    YUKI_ASSERT(!ybuffer_available_size(buffer));
+    YUKI_ASSERT(!buffer || !ybuffer_available_size(buffer));
 
     YUKI_LOG_DEBUG("var is cloned");
     yvar_set_option(*yvar, YVAR_OPTION_HOLD_RESOURCE);
@@ -276,52 +1002,82 @@ static ybool_t _yvar_clone_internal(ybuffer_t * buffer, yvar_t ** new_var, const
     return ytrue;
 }
 
-static ybool_t _yvar_list_push_back_internal(ybuffer_t * buffer, yvar_t * list, const yvar_t * var, ybool_t need_clone)
+/**
+ * append a var to list.
+ * var is stored in tail node if it has room. otherwise, a new node is allocated in buffer.
+ * if buffer is NULL, node is taken from thread slab pool.
+ */
+static ybool_t _yvar_list_push_back_internal(ybuffer_t * buffer, yvar_t * list, const yvar_t * var)
 {
-    YUKI_ASSERT(buffer && list && var);
+    YUKI_ASSERT(list && var);
 
-    ylist_node_t * node = ybuffer_smart_alloc(buffer, ylist_node_t);
+    ylist_node_t * node = list->data.ylist_data.tail;
 
-    if (!node) {
-        YUKI_LOG_WARNING("out of memory");
-        return yfalse;
-    }
+    if (!node || node->end == YLIST_NODE_CAPACITY) {
+        node = buffer? ybuffer_smart_alloc(buffer, ylist_node_t): ybuffer_slab_smart_alloc(ylist_node_t);
 
-    if (need_clone) {
-        if (!_yvar_clone_internal_element(buffer, &node->yvar, var)) {
-            YUKI_LOG_WARNING("cannot clone value to node");
+        if (!node) {
+            YUKI_LOG_WARNING("out of memory");
             return yfalse;
         }
-    } else {
-        yvar_memzero(node->yvar);
 
-        if (!yvar_assign(node->yvar, *var)) {
-            YUKI_LOG_WARNING("cannot assign new value to node");
-            return yfalse;
+        node->begin = 0;
+        node->end = 0;
+        node->flags = buffer? 0: YLIST_NODE_FLAG_SLAB;
+        node->count = 0;
+        node->next = NULL;
+        node->prev = list->data.ylist_data.tail;
+
+        // if list is empty, change both head and tail.
+        if (!list->data.ylist_data.head) {
+            YUKI_ASSERT(!list->data.ylist_data.tail);
+            list->data.ylist_data.head = node;
+        } else {
+            YUKI_ASSERT(list->data.ylist_data.tail);
+            list->data.ylist_data.tail->next = node;
         }
-    }
 
-    // if list is empty, change both head and tail.
-    if (!list->data.ylist_data.head) {
-        YUKI_ASSERT(!list->data.ylist_data.tail);
-
-        list->data.ylist_data.head = node;
         list->data.ylist_data.tail = node;
-        node->next = NULL;
-        node->prev = NULL;
-    } else {
-        YUKI_ASSERT(list->data.ylist_data.tail);
+    }
 
-        ylist_node_t * old_tail = list->data.ylist_data.tail;
-        old_tail->next = node;
-        node->prev = old_tail;
-        node->next = NULL;
-        list->data.ylist_data.tail = node;
+    yvar_memzero(node->yvars[node->end]);
+
+    if (!yvar_assign(node->yvars[node->end], *var)) {
+        YUKI_LOG_WARNING("cannot assign new value to node");
+        return yfalse;
     }
 
+    node->end++;
+    list->data.ylist_data.head->count++;
     return ytrue;
 }
 
+/**
+ * get next var in an unrolled list.
+ * if value is NULL, get first var in node. node is moved forward when current node is exhausted.
+ * return NULL if there is no more var.
+ */
+static const yvar_t * _yvar_list_next(const ylist_node_t ** node, const yvar_t * value)
+{
+    if (!*node) {
+        return NULL;
+    }
+
+    if (value && ++value != (*node)->yvars + (*node)->end) {
+        return value;
+    }
+
+    if (value) {
+        *node = (*node)->next;
+
+        if (!*node) {
+            return NULL;
+        }
+    }
+
+    return (*node)->yvars + (*node)->begin;
+}
+
 #define _YUKI_YVAR_TO_TYPE_FUNCTION(type) \
     y##type##_t _yvar_to_##type(const yvar_t * yvar) \
     { \
@@ -373,14 +1129,18 @@ ybool_t _yvar_get_bool(const yvar_t * yvar, ybool_t * output)
             *output = yvar->data.yuint32_data? ytrue: yfalse;
             break;
         case YVAR_TYPE_CSTR:
-            *output = yvar->data.ycstr_data.size? ytrue: yfalse;
-            break;
         case YVAR_TYPE_STR:
-            *output = yvar->data.ystr_data.size? ytrue: yfalse;
+            *output = _YVAR_STR_SIZE(yvar)? ytrue: yfalse;
             break;
         case YVAR_TYPE_ARRAY:
             *output = yvar->data.yarray_data.size? ytrue: yfalse;
             break;
+        case YVAR_TYPE_PACKED_ARRAY:
+            *output = yvar->data.ypacked_array_data.size? ytrue: yfalse;
+            break;
+        case YVAR_TYPE_STRIDED_ARRAY:
+            *output = yvar->data.ystrided_array_data.size? ytrue: yfalse;
+            break;
         case YVAR_TYPE_LIST:
             *output = yvar->data.ylist_data.head? ytrue: yfalse;
             YUKI_ASSERT(*output || !yvar->data.ylist_data.tail);
@@ -477,6 +1237,8 @@ ybool_t _yvar_get_int8(const yvar_t * yvar, yint8_t * output)
             YUKI_LOG_DEBUG("str cannot be converted to int8");
             return yfalse;
         case YVAR_TYPE_ARRAY:
+        case YVAR_TYPE_PACKED_ARRAY:
+        case YVAR_TYPE_STRIDED_ARRAY:
             YUKI_LOG_DEBUG("array cannot be converted to int8");
             return yfalse;
         case YVAR_TYPE_LIST:
@@ -573,6 +1335,8 @@ ybool_t _yvar_get_uint8(const yvar_t * yvar, yuint8_t * output)
             YUKI_LOG_DEBUG("str cannot be converted to uint8");
             return yfalse;
         case YVAR_TYPE_ARRAY:
+        case YVAR_TYPE_PACKED_ARRAY:
+        case YVAR_TYPE_STRIDED_ARRAY:
             YUKI_LOG_DEBUG("array cannot be converted to uint8");
             return yfalse;
         case YVAR_TYPE_LIST:
@@ -659,6 +1423,8 @@ ybool_t _yvar_get_int16(const yvar_t * yvar, yint16_t * output)
             YUKI_LOG_DEBUG("str cannot be converted to int16");
             return yfalse;
         case YVAR_TYPE_ARRAY:
+        case YVAR_TYPE_PACKED_ARRAY:
+        case YVAR_TYPE_STRIDED_ARRAY:
             YUKI_LOG_DEBUG("array cannot be converted to int16");
             return yfalse;
         case YVAR_TYPE_LIST:
@@ -750,6 +1516,8 @@ ybool_t _yvar_get_uint16(const yvar_t * yvar, yuint16_t * output)
             YUKI_LOG_DEBUG("str cannot be converted to uint16");
             return yfalse;
         case YVAR_TYPE_ARRAY:
+        case YVAR_TYPE_PACKED_ARRAY:
+        case YVAR_TYPE_STRIDED_ARRAY:
             YUKI_LOG_DEBUG("array cannot be converted to uint16");
             return yfalse;
         case YVAR_TYPE_LIST:
@@ -826,6 +1594,8 @@ ybool_t _yvar_get_int32(const yvar_t * yvar, yint32_t * output)
             YUKI_LOG_DEBUG("str cannot be converted to int32");
             return yfalse;
         case YVAR_TYPE_ARRAY:
+        case YVAR_TYPE_PACKED_ARRAY:
+        case YVAR_TYPE_STRIDED_ARRAY:
             YUKI_LOG_DEBUG("array cannot be converted to int32");
             return yfalse;
         case YVAR_TYPE_LIST:
@@ -912,6 +1682,8 @@ ybool_t _yvar_get_uint32(const yvar_t * yvar, yuint32_t * output)
             YUKI_LOG_DEBUG("str cannot be converted to uint32");
             return yfalse;
         case YVAR_TYPE_ARRAY:
+        case YVAR_TYPE_PACKED_ARRAY:
+        case YVAR_TYPE_STRIDED_ARRAY:
             YUKI_LOG_DEBUG("array cannot be converted to uint32");
             return yfalse;
         case YVAR_TYPE_LIST:
@@ -978,6 +1750,8 @@ ybool_t _yvar_get_int64(const yvar_t * yvar, yint64_t * output)
             YUKI_LOG_DEBUG("str cannot be converted to int64");
             return yfalse;
         case YVAR_TYPE_ARRAY:
+        case YVAR_TYPE_PACKED_ARRAY:
+        case YVAR_TYPE_STRIDED_ARRAY:
             YUKI_LOG_DEBUG("array cannot be converted to int64");
             return yfalse;
         case YVAR_TYPE_LIST:
@@ -1059,6 +1833,8 @@ ybool_t _yvar_get_uint64(const yvar_t * yvar, yuint64_t * output)
             YUKI_LOG_DEBUG("str cannot be converted to uint64");
             return yfalse;
         case YVAR_TYPE_ARRAY:
+        case YVAR_TYPE_PACKED_ARRAY:
+        case YVAR_TYPE_STRIDED_ARRAY:
             YUKI_LOG_DEBUG("array cannot be converted to uint64");
             return yfalse;
         case YVAR_TYPE_LIST:
@@ -1111,8 +1887,10 @@ ybool_t _yvar_get_cstr(const yvar_t * yvar, char * output, ysize_t size)
             return _yuint64_to_str(yvar->data.yuint64_data, output, size);
         case YVAR_TYPE_CSTR:
         case YVAR_TYPE_STR:
-            return _ycstr_to_str(&yvar->data.ycstr_data, output, size);
+            return _ycstr_to_str(yvar, output, size);
         case YVAR_TYPE_ARRAY:
+        case YVAR_TYPE_PACKED_ARRAY:
+        case YVAR_TYPE_STRIDED_ARRAY:
             YUKI_LOG_DEBUG("array cannot be converted to str or cstr");
             return yfalse;
         case YVAR_TYPE_LIST:
@@ -1129,6 +1907,69 @@ ybool_t _yvar_get_cstr(const yvar_t * yvar, char * output, ysize_t size)
     return ytrue;
 }
 
+/**
+ * parse a numeric str to an int64 or uint64 var.
+ */
+static ybool_t _yvar_str_to_number(const yvar_t * yvar, yvar_t * number)
+{
+    YUKI_ASSERT(yvar && number);
+
+    yuint64_t abs_value;
+    ybool_t negative;
+
+    if (!_ystr_to_digits(yvar_cstr_buffer(*yvar), _YVAR_STR_SIZE(yvar), &abs_value, &negative)) {
+        return yfalse;
+    }
+
+    if (!negative) {
+        yvar_uint64(*number, abs_value);
+        return ytrue;
+    }
+
+    if (abs_value > (yuint64_t)YUKI_MAX_INT64_VALUE + 1) {
+        YUKI_LOG_DEBUG("value is overflow");
+        return yfalse;
+    }
+
+    yvar_int64(*number, abs_value == (yuint64_t)YUKI_MAX_INT64_VALUE + 1?
+        YUKI_MIN_INT64_VALUE: -(yint64_t)abs_value);
+    return ytrue;
+}
+
+/**
+ * same as yvar_get_xxx() except that numeric str is parsed.
+ * range of parsed value is checked by getter.
+ */
+#define _YUKI_YVAR_PARSE_FUNCTION(t) \
+    ybool_t _yvar_parse_##t(const yvar_t * yvar, y##t##_t * output) \
+    { \
+        if (!yvar || !output) { \
+            YUKI_LOG_FATAL("invalid param"); \
+            return yfalse; \
+        } \
+        \
+        if (!yvar_like_string(*yvar)) { \
+            return _yvar_get_##t(yvar, output); \
+        } \
+        \
+        yvar_t number = YVAR_EMPTY(); \
+        \
+        if (!_yvar_str_to_number(yvar, &number)) { \
+            return yfalse; \
+        } \
+        \
+        return _yvar_get_##t(&number, output); \
+    }
+
+_YUKI_YVAR_PARSE_FUNCTION(int8)
+_YUKI_YVAR_PARSE_FUNCTION(uint8)
+_YUKI_YVAR_PARSE_FUNCTION(int16)
+_YUKI_YVAR_PARSE_FUNCTION(uint16)
+_YUKI_YVAR_PARSE_FUNCTION(int32)
+_YUKI_YVAR_PARSE_FUNCTION(uint32)
+_YUKI_YVAR_PARSE_FUNCTION(int64)
+_YUKI_YVAR_PARSE_FUNCTION(uint64)
+
 ybool_t _yvar_like_string(const yvar_t * yvar)
 {
     return yvar? (yvar_is_cstr(*yvar) || yvar_is_str(*yvar)): yfalse;
@@ -1193,16 +2034,12 @@ ysize_t _yvar_count(const yvar_t * yvar)
             return 1;
         case YVAR_TYPE_ARRAY:
             return yvar->data.yarray_data.size;
+        case YVAR_TYPE_PACKED_ARRAY:
+            return yvar->data.ypacked_array_data.size;
+        case YVAR_TYPE_STRIDED_ARRAY:
+            return yvar->data.ystrided_array_data.size;
         case YVAR_TYPE_LIST:
-        {
-            ysize_t cnt = 0;
-
-            FOREACH_YVAR_LIST(*yvar, value) {
-                cnt++;
-            }
-
-            return cnt;
-        }
+            return yvar->data.ylist_data.head? yvar->data.ylist_data.head->count: 0;
         case YVAR_TYPE_MAP:
             return _yvar_count(yvar->data.ymap_data.keys);
         default:
@@ -1250,19 +2087,31 @@ ybool_t _yvar_equal(const yvar_t * plhs, const yvar_t * prhs)
             return plhs->data.yuint64_data == prhs->data.yuint64_data;
         case YVAR_TYPE_CSTR:
         case YVAR_TYPE_STR:
-            if (plhs->data.ycstr_data.size != prhs->data.ycstr_data.size) {
+        {
+            ysize_t size = _YVAR_STR_SIZE(plhs);
+            const char * lhs_str = yvar_cstr_buffer(*plhs);
+            const char * rhs_str = yvar_cstr_buffer(*prhs);
+
+            if (size != _YVAR_STR_SIZE(prhs)) {
                 return yfalse;
             }
 
-            if (plhs->data.ycstr_data.str == prhs->data.ycstr_data.str) {
+            if (lhs_str == rhs_str) {
                 return ytrue;
             }
 
-            if (!plhs->data.ycstr_data.str || !prhs->data.ycstr_data.str) {
+            if (!lhs_str || !rhs_str) {
                 return yfalse;
             }
 
-            return !strcmp(plhs->data.ycstr_data.str, prhs->data.ycstr_data.str);
+            // cloned strs have hash
+            if (yvar_has_option(*plhs, YVAR_OPTION_HASHED) && yvar_has_option(*prhs, YVAR_OPTION_HASHED)
+                && _YVAR_STR_HASH(plhs) != _YVAR_STR_HASH(prhs)) {
+                return yfalse;
+            }
+
+            return !memcmp(lhs_str, rhs_str, size);
+        }
         case YVAR_TYPE_ARRAY:
         {
             ysize_t lhs_cnt = yvar_count(*plhs);
@@ -1283,21 +2132,25 @@ ybool_t _yvar_equal(const yvar_t * plhs, const yvar_t * prhs)
         }
         case YVAR_TYPE_LIST:
         {
-            ylist_node_t * lhs_head = plhs->data.ylist_data.head;
-            ylist_node_t * lhs_tail = plhs->data.ylist_data.tail;
-            ylist_node_t * rhs_head = prhs->data.ylist_data.head;
-            ylist_node_t * rhs_tail = prhs->data.ylist_data.tail;
+            if (yvar_count(*plhs) != yvar_count(*prhs)) {
+                return yfalse;
+            }
 
-            while (lhs_head != lhs_tail && rhs_head != rhs_tail) {
-                if (!yvar_equal(lhs_head->yvar, rhs_head->yvar)) {
+            const ylist_node_t * lhs_node = plhs->data.ylist_data.head;
+            const ylist_node_t * rhs_node = prhs->data.ylist_data.head;
+            const yvar_t * lhs_value = _yvar_list_next(&lhs_node, NULL);
+            const yvar_t * rhs_value = _yvar_list_next(&rhs_node, NULL);
+
+            while (lhs_value && rhs_value) {
+                if (!yvar_equal(*lhs_value, *rhs_value)) {
                     return yfalse;
                 }
 
-                lhs_head = lhs_head->next;
-                rhs_head = rhs_head->next;
+                lhs_value = _yvar_list_next(&lhs_node, lhs_value);
+                rhs_value = _yvar_list_next(&rhs_node, rhs_value);
             }
 
-            return lhs_head == lhs_tail && rhs_head == rhs_tail;
+            return ytrue;
         }
         case YVAR_TYPE_MAP:
             if (!yvar_equal(*plhs->data.ymap_data.keys, *prhs->data.ymap_data.keys)) {
@@ -1305,283 +2158,2530 @@ ybool_t _yvar_equal(const yvar_t * plhs, const yvar_t * prhs)
             }
 
             return yvar_equal(*plhs->data.ymap_data.values, *prhs->data.ymap_data.values);
+        case YVAR_TYPE_PACKED_ARRAY:
+        {
+            const ypacked_array_t * lhs = &plhs->data.ypacked_array_data;
+            const ypacked_array_t * rhs = &prhs->data.ypacked_array_data;
+
+            // items of different types are never equal, even if arrays are empty.
+            if (lhs->size != rhs->size || lhs->item_type != rhs->item_type) {
+                return yfalse;
+            }
+
+            if (!lhs->size || lhs->items == rhs->items) {
+                return ytrue;
+            }
+
+            return !memcmp(lhs->items, rhs->items, _YVAR_PACKED_ARRAY_MEM_SIZE(plhs));
+        }
+        case YVAR_TYPE_STRIDED_ARRAY:
+        {
+            ysize_t lhs_cnt = yvar_count(*plhs);
+            ysize_t rhs_cnt = yvar_count(*prhs);
+
+            if (lhs_cnt != rhs_cnt) {
+                return yfalse;
+            }
+
+            ysize_t cnt;
+            for (cnt = 0; cnt < lhs_cnt; cnt++) {
+                if (!yvar_equal(*_YVAR_STRIDED_ARRAY_VAR(plhs, cnt), *_YVAR_STRIDED_ARRAY_VAR(prhs, cnt))) {
+                    return yfalse;
+                }
+            }
+
+            return ytrue;
+        }
         default:
             YUKI_LOG_FATAL("impossible type value %d", plhs->type);
             return yfalse;
     }
 }
 
-ysize_t _yvar_cstr_strlen(const yvar_t * yvar)
-{
-    if (!yvar_like_string(*yvar)) {
-        YUKI_LOG_FATAL("var is not str or cstr");
-        return 0;
-    }
-
-    return yvar->data.ycstr_data.size;
-}
-
 /**
- * clone an array of array to a var.
- * it's designed to help ytable to clone field or condition easily.
- * the type of triple_array is yvar_t[size][dimension].
+ * box an item of packed array to a var. index must be in bound.
  */
-ybool_t _yvar_triple_array_clone(yvar_t ** array, yvar_triple_array_t triple_array, ysize_t size, ysize_t dimension)
+static void _yvar_packed_array_box(const yvar_t * packed, ysize_t index, yvar_t * output)
 {
-    if (!array || !triple_array || !*triple_array || !size || !dimension) {
-        YUKI_LOG_FATAL("invalid param");
-        return yfalse;
-    }
-
-    yvar_t raw_array[size];
-    ysize_t index;
-
-    for (index = 0; index < size; index++) {
-        yvar_array_with_size(raw_array[index], triple_array[index], dimension);
-    }
+    const void * items = packed->data.ypacked_array_data.items;
 
-    yvar_t the_array = YVAR_ARRAY_WITH_SIZE(raw_array, size);
-    return yvar_clone(*array, the_array);
-}
+    YUKI_ASSERT(index < packed->data.ypacked_array_data.size);
 
-/**
- * pin an array of array to a var.
- * it's designed to help ytable to pin field or condition easily.
- * the type of triple_array is yvar_t[size][dimension].
+    switch (packed->data.ypacked_array_data.item_type) {
+        case YVAR_TYPE_BOOL:
+            yvar_bool(*output, ((const ybool_t *)items)[index]);
+            break;
+        case YVAR_TYPE_INT8:
+            yvar_int8(*output, ((const yint8_t *)items)[index]);
+            break;
+        case YVAR_TYPE_UINT8:
+            yvar_uint8(*output, ((const yuint8_t *)items)[index]);
+            break;
+        case YVAR_TYPE_INT16:
+            yvar_int16(*output, ((const yint16_t *)items)[index]);
+            break;
+        case YVAR_TYPE_UINT16:
+            yvar_uint16(*output, ((const yuint16_t *)items)[index]);
+            break;
+        case YVAR_TYPE_INT32:
+            yvar_int32(*output, ((const yint32_t *)items)[index]);
+            break;
+        case YVAR_TYPE_UINT32:
+            yvar_uint32(*output, ((const yuint32_t *)items)[index]);
+            break;
+        case YVAR_TYPE_INT64:
+            yvar_int64(*output, ((const yint64_t *)items)[index]);
+            break;
+        case YVAR_TYPE_UINT64:
+            yvar_uint64(*output, ((const yuint64_t *)items)[index]);
+            break;
+        default:
+            YUKI_LOG_FATAL("impossible item type value %d", packed->data.ypacked_array_data.item_type);
+            yvar_undefined(*output);
+            break;
+    }
+}
+
+/**
+ * compare two strs by bytes and then by size.
+ * it's used by sort without type dispatch.
+ */
+static yint8_t _yvar_compare_str(const yvar_t * plhs, const yvar_t * prhs)
+{
+    const char * lhs_str = yvar_cstr_buffer(*plhs);
+    const char * rhs_str = yvar_cstr_buffer(*prhs);
+    ysize_t lhs_size = _YVAR_STR_SIZE(plhs);
+    ysize_t rhs_size = _YVAR_STR_SIZE(prhs);
+
+    if (lhs_str != rhs_str) {
+        // NULL str is less than any other str
+        if (!lhs_str || !rhs_str) {
+            return lhs_str? 1: -1;
+        }
+
+        ysize_t size = lhs_size < rhs_size? lhs_size: rhs_size;
+
+        // most strs differ in the first char
+        if (size && *lhs_str != *rhs_str) {
+            return (unsigned char)*lhs_str < (unsigned char)*rhs_str? -1: 1;
+        }
+
+        int ret = memcmp(lhs_str, rhs_str, size);
+
+        if (ret) {
+            return ret < 0? -1: 1;
+        }
+    }
+
+    return _YVAR_COMPARE_VALUE(lhs_size, rhs_size);
+}
+
+/**
+ * compare two vars. return -1, 0 or 1 if lhs is less than, equal to or greater than rhs.
+ * vars are ordered by type first and then by value. it returns 0 iff yvar_equal() is true.
+ */
+yint8_t _yvar_compare(const yvar_t * plhs, const yvar_t * prhs)
+{
+    if (plhs == prhs) {
+        return 0;
+    }
+
+    if (!plhs || !prhs) {
+        YUKI_LOG_DEBUG("NULL pointer in param");
+        return plhs? 1: -1;
+    }
+
+    if (plhs->type != prhs->type) {
+        return _YVAR_COMPARE_VALUE(plhs->type, prhs->type);
+    }
+
+    switch (plhs->type) {
+        case YVAR_TYPE_UNDEFINED:
+            return 0;
+        case YVAR_TYPE_BOOL:
+            return _YVAR_COMPARE_VALUE(plhs->data.ybool_data, prhs->data.ybool_data);
+        case YVAR_TYPE_INT8:
+            return _YVAR_COMPARE_VALUE(plhs->data.yint8_data, prhs->data.yint8_data);
+        case YVAR_TYPE_UINT8:
+            return _YVAR_COMPARE_VALUE(plhs->data.yuint8_data, prhs->data.yuint8_data);
+        case YVAR_TYPE_INT16:
+            return _YVAR_COMPARE_VALUE(plhs->data.yint16_data, prhs->data.yint16_data);
+        case YVAR_TYPE_UINT16:
+            return _YVAR_COMPARE_VALUE(plhs->data.yuint16_data, prhs->data.yuint16_data);
+        case YVAR_TYPE_INT32:
+            return _YVAR_COMPARE_VALUE(plhs->data.yint32_data, prhs->data.yint32_data);
+        case YVAR_TYPE_UINT32:
+            return _YVAR_COMPARE_VALUE(plhs->data.yuint32_data, prhs->data.yuint32_data);
+        case YVAR_TYPE_INT64:
+            return _YVAR_COMPARE_VALUE(plhs->data.yint64_data, prhs->data.yint64_data);
+        case YVAR_TYPE_UINT64:
+            return _YVAR_COMPARE_VALUE(plhs->data.yuint64_data, prhs->data.yuint64_data);
+        case YVAR_TYPE_CSTR:
+        case YVAR_TYPE_STR:
+            return _yvar_compare_str(plhs, prhs);
+        case YVAR_TYPE_ARRAY:
+        {
+            ysize_t lhs_cnt = yvar_count(*plhs);
+            ysize_t rhs_cnt = yvar_count(*prhs);
+            ysize_t cnt;
+            yint8_t ret;
+
+            for (cnt = 0; cnt < lhs_cnt && cnt < rhs_cnt; cnt++) {
+                ret = yvar_compare(plhs->data.yarray_data.yvars[cnt], prhs->data.yarray_data.yvars[cnt]);
+
+                if (ret) {
+                    return ret;
+                }
+            }
+
+            return _YVAR_COMPARE_VALUE(lhs_cnt, rhs_cnt);
+        }
+        case YVAR_TYPE_LIST:
+        {
+            const ylist_node_t * lhs_node = plhs->data.ylist_data.head;
+            const ylist_node_t * rhs_node = prhs->data.ylist_data.head;
+            const yvar_t * lhs_value = _yvar_list_next(&lhs_node, NULL);
+            const yvar_t * rhs_value = _yvar_list_next(&rhs_node, NULL);
+            yint8_t ret;
+
+            while (lhs_value && rhs_value) {
+                ret = yvar_compare(*lhs_value, *rhs_value);
+
+                if (ret) {
+                    return ret;
+                }
+
+                lhs_value = _yvar_list_next(&lhs_node, lhs_value);
+                rhs_value = _yvar_list_next(&rhs_node, rhs_value);
+            }
+
+            return _YVAR_COMPARE_VALUE(lhs_value != NULL, rhs_value != NULL);
+        }
+        case YVAR_TYPE_MAP:
+        {
+            yint8_t ret = yvar_compare(*plhs->data.ymap_data.keys, *prhs->data.ymap_data.keys);
+
+            if (ret) {
+                return ret;
+            }
+
+            return yvar_compare(*plhs->data.ymap_data.values, *prhs->data.ymap_data.values);
+        }
+        case YVAR_TYPE_PACKED_ARRAY:
+        {
+            ysize_t lhs_cnt = yvar_count(*plhs);
+            ysize_t rhs_cnt = yvar_count(*prhs);
+            ysize_t cnt;
+            yvar_t lhs_value = YVAR_EMPTY();
+            yvar_t rhs_value = YVAR_EMPTY();
+            yint8_t ret;
+
+            for (cnt = 0; cnt < lhs_cnt && cnt < rhs_cnt; cnt++) {
+                _yvar_packed_array_box(plhs, cnt, &lhs_value);
+                _yvar_packed_array_box(prhs, cnt, &rhs_value);
+                ret = yvar_compare(lhs_value, rhs_value);
+
+                if (ret) {
+                    return ret;
+                }
+            }
+
+            return _YVAR_COMPARE_VALUE(lhs_cnt, rhs_cnt);
+        }
+        case YVAR_TYPE_STRIDED_ARRAY:
+        {
+            ysize_t lhs_cnt = yvar_count(*plhs);
+            ysize_t rhs_cnt = yvar_count(*prhs);
+            ysize_t cnt;
+            yint8_t ret;
+
+            for (cnt = 0; cnt < lhs_cnt && cnt < rhs_cnt; cnt++) {
+                ret = yvar_compare(*_YVAR_STRIDED_ARRAY_VAR(plhs, cnt), *_YVAR_STRIDED_ARRAY_VAR(prhs, cnt));
+
+                if (ret) {
+                    return ret;
+                }
+            }
+
+            return _YVAR_COMPARE_VALUE(lhs_cnt, rhs_cnt);
+        }
+        default:
+            YUKI_LOG_FATAL("impossible type value %d", plhs->type);
+            return 0;
+    }
+}
+
+ysize_t _yvar_cstr_strlen(const yvar_t * yvar)
+{
+    if (!yvar_like_string(*yvar)) {
+        YUKI_LOG_FATAL("var is not str or cstr");
+        return 0;
+    }
+
+    return _YVAR_STR_SIZE(yvar);
+}
+
+/**
+ * give a str var its own copy of chars, so that they can be modified thru yvar_cstr_buffer().
+ * chars of a cloned str are interned and may be shared by other strs in the same clone.
+ * they are copied to thread memory and cached hash is dropped.
+ * str which owns its chars, e.g. a short str stored inside var, is not changed.
+ */
+ybool_t _yvar_str_unshare(yvar_t * yvar)
+{
+    if (!yvar || !yvar_like_string(*yvar)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (!yvar_has_option(*yvar, YVAR_OPTION_INTERNED | YVAR_OPTION_HASHED)) {
+        return ytrue;
+    }
+
+    if (yvar_has_option(*yvar, YVAR_OPTION_READONLY | YVAR_OPTION_PINNED)) {
+        YUKI_LOG_DEBUG("str is readonly or pinned. cannot be modified.");
+        return yfalse;
+    }
+
+    ysize_t len = yvar->data.ystr_data.size;
+    char * dest = (char *)ybuffer_simple_alloc(len + 1);
+
+    if (!dest) {
+        YUKI_LOG_WARNING("out of memory");
+        return yfalse;
+    }
+
+    // interned chars end with '\0'
+    memcpy(dest, yvar->data.ystr_data.str, len + 1);
+    yvar_str_buffer_ref(*yvar) = dest;
+    yvar_unset_option(*yvar, YVAR_OPTION_INTERNED | YVAR_OPTION_HASHED);
+    return ytrue;
+}
+
+/**
+ * clone an array of array to a var.
+ * it's designed to help ytable to clone field or condition easily.
+ * the type of triple_array is yvar_t[size][dimension].
+ */
+ybool_t _yvar_triple_array_clone(yvar_t ** array, yvar_triple_array_t triple_array, ysize_t size, ysize_t dimension)
+{
+    if (!array || !triple_array || !*triple_array || !size || !dimension) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    yvar_t raw_array[size];
+    ysize_t index;
+
+    for (index = 0; index < size; index++) {
+        yvar_array_with_size(raw_array[index], triple_array[index], dimension);
+    }
+
+    yvar_t the_array = YVAR_ARRAY_WITH_SIZE(raw_array, size);
+    return yvar_clone(*array, the_array);
+}
+
+/**
+ * pin an array of array to a var.
+ * it's designed to help ytable to pin field or condition easily.
+ * the type of triple_array is yvar_t[size][dimension].
+ */
+ybool_t _yvar_triple_array_pin(yvar_t ** array, yvar_triple_array_t triple_array, ysize_t size, ysize_t dimension)
+{
+    if (!array || !triple_array || !*triple_array || !size || !dimension) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    yvar_t raw_array[size];
+    ysize_t index;
+
+    for (index = 0; index < size; index++) {
+        yvar_array_with_size(raw_array[index], triple_array[index], dimension);
+    }
+
+    yvar_t the_array = YVAR_ARRAY_WITH_SIZE(raw_array, size);
+    return yvar_pin(*array, the_array);
+}
+
+ybool_t _yvar_array_get(const yvar_t * array, size_t index, yvar_t * output)
+{
+    if (!array || !output) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    static yvar_t undefined = YVAR_UNDEFINED();
+
+    // item of packed array is boxed to output
+    if (yvar_is_packed_array(*array)) {
+        if (index >= array->data.ypacked_array_data.size) {
+            YUKI_LOG_DEBUG("out of bound. [index: %u]", index);
+            return yvar_assign(*output, undefined);
+        }
+
+        yvar_t item;
+        _yvar_packed_array_box(array, index, &item);
+        return yvar_assign(*output, item);
+    }
+
+    if (yvar_is_strided_array(*array)) {
+        if (index >= array->data.ystrided_array_data.size) {
+            YUKI_LOG_DEBUG("out of bound. [index: %u]", index);
+            return yvar_assign(*output, undefined);
+        }
+
+        return yvar_assign(*output, *_YVAR_STRIDED_ARRAY_VAR(array, index));
+    }
+
+    if (!yvar_is_array(*array)) {
+        YUKI_LOG_DEBUG("var is not array");
+        return yfalse;
+    }
+
+    const yarray_t * arr = &array->data.yarray_data;
+
+    if (index >= arr->size) {
+        YUKI_LOG_DEBUG("out of bound. [index: %u]", index);
+        return yvar_assign(*output, undefined);
+    }
+
+    return yvar_assign(*output, arr->yvars[index]);
+}
+
+ysize_t _yvar_array_size(const yvar_t * pyvar)
+{
+    if (yvar_is_packed_array(*pyvar)) {
+        return pyvar->data.ypacked_array_data.size;
+    }
+
+    if (yvar_is_strided_array(*pyvar)) {
+        return pyvar->data.ystrided_array_data.size;
+    }
+
+    if (!yvar_is_array(*pyvar)) {
+        return 0;
+    }
+
+    return pyvar->data.yarray_data.size;
+}
+
+ysize_t _yvar_array_capacity(const yvar_t * array)
+{
+    if (!array || !yvar_is_array(*array)) {
+        return 0;
+    }
+
+    if (!yvar_has_option(*array, YVAR_OPTION_GROWABLE)) {
+        return array->data.yarray_data.size;
+    }
+
+    return array->data.yarray_data.yvars? _YVAR_ARRAY_CAPACITY(array): 0;
+}
+
+/**
+ * move vars to a new memory block with given capacity in thread arena.
+ * latest block is resized in place if possible.
+ */
+static ybool_t _yvar_array_grow(yvar_t * array, ysize_t capacity)
+{
+    yarray_t * arr = &array->data.yarray_data;
+    YUKI_ASSERT(capacity >= arr->size);
+
+    if (yvar_has_option(*array, YVAR_OPTION_GROWABLE) && arr->yvars) {
+        char * block = (char *)arr->yvars - YVAR_ARRAY_CAPACITY_SIZE;
+        ysize_t old_capacity = _YVAR_ARRAY_CAPACITY(array);
+
+        if (ybuffer_simple_resize(block, YVAR_ARRAY_CAPACITY_SIZE + old_capacity * sizeof(yvar_t),
+            YVAR_ARRAY_CAPACITY_SIZE + capacity * sizeof(yvar_t))) {
+            _YVAR_ARRAY_CAPACITY(array) = capacity;
+            return ytrue;
+        }
+    }
+
+    char * block = (char *)ybuffer_simple_alloc(YVAR_ARRAY_CAPACITY_SIZE + capacity * sizeof(yvar_t));
+
+    if (!block) {
+        YUKI_LOG_WARNING("out of memory");
+        return yfalse;
+    }
+
+    yvar_t * yvars = (yvar_t *)(block + YVAR_ARRAY_CAPACITY_SIZE);
+
+    if (arr->size) {
+        memcpy(yvars, arr->yvars, arr->size * sizeof(yvar_t));
+    }
+
+    *(ysize_t *)block = capacity;
+    arr->yvars = yvars;
+    yvar_set_option(*array, YVAR_OPTION_GROWABLE);
+    return ytrue;
+}
+
+/**
+ * reserve capacity for an array.
+ * a fixed size array becomes growable. its vars are copied to thread arena.
+ * memory of growable array is released by yuki_clean_up() as other memory in thread arena.
+ */
+ybool_t _yvar_array_reserve(yvar_t * array, ysize_t capacity)
+{
+    if (!array || !yvar_is_array(*array)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (yvar_has_option(*array, YVAR_OPTION_READONLY | YVAR_OPTION_PINNED)) {
+        YUKI_LOG_DEBUG("array is readonly or pinned. cannot be modified.");
+        return yfalse;
+    }
+
+    if (capacity < array->data.yarray_data.size) {
+        capacity = array->data.yarray_data.size;
+    }
+
+    if (yvar_has_option(*array, YVAR_OPTION_GROWABLE) && capacity <= _yvar_array_capacity(array)) {
+        return ytrue;
+    }
+
+    return _yvar_array_grow(array, capacity);
+}
+
+/**
+ * append a var to the end of an array. capacity doubles when array is full.
+ * var is copied in the same way as yvar_assign().
+ */
+ybool_t _yvar_array_push_back(yvar_t * array, const yvar_t * value)
+{
+    if (!array || !value || !yvar_is_array(*array)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (yvar_has_option(*array, YVAR_OPTION_READONLY | YVAR_OPTION_PINNED)) {
+        YUKI_LOG_DEBUG("array is readonly or pinned. cannot be modified.");
+        return yfalse;
+    }
+
+    yarray_t * arr = &array->data.yarray_data;
+
+    if (!yvar_has_option(*array, YVAR_OPTION_GROWABLE) || arr->size == _yvar_array_capacity(array)) {
+        ysize_t capacity = arr->size * 2;
+
+        if (capacity < YVAR_ARRAY_MIN_CAPACITY) {
+            capacity = YVAR_ARRAY_MIN_CAPACITY;
+        }
+
+        if (!_yvar_array_grow(array, capacity)) {
+            return yfalse;
+        }
+    }
+
+    yvar_memzero(arr->yvars[arr->size]);
+
+    if (!yvar_assign(arr->yvars[arr->size], *value)) {
+        YUKI_LOG_WARNING("cannot assign new value to array");
+        return yfalse;
+    }
+
+    arr->size++;
+    yvar_unset_option(*array, YVAR_OPTION_SORTED);
+    return ytrue;
+}
+
+/**
+ * release unused capacity of a growable array.
+ * memory can be released only if array is the latest allocation in thread arena.
+ */
+ybool_t _yvar_array_shrink(yvar_t * array)
+{
+    if (!array || !yvar_is_array(*array)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (!yvar_has_option(*array, YVAR_OPTION_GROWABLE) || !array->data.yarray_data.yvars) {
+        return ytrue;
+    }
+
+    ysize_t size = array->data.yarray_data.size;
+    ysize_t capacity = _YVAR_ARRAY_CAPACITY(array);
+    char * block = (char *)array->data.yarray_data.yvars - YVAR_ARRAY_CAPACITY_SIZE;
+
+    if (size < capacity && ybuffer_simple_resize(block, YVAR_ARRAY_CAPACITY_SIZE + capacity * sizeof(yvar_t),
+        YVAR_ARRAY_CAPACITY_SIZE + size * sizeof(yvar_t))) {
+        _YVAR_ARRAY_CAPACITY(array) = size;
+    }
+
+    return ytrue;
+}
+
+/**
+ * 64-bit key of an int var which keeps the order of values of the same type.
+ */
+static yuint64_t _yvar_radix_key(const yvar_t * yvar)
+{
+    switch (yvar->type) {
+        case YVAR_TYPE_BOOL:
+            return (yuint64_t)(yint64_t)yvar->data.ybool_data ^ 0x8000000000000000ULL;
+        case YVAR_TYPE_INT8:
+            return (yuint64_t)(yint64_t)yvar->data.yint8_data ^ 0x8000000000000000ULL;
+        case YVAR_TYPE_UINT8:
+            return yvar->data.yuint8_data;
+        case YVAR_TYPE_INT16:
+            return (yuint64_t)(yint64_t)yvar->data.yint16_data ^ 0x8000000000000000ULL;
+        case YVAR_TYPE_UINT16:
+            return yvar->data.yuint16_data;
+        case YVAR_TYPE_INT32:
+            return (yuint64_t)(yint64_t)yvar->data.yint32_data ^ 0x8000000000000000ULL;
+        case YVAR_TYPE_UINT32:
+            return yvar->data.yuint32_data;
+        case YVAR_TYPE_INT64:
+            return (yuint64_t)yvar->data.yint64_data ^ 0x8000000000000000ULL;
+        case YVAR_TYPE_UINT64:
+            return yvar->data.yuint64_data;
+        default:
+            YUKI_LOG_FATAL("var is not int");
+            return 0;
+    }
+}
+
+/**
+ * stable lsd radix sort for an array of int vars with the same type.
+ * bytes with the same value in all keys are skipped.
+ */
+static ybool_t _yvar_array_radix_sort(yvar_t yvars[], ysize_t size)
+{
+    // counts alone are larger than stack scratch. always malloc.
+    char * scratch = (char *)_yvar_scratch_alloc(NULL, 0,
+        8 * 256 * sizeof(ysize_t) + size * (2 * sizeof(yuint64_t) + sizeof(yvar_t)));
+
+    if (!scratch) {
+        return yfalse;
+    }
+
+    ysize_t (* counts)[256] = (ysize_t (*)[256])scratch;
+    yuint64_t * keys = (yuint64_t *)(scratch + 8 * 256 * sizeof(ysize_t));
+    yuint64_t * tmp_keys = keys + size;
+    yvar_t * tmp_yvars = (yvar_t *)(tmp_keys + size);
+
+    memset(counts, 0, 8 * 256 * sizeof(ysize_t));
+    ysize_t i;
+    int byte;
+
+    // count all bytes in one pass
+    for (i = 0; i < size; i++) {
+        keys[i] = _yvar_radix_key(&yvars[i]);
+
+        for (byte = 0; byte < 8; byte++) {
+            counts[byte][(keys[i] >> (byte * 8)) & 0xFF]++;
+        }
+    }
+
+    yvar_t * src = yvars;
+    yvar_t * dst = tmp_yvars;
+    yuint64_t * src_keys = keys;
+    yuint64_t * dst_keys = tmp_keys;
+
+    for (byte = 0; byte < 8; byte++) {
+        ysize_t * count = counts[byte];
+        ysize_t offset = 0;
+        int shift = byte * 8;
+
+        if (count[(src_keys[0] >> shift) & 0xFF] == size) {
+            continue;
+        }
+
+        for (i = 0; i < 256; i++) {
+            ysize_t n = count[i];
+            count[i] = offset;
+            offset += n;
+        }
+
+        for (i = 0; i < size; i++) {
+            ysize_t pos = count[(src_keys[i] >> shift) & 0xFF]++;
+            dst[pos] = src[i];
+            dst_keys[pos] = src_keys[i];
+        }
+
+        yvar_t * yvars_swap = src;
+        src = dst;
+        dst = yvars_swap;
+        yuint64_t * keys_swap = src_keys;
+        src_keys = dst_keys;
+        dst_keys = keys_swap;
+    }
+
+    if (src != yvars) {
+        memcpy(yvars, src, size * sizeof(yvar_t));
+    }
+
+    _yvar_scratch_free(NULL, scratch);
+    return ytrue;
+}
+
+typedef yint8_t (*_yvar_compare_func_t)(const yvar_t * plhs, const yvar_t * prhs);
+
+static void _yvar_array_merge_sort(yvar_t yvars[], yvar_t tmp[], ysize_t size, _yvar_compare_func_t compare)
+{
+    ysize_t i, j;
+
+    // insertion sort for small range
+    if (size <= 16) {
+        for (i = 1; i < size; i++) {
+            yvar_t yvar = yvars[i];
+
+            for (j = i; j > 0 && compare(&yvar, &yvars[j - 1]) < 0; j--) {
+                yvars[j] = yvars[j - 1];
+            }
+
+            yvars[j] = yvar;
+        }
+
+        return;
+    }
+
+    ysize_t half = size / 2;
+    _yvar_array_merge_sort(yvars, tmp, half, compare);
+    _yvar_array_merge_sort(yvars + half, tmp, size - half, compare);
+
+    if (compare(&yvars[half - 1], &yvars[half]) <= 0) {
+        return;
+    }
+
+    ysize_t index = 0;
+    i = 0;
+    j = half;
+
+    while (i < half && j < size) {
+        if (compare(&yvars[j], &yvars[i]) < 0) {
+            tmp[index++] = yvars[j++];
+        } else {
+            tmp[index++] = yvars[i++];
+        }
+    }
+
+    while (i < half) {
+        tmp[index++] = yvars[i++];
+    }
+
+    memcpy(yvars, tmp, j * sizeof(yvar_t));
+}
+
+/**
+ * stable sort vars in place. pick the fastest way for var types.
+ */
+static ybool_t _yvar_array_sort_internal(yvar_t yvars[], ysize_t size)
+{
+    if (size < 2) {
+        return ytrue;
+    }
+
+    YVAR_TYPE type = yvars[0].type;
+    ysize_t i;
+
+    for (i = 1; i < size && yvars[i].type == type; i++) {
+        // find out whether all vars have the same type
+    }
+
+    ybool_t same_type = i == size;
+
+    if (same_type && size >= YVAR_ARRAY_RADIX_SORT_MIN_SIZE
+        && type >= YVAR_TYPE_INT_MIN && type <= YVAR_TYPE_INT_MAX) {
+        return _yvar_array_radix_sort(yvars, size);
+    }
+
+    yuint64_t stack[YVAR_SCRATCH_STACK_SIZE / sizeof(yuint64_t)];
+    yvar_t * tmp = (yvar_t *)_yvar_scratch_alloc(stack, sizeof(stack), size * sizeof(yvar_t));
+
+    if (!tmp) {
+        return yfalse;
+    }
+
+    _yvar_compare_func_t compare = _yvar_compare;
+
+    if (same_type && (type == YVAR_TYPE_CSTR || type == YVAR_TYPE_STR)) {
+        compare = _yvar_compare_str;
+    }
+
+    _yvar_array_merge_sort(yvars, tmp, size, compare);
+    _yvar_scratch_free(stack, tmp);
+    return ytrue;
+}
+
+/**
+ * sort an array in place by yvar_compare(). sort is stable.
+ * array of ints with the same type is sorted by radix sort.
+ */
+ybool_t _yvar_array_sort(yvar_t * array)
+{
+    if (!array || !yvar_is_array(*array)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (yvar_has_option(*array, YVAR_OPTION_READONLY | YVAR_OPTION_PINNED)) {
+        YUKI_LOG_DEBUG("array is readonly or pinned. cannot be modified.");
+        return yfalse;
+    }
+
+    if (!_yvar_array_sort_internal(array->data.yarray_data.yvars, array->data.yarray_data.size)) {
+        return yfalse;
+    }
+
+    yvar_set_option(*array, YVAR_OPTION_SORTED);
+    return ytrue;
+}
+
+/**
+ * remove duplicated vars in an array in place. array is sorted if it's not sorted yet.
+ */
+ybool_t _yvar_array_unique(yvar_t * array)
+{
+    if (!array || !yvar_is_array(*array)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (!yvar_has_option(*array, YVAR_OPTION_SORTED) && !_yvar_array_sort(array)) {
+        return yfalse;
+    }
+
+    if (yvar_has_option(*array, YVAR_OPTION_READONLY | YVAR_OPTION_PINNED)) {
+        YUKI_LOG_DEBUG("array is readonly or pinned. cannot be modified.");
+        return yfalse;
+    }
+
+    yvar_t * yvars = array->data.yarray_data.yvars;
+    ysize_t size = array->data.yarray_data.size;
+    ysize_t i, count = 0;
+
+    for (i = 0; i < size; i++) {
+        if (!count || !yvar_equal(yvars[count - 1], yvars[i])) {
+            yvars[count++] = yvars[i];
+        }
+    }
+
+    array->data.yarray_data.size = count;
+    return ytrue;
+}
+
+/**
+ * vars of an array need to be copied and sorted before merge.
+ */
+static inline ybool_t _yvar_array_need_sort_copy(const yvar_t * array)
+{
+    return !yvar_has_option(*array, YVAR_OPTION_SORTED) && array->data.yarray_data.size >= 2;
+}
+
+/**
+ * get sorted vars of an array. vars are sorted in copy if array is not sorted.
+ * copy must have room for all vars in array.
+ */
+static yvar_t * _yvar_array_sorted_vars(const yvar_t * array, yvar_t * copy)
+{
+    ysize_t size = array->data.yarray_data.size;
+
+    if (!_yvar_array_need_sort_copy(array)) {
+        return array->data.yarray_data.yvars;
+    }
+
+    memcpy(copy, array->data.yarray_data.yvars, size * sizeof(yvar_t));
+
+    if (!_yvar_array_sort_internal(copy, size)) {
+        return NULL;
+    }
+
+    return copy;
+}
+
+static ybool_t _yvar_array_merge(const yvar_t * lhs, const yvar_t * rhs, yvar_t * output, ybool_t is_union)
+{
+    if (!lhs || !rhs || !output || !yvar_is_array(*lhs) || !yvar_is_array(*rhs)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    ysize_t lhs_size = lhs->data.yarray_data.size;
+    ysize_t rhs_size = rhs->data.yarray_data.size;
+    ysize_t max_size = is_union? lhs_size + rhs_size: (lhs_size < rhs_size? lhs_size: rhs_size);
+    yvar_t * result = NULL;
+
+    if (max_size) {
+        result = (yvar_t *)ybuffer_simple_alloc(max_size * sizeof(yvar_t));
+
+        if (!result) {
+            YUKI_LOG_WARNING("out of memory");
+            return yfalse;
+        }
+    }
+
+    // unsorted arrays are sorted in temp memory
+    ysize_t lhs_copy_size = _yvar_array_need_sort_copy(lhs)? lhs_size: 0;
+    ysize_t rhs_copy_size = _yvar_array_need_sort_copy(rhs)? rhs_size: 0;
+    yuint64_t stack[YVAR_SCRATCH_STACK_SIZE / sizeof(yuint64_t)];
+    yvar_t * copy = NULL;
+
+    if (lhs_copy_size || rhs_copy_size) {
+        copy = (yvar_t *)_yvar_scratch_alloc(stack, sizeof(stack), (lhs_copy_size + rhs_copy_size) * sizeof(yvar_t));
+
+        if (!copy) {
+            return yfalse;
+        }
+    }
+
+    const yvar_t * lhs_yvars = _yvar_array_sorted_vars(lhs, copy);
+    const yvar_t * rhs_yvars = _yvar_array_sorted_vars(rhs, copy? copy + lhs_copy_size: NULL);
+
+    if ((lhs_size && !lhs_yvars) || (rhs_size && !rhs_yvars)) {
+        YUKI_LOG_WARNING("fail to sort array");
+        _yvar_scratch_free(stack, copy);
+        return yfalse;
+    }
+
+    ysize_t i = 0, j = 0, count = 0;
+    const yvar_t * yvar;
+    yint8_t ret;
+
+    while (i < lhs_size || j < rhs_size) {
+        if (i == lhs_size) {
+            ret = 1;
+        } else if (j == rhs_size) {
+            ret = -1;
+        } else {
+            ret = _yvar_compare(&lhs_yvars[i], &rhs_yvars[j]);
+        }
+
+        if (ret < 0) {
+            yvar = &lhs_yvars[i++];
+        } else if (ret > 0) {
+            yvar = &rhs_yvars[j++];
+        } else {
+            yvar = &lhs_yvars[i++];
+            j++;
+        }
+
+        if (!is_union && ret) {
+            if (i == lhs_size || j == rhs_size) {
+                break;
+            }
+
+            continue;
+        }
+
+        if (!count || !yvar_equal(result[count - 1], *yvar)) {
+            result[count++] = *yvar;
+        }
+    }
+
+    _yvar_scratch_free(stack, copy);
+
+    yvar_t array = YVAR_ARRAY_WITH_SIZE(result, count);
+    yvar_set_option(array, YVAR_OPTION_SORTED);
+
+    if (!yvar_assign(*output, array)) {
+        YUKI_LOG_DEBUG("output var is readonly");
+        return yfalse;
+    }
+
+    return ytrue;
+}
+
+/**
+ * intersect two arrays. output is a sorted array without duplicated vars.
+ * vars in output are shallow copies of vars in lhs.
+ */
+ybool_t _yvar_array_intersect(const yvar_t * lhs, const yvar_t * rhs, yvar_t * output)
+{
+    return _yvar_array_merge(lhs, rhs, output, yfalse);
+}
+
+/**
+ * union two arrays. output is a sorted array without duplicated vars.
+ * vars in output are shallow copies of vars in lhs or rhs.
+ */
+ybool_t _yvar_array_union(const yvar_t * lhs, const yvar_t * rhs, yvar_t * output)
+{
+    return _yvar_array_merge(lhs, rhs, output, ytrue);
+}
+
+/**
+ * make a readonly view of every stride-th var in [begin, end) of an array.
+ * begin and end are clamped to array size. view shares vars with array and is valid until array is changed.
+ * view is a generic array if stride is 1 and a strided array otherwise. packed array only supports stride 1.
+ * view can be pinned or cloned. only viewed vars are copied.
+ */
+ybool_t _yvar_array_slice(const yvar_t * array, ysize_t begin, ysize_t end, ysize_t stride, yvar_t * view)
+{
+    if (!array || !view || !stride) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (!yvar_is_array(*array) && !yvar_is_packed_array(*array) && !yvar_is_strided_array(*array)) {
+        YUKI_LOG_DEBUG("var is not array");
+        return yfalse;
+    }
+
+    // view is overwritten even if it's a readonly view. pinned var must be unpinned first.
+    if (yvar_has_option(*view, YVAR_OPTION_PINNED)) {
+        YUKI_LOG_DEBUG("view is pinned");
+        return yfalse;
+    }
+
+    ysize_t size = _yvar_array_size(array);
+
+    if (end > size) {
+        end = size;
+    }
+
+    if (begin > end) {
+        begin = end;
+    }
+
+    ysize_t cnt = (end - begin + stride - 1) / stride;
+    yvar_option_t options = YVAR_OPTION_READONLY | (array->options & YVAR_OPTION_SORTED);
+
+    if (cnt < 2) {
+        stride = 1;
+    }
+
+    if (yvar_is_packed_array(*array)) {
+        if (stride != 1) {
+            YUKI_LOG_DEBUG("packed array cannot be viewed with stride. [stride: %lu]", stride);
+            return yfalse;
+        }
+
+        const char * items = (const char *)array->data.ypacked_array_data.items;
+        yuint8_t item_type = array->data.ypacked_array_data.item_type;
+        yvar_packed_array_with_size(*view, item_type,
+            cnt? (void *)(items + begin * _YVAR_PACKED_ITEM_SIZE(item_type)): NULL, cnt);
+        view->options = options;
+        return ytrue;
+    }
+
+    yvar_t * yvars = NULL;
+
+    if (cnt && yvar_is_strided_array(*array)) {
+        yvars = _YVAR_STRIDED_ARRAY_VAR(array, begin);
+        stride *= array->data.ystrided_array_data.stride;
+    } else if (cnt) {
+        yvars = array->data.yarray_data.yvars + begin;
+    }
+
+    if (stride == 1) {
+        yvar_array_with_size(*view, yvars, cnt);
+        view->options = options;
+        return ytrue;
+    }
+
+    if (stride > YUKI_MAX_UINT32_VALUE) {
+        YUKI_LOG_DEBUG("stride is too large. [stride: %lu]", stride);
+        return yfalse;
+    }
+
+    ystrided_array_t strided = {(yuint32_t)cnt, (yuint32_t)stride, yvars};
+    view->type = YVAR_TYPE_STRIDED_ARRAY;
+    view->version = YUKI_VAR_VERSION;
+    view->options = options;
+    view->data.ystrided_array_data = strided;
+    return ytrue;
+}
+
+/**
+ * view next chunk of at most chunk_size vars starting at *offset, and move *offset to the end of chunk.
+ * return false if there is no more var.
+ * @code
+ * ysize_t offset = 0;
+ * yvar_t chunk = YVAR_EMPTY();
+ *
+ * while (yvar_array_chunk(ids, 100, offset, chunk)) {
+ *     // chunk is a view of at most 100 ids.
+ * }
+ * @endcode
+ */
+ybool_t _yvar_array_chunk(const yvar_t * array, ysize_t chunk_size, ysize_t * offset, yvar_t * chunk)
+{
+    if (!array || !offset || !chunk || !chunk_size) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    ysize_t size = _yvar_array_size(array);
+
+    if (*offset >= size) {
+        return yfalse;
+    }
+
+    ysize_t end = size - *offset > chunk_size? *offset + chunk_size: size;
+
+    if (!_yvar_array_slice(array, *offset, end, 1, chunk)) {
+        return yfalse;
+    }
+
+    *offset = end;
+    return ytrue;
+}
+
+/**
+ * convert an array to a packed array of item_type in thread arena.
+ * every var in array must be int-like and fit in item_type.
+ */
+ybool_t _yvar_array_pack(yvar_t ** packed, const yvar_t * array, yuint8_t item_type)
+{
+    ysize_t item_size = _YVAR_PACKED_ITEM_SIZE(item_type);
+
+    if (!packed || !array || !yvar_is_array(*array) || !item_size) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    ysize_t size = array->data.yarray_data.size;
+
+    if (size > YUKI_MAX_UINT32_VALUE) {
+        YUKI_LOG_DEBUG("array is too large to pack. [size: %lu]", size);
+        return yfalse;
+    }
+
+    // items live right after var
+    char * mem = (char *)ybuffer_simple_alloc(ybuffer_round_up(sizeof(yvar_t)) + size * item_size);
+
+    if (!mem) {
+        YUKI_LOG_WARNING("out of memory");
+        return yfalse;
+    }
+
+    yvar_t * yvar = (yvar_t *)mem;
+    void * items = mem + ybuffer_round_up(sizeof(yvar_t));
+    const yvar_t * yvars = array->data.yarray_data.yvars;
+    ybool_t ret = ytrue;
+    ysize_t index;
+
+    for (index = 0; index < size && ret; index++) {
+        switch (item_type) {
+            case YVAR_TYPE_BOOL:
+                ret = _yvar_get_bool(yvars + index, (ybool_t *)items + index);
+                break;
+            case YVAR_TYPE_INT8:
+                ret = _yvar_get_int8(yvars + index, (yint8_t *)items + index);
+                break;
+            case YVAR_TYPE_UINT8:
+                ret = _yvar_get_uint8(yvars + index, (yuint8_t *)items + index);
+                break;
+            case YVAR_TYPE_INT16:
+                ret = _yvar_get_int16(yvars + index, (yint16_t *)items + index);
+                break;
+            case YVAR_TYPE_UINT16:
+                ret = _yvar_get_uint16(yvars + index, (yuint16_t *)items + index);
+                break;
+            case YVAR_TYPE_INT32:
+                ret = _yvar_get_int32(yvars + index, (yint32_t *)items + index);
+                break;
+            case YVAR_TYPE_UINT32:
+                ret = _yvar_get_uint32(yvars + index, (yuint32_t *)items + index);
+                break;
+            case YVAR_TYPE_INT64:
+                ret = _yvar_get_int64(yvars + index, (yint64_t *)items + index);
+                break;
+            case YVAR_TYPE_UINT64:
+                ret = _yvar_get_uint64(yvars + index, (yuint64_t *)items + index);
+                break;
+        }
+    }
+
+    if (!ret) {
+        YUKI_LOG_DEBUG("var cannot be packed. [index: %lu] [item_type: %d]", index - 1, item_type);
+        return yfalse;
+    }
+
+    yvar_packed_array_with_size(*yvar, item_type, size? items: NULL, size);
+    yvar_set_option(*yvar, YVAR_OPTION_HOLD_RESOURCE);
+    *packed = yvar;
+    return ytrue;
+}
+
+/**
+ * convert a packed array to an array of boxed vars in thread arena.
+ */
+ybool_t _yvar_array_unpack(yvar_t ** array, const yvar_t * packed)
+{
+    if (!array || !packed || !yvar_is_packed_array(*packed)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    ysize_t size = packed->data.ypacked_array_data.size;
+    char * mem = (char *)ybuffer_simple_alloc(ybuffer_round_up(sizeof(yvar_t)) + size * sizeof(yvar_t));
+
+    if (!mem) {
+        YUKI_LOG_WARNING("out of memory");
+        return yfalse;
+    }
+
+    yvar_t * yvar = (yvar_t *)mem;
+    yvar_t * yvars = (yvar_t *)(mem + ybuffer_round_up(sizeof(yvar_t)));
+    ysize_t index;
+
+    for (index = 0; index < size; index++) {
+        _yvar_packed_array_box(packed, index, yvars + index);
+    }
+
+    yvar_array_with_size(*yvar, yvars, size);
+    yvar_set_option(*yvar, YVAR_OPTION_HOLD_RESOURCE);
+    *array = yvar;
+    return ytrue;
+}
+
+ybool_t _yvar_list_push_back(yvar_t * yvar, yvar_t * node)
+{
+    if (!yvar || !node || !yvar_is_list(*yvar)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (yvar_has_option(*yvar, YVAR_OPTION_READONLY | YVAR_OPTION_PINNED)) {
+        YUKI_LOG_DEBUG("list is readonly or pinned. cannot be modified.");
+        return yfalse;
+    }
+
+    return _yvar_list_push_back_internal(NULL, yvar, node);
+}
+
+/**
+ * remove first var of a list and copy its value to output.
+ * node taken from thread slab pool is returned to it once all its vars are removed.
+ * node allocated in a clone buffer is left to the buffer.
+ * @note
+ * list must be built in current thread.
+ */
+ybool_t _yvar_list_pop_front(yvar_t * yvar, yvar_t * output)
+{
+    if (!yvar || !output || !yvar_is_list(*yvar)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (yvar_has_option(*yvar, YVAR_OPTION_READONLY | YVAR_OPTION_PINNED)) {
+        YUKI_LOG_DEBUG("list is readonly or pinned. cannot be modified.");
+        return yfalse;
+    }
+
+    ylist_node_t * node = yvar->data.ylist_data.head;
+
+    if (!node) {
+        YUKI_LOG_DEBUG("list is empty");
+        return yfalse;
+    }
+
+    if (!yvar_assign(*output, node->yvars[node->begin])) {
+        YUKI_LOG_DEBUG("cannot assign value to output");
+        return yfalse;
+    }
+
+    ysize_t count = node->count - 1;
+    node->begin++;
+
+    if (node->begin == node->end) {
+        yvar->data.ylist_data.head = node->next;
+
+        if (node->next) {
+            node->next->prev = NULL;
+        } else {
+            yvar->data.ylist_data.tail = NULL;
+        }
+
+        if (node->flags & YLIST_NODE_FLAG_SLAB) {
+            ybuffer_slab_smart_free(node, ylist_node_t);
+        }
+        node = yvar->data.ylist_data.head;
+    }
+
+    // count moves to new head node.
+    if (node) {
+        node->count = count;
+    }
+
+    return ytrue;
+}
+
+/**
+ * remove last var of a list and copy its value to output.
+ * @see _yvar_list_pop_front()
+ */
+ybool_t _yvar_list_pop_back(yvar_t * yvar, yvar_t * output)
+{
+    if (!yvar || !output || !yvar_is_list(*yvar)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (yvar_has_option(*yvar, YVAR_OPTION_READONLY | YVAR_OPTION_PINNED)) {
+        YUKI_LOG_DEBUG("list is readonly or pinned. cannot be modified.");
+        return yfalse;
+    }
+
+    ylist_node_t * node = yvar->data.ylist_data.tail;
+
+    if (!node) {
+        YUKI_LOG_DEBUG("list is empty");
+        return yfalse;
+    }
+
+    if (!yvar_assign(*output, node->yvars[node->end - 1])) {
+        YUKI_LOG_DEBUG("cannot assign value to output");
+        return yfalse;
+    }
+
+    node->end--;
+    yvar->data.ylist_data.head->count--;
+
+    if (node->begin == node->end) {
+        yvar->data.ylist_data.tail = node->prev;
+
+        if (node->prev) {
+            node->prev->next = NULL;
+        } else {
+            yvar->data.ylist_data.head = NULL;
+        }
+
+        if (node->flags & YLIST_NODE_FLAG_SLAB) {
+            ybuffer_slab_smart_free(node, ylist_node_t);
+        }
+    }
+
+    return ytrue;
+}
+
+/**
+ * index of first key not less than the given key in sorted keys.
+ */
+static ysize_t _yvar_map_lower_bound(const yvar_t * keys, const yvar_t * key)
+{
+    ysize_t low = 0;
+    ysize_t high = yvar_count(*keys);
+
+    while (low < high) {
+        ysize_t mid = low + (high - low) / 2;
+
+        if (_yvar_compare(&keys->data.yarray_data.yvars[mid], key) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+ybool_t _yvar_map_get(const yvar_t * map, const yvar_t * key, yvar_t * value)
+{
+    if (!map || !key || !value || !yvar_is_map(*map)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    static yvar_t undefined = YVAR_UNDEFINED();
+    yvar_t * keys = map->data.ymap_data.keys;
+    yvar_t * values = map->data.ymap_data.values;
+
+    if (!yvar_is_array(*keys) || !yvar_is_array(*values)) {
+        YUKI_LOG_FATAL("map keys or values is not an array. why?");
+        return yfalse;
+    }
+
+    if (yvar_has_option(*map, YVAR_OPTION_HASHED)) {
+        const ymap_index_t * index = _yvar_map_index(keys);
+        const ymap_index_slot_t * slots = _yvar_map_index_slots(index);
+        yuint32_t hash = _yvar_hash(key);
+        yuint32_t pos = hash & index->mask;
+
+        while (slots[pos].index) {
+            if (slots[pos].hash == hash && yvar_equal(keys->data.yarray_data.yvars[slots[pos].index - 1], *key)) {
+                return yvar_array_get(*values, slots[pos].index - 1, *value);
+            }
+
+            pos = (pos + 1) & index->mask;
+        }
+
+        YUKI_LOG_DEBUG("key is not found");
+        yvar_assign(*value, undefined);
+        return yfalse;
+    }
+
+    if (yvar_has_option(*map, YVAR_OPTION_SORTED)) {
+        ysize_t i = _yvar_map_lower_bound(keys, key);
+
+        if (i < yvar_count(*keys) && yvar_equal(keys->data.yarray_data.yvars[i], *key)) {
+            return yvar_array_get(*values, i, *value);
+        }
+
+        YUKI_LOG_DEBUG("key is not found");
+        yvar_assign(*value, undefined);
+        return yfalse;
+    }
+
+    ysize_t i = 0;
+    FOREACH_YVAR_ARRAY(*keys, v) {
+        if (yvar_equal(*v, *key)) {
+            return yvar_array_get(*values, i, *value);
+        }
+
+        i++;
+    }
+
+    YUKI_LOG_DEBUG("key is not found");
+    yvar_assign(*value, undefined);
+    return yfalse;
+}
+
+/**
+ * get keys in [lower, upper) and their values from a sorted map.
+ * keys and values are array vars sharing memory with the map,
+ * so that they can be iterated by FOREACH_YVAR_ARRAY() in key order.
+ * lower or upper can be NULL to set no bound on that side.
+ * yvar_map_range_from(), yvar_map_range_to() and yvar_map_range_all() leave out bounds.
+ * @code
+ * yvar_t keys, values;
+ * yvar_map_range(*map, lower, upper, keys, values);
+ * FOREACH_YVAR_ARRAY(keys, key) {
+ *     // ...
+ * }
+ * @endcode
+ */
+ybool_t _yvar_map_range(const yvar_t * map, const yvar_t * lower, const yvar_t * upper, yvar_t * keys, yvar_t * values)
+{
+    if (!map || !keys || !values || !yvar_is_map(*map)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (!yvar_has_option(*map, YVAR_OPTION_SORTED)) {
+        YUKI_LOG_DEBUG("map is not sorted");
+        return yfalse;
+    }
+
+    const yvar_t * map_keys = map->data.ymap_data.keys;
+    const yvar_t * map_values = map->data.ymap_data.values;
+    ysize_t begin = lower? _yvar_map_lower_bound(map_keys, lower): 0;
+    ysize_t end = upper? _yvar_map_lower_bound(map_keys, upper): yvar_count(*map_keys);
+
+    if (end < begin) {
+        end = begin;
+    }
+
+    yvar_t keys_range = YVAR_ARRAY_WITH_SIZE(map_keys->data.yarray_data.yvars + begin, end - begin);
+    yvar_t values_range = YVAR_ARRAY_WITH_SIZE(map_values->data.yarray_data.yvars + begin, end - begin);
+    yvar_set_option(keys_range, YVAR_OPTION_SORTED);
+
+    if (!yvar_assign(*keys, keys_range) || !yvar_assign(*values, values_range)) {
+        YUKI_LOG_DEBUG("output var is readonly");
+        return yfalse;
+    }
+
+    return ytrue;
+}
+
+static ybool_t _yvar_map_create(yvar_t ** map, yvar_map_kv_t raw_arr, ysize_t size, ybool_t sorted, ybool_t pinned)
+{
+    if (!map || !raw_arr || !size) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    yvar_t even_array[size];
+    yvar_t odd_array[size];
+
+    if (!_yvar_map_assoc_array_sort(raw_arr, size, even_array, size, odd_array, size, sorted)) {
+        YUKI_LOG_WARNING("fail to sort map");
+        return yfalse;
+    }
+
+    yvar_t keys = YVAR_ARRAY(even_array);
+    yvar_t values = YVAR_ARRAY(odd_array);
+    yvar_t local_map = YVAR_MAP(keys, values);
+
+    if (sorted) {
+        yvar_set_option(keys, YVAR_OPTION_SORTED);
+        yvar_set_option(local_map, YVAR_OPTION_SORTED);
+    }
+
+    if (pinned) {
+        return yvar_pin(*map, local_map);
+    }
+
+    return yvar_clone(*map, local_map);
+}
+
+/**
+ * clone a map thru a raw key-value array of vars.
+ * this function can help user to create a map in a easier way.
+ * @code
+ * yvar_t raw_arr[][2] = {
+ *     {YVAR_CSTR("uid"), YVAR_UINT64(123456UL)}, // "uid" => 123456
+ *     {YVAR_CSTR("cash"), YVAR_INT64(234L)},     // "cash" => 234
+ *     {YVAR_CSTR("diamond"), YVAR_UINT64(123L)}, // "diamond" => 123
+ * };
+ * yvar_t * map;
+ * yvar_map_clone(map, raw_arr, sizeof(raw_arr) / sizeof(raw_arr[0]);
+ * // or
+ * yvar_map_pin(map, raw_arr, sizeof(raw_arr) / sizeof(raw_arr[0]);
+ *
+ * // a macro yvar_map_smart_create() is available to make code a little simpler.
+ * yvar_map_smart_clone(map, raw_arr);
+ * // or
+ * yvar_map_smart_pin(map, raw_arr);
+ * @endcode
+ */
+ybool_t _yvar_map_clone(yvar_t ** map, yvar_map_kv_t raw_arr, ysize_t size)
+{
+    return _yvar_map_create(map, raw_arr, size, yfalse, yfalse);
+}
+
+/**
+ * pin a map thru a raw key-value array of vars.
+ * @see _yvar_map_clone()
+ */
+ybool_t _yvar_map_pin(yvar_t ** map, yvar_map_kv_t raw_arr, ysize_t size)
+{
+    return _yvar_map_create(map, raw_arr, size, yfalse, ytrue);
+}
+
+/**
+ * clone a sorted map thru a raw key-value array of vars.
+ * keys are stable sorted by yvar_compare(). values move together with keys.
+ * yvar_map_get() uses binary search on sorted map and yvar_map_range()
+ * can iterate keys in order.
+ * @see _yvar_map_clone()
+ */
+ybool_t _yvar_map_sorted_clone(yvar_t ** map, yvar_map_kv_t raw_arr, ysize_t size)
+{
+    return _yvar_map_create(map, raw_arr, size, ytrue, yfalse);
+}
+
+/**
+ * pin a sorted map thru a raw key-value array of vars.
+ * @see _yvar_map_sorted_clone()
+ */
+ybool_t _yvar_map_sorted_pin(yvar_t ** map, yvar_map_kv_t raw_arr, ysize_t size)
+{
+    return _yvar_map_create(map, raw_arr, size, ytrue, ytrue);
+}
+
+ybool_t _yvar_assign(yvar_t * lhs, const yvar_t * rhs)
+{
+    if (!lhs || !rhs) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (yvar_has_option(*lhs, YVAR_OPTION_READONLY | YVAR_OPTION_PINNED)) {
+        YUKI_LOG_DEBUG("left hand side value is readonly");
+        return yfalse;
+    }
+
+    *lhs = *rhs;
+
+    // a copy of frozen var doesn't own a reference.
+    // a copy of growable array shares vars but not spare capacity. it grows into new memory.
+    yvar_unset_option(*lhs, YVAR_OPTION_FROZEN | YVAR_OPTION_GROWABLE);
+    return ytrue;
+}
+
+/**
+ * deep copy a var in a buffer sized by walking var first.
+ */
+static ybool_t _yvar_clone_sized_copy(yvar_t ** new_var, const yvar_t * old_var, ybool_t share_frozen)
+{
+    yvar_clone_context_t context;
+    memset(&context, 0, sizeof(context));
+    context.share_frozen = share_frozen;
+
+    ysize_t size = _yvar_mem_size(old_var, &context);
+    ybuffer_t * buffer = ybuffer_create(size);
+
+    if (!buffer) {
+        YUKI_LOG_WARNING("out of memory");
+        return yfalse;
+    }
+
+    return _yvar_clone_internal(buffer, new_var, old_var, share_frozen);
+}
+
+/**
+ * deep copy a var in thread arena.
+ * if share_frozen is true, frozen elements are shared instead of copied.
+ */
+static ybool_t _yvar_clone_copy(yvar_t ** new_var, const yvar_t * old_var, ybool_t share_frozen)
+{
+    // scalar var is a single yvar_t. take it from slab pool.
+    if (old_var->type <= YVAR_TYPE_INT_MAX) {
+        yvar_t * yvar = ybuffer_slab_smart_alloc(yvar_t);
+
+        if (!yvar) {
+            YUKI_LOG_WARNING("out of memory");
+            return yfalse;
+        }
+
+        yvar_memzero(*yvar);
+
+        if (!yvar_assign(*yvar, *old_var)) {
+            YUKI_LOG_FATAL("cannot assign new value");
+            ybuffer_slab_smart_free(yvar, yvar_t);
+            return yfalse;
+        }
+
+        yvar_set_option(*yvar, YVAR_OPTION_HOLD_RESOURCE);
+        *new_var = yvar;
+        return ytrue;
+    }
+
+    // thread arena grows as clone goes. no need to walk var twice.
+    if (ybuffer_arena_enabled()) {
+        return _yvar_clone_internal(NULL, new_var, old_var, share_frozen);
+    }
+
+    return _yvar_clone_sized_copy(new_var, old_var, share_frozen);
+}
+
+/**
+ * clone a var in thread arena.
+ * frozen var is not copied. a reference is taken instead and dropped when current thread cleans up.
+ */
+ybool_t _yvar_clone(yvar_t ** new_var, const yvar_t * old_var)
+{
+    if (!new_var || !old_var) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    // old var may be a copy of frozen var. reference is taken on the root owning memory.
+    yvar_t * root = _yvar_frozen_root(old_var);
+
+    if (root) {
+        if (!_yvar_frozen_retain_until_clean_up(root)) {
+            return yfalse;
+        }
+
+        *new_var = root;
+        return ytrue;
+    }
+
+    if (!_yvar_clone_copy(new_var, old_var, ytrue)) {
+        return yfalse;
+    }
+
+    // frozen var without memory, e.g. a frozen int, is copied as thaw does.
+    if (yvar_has_option(*old_var, YVAR_OPTION_FROZEN)) {
+        yvar_unset_option(**new_var, YVAR_OPTION_PINNED);
+    }
+
+    return ytrue;
+}
+
+/**
+ * clone a var as yvar_clone() does, but always size memory before copy even if thread arena is enabled.
+ * it's an internal entry point for samples/clone_bench to compare with one pass clone.
+ */
+ybool_t _yvar_clone_sized(yvar_t ** new_var, const yvar_t * old_var)
+{
+    if (!new_var || !old_var) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    return _yvar_clone_sized_copy(new_var, old_var, ytrue);
+}
+
+/**
+ * pin a var in global memory.
+ * frozen var is not copied. a reference is taken instead and dropped by yvar_unpin().
+ */
+ybool_t _yvar_pin(yvar_t ** new_var, const yvar_t * old_var)
+{
+    if (!new_var || !old_var) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    // old var may be a copy of frozen var. reference is taken on the root owning memory.
+    yvar_t * root = _yvar_frozen_root(old_var);
+
+    if (root) {
+        if (!ybuffer_retain_global_pointer(root)) {
+            YUKI_LOG_WARNING("cannot retain frozen var");
+            return yfalse;
+        }
+
+        *new_var = root;
+        return ytrue;
+    }
+
+    yvar_clone_context_t context;
+    memset(&context, 0, sizeof(context));
+
+    // global buffer cannot grow. it's sized exactly before clone.
+    ysize_t size = _yvar_mem_size(old_var, &context);
+    ybuffer_t * buffer = ybuffer_create_global(size);
+
+    if (!buffer) {
+        YUKI_LOG_WARNING("out of memory");
+        return yfalse;
+    }
+
+    // pinned var lives longer than current thread. frozen elements are copied.
+    ybool_t ret = _yvar_clone_internal(buffer, new_var, old_var, yfalse);
+
+    if (!ret) {
+        YUKI_LOG_FATAL("unable to pin var");
+        return yfalse;
+    }
+
+    yvar_set_option(**new_var, YVAR_OPTION_PINNED);
+    return ret;
+}
+
+ybool_t _yvar_unpin(yvar_t * yvar)
+{
+    if (!yvar) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (!yvar_has_option(*yvar, YVAR_OPTION_PINNED)) {
+        YUKI_LOG_DEBUG("var is not pinned");
+        return yfalse;
+    }
+
+    // frozen var may be still used by others. it must not be touched after reference is dropped.
+    if (yvar_has_option(*yvar, YVAR_OPTION_FROZEN)) {
+        yvar_t * root = _yvar_frozen_root(yvar);
+
+        // a copy of frozen var doesn't own a reference.
+        if (root && root != yvar) {
+            YUKI_LOG_DEBUG("copy of frozen var cannot be unpinned");
+            return yfalse;
+        }
+
+        return ybuffer_destroy_global_pointer(yvar);
+    }
+
+    if (!ybuffer_destroy_global_pointer(yvar)) {
+        YUKI_LOG_WARNING("fail to destroy global pointer");
+        return yfalse;
+    }
+
+    yvar_unset_option(*yvar, YVAR_OPTION_PINNED);
+    return ytrue;
+}
+
+/**
+ * freeze a var. frozen var is pinned, immutable and shared by reference.
+ * clone or pin of a frozen var takes a reference instead of copying it.
+ * caller owns one reference and drops it by yvar_unpin().
+ * @note
+ * frozen var must be used thru the pointer returned by this function.
+ */
+ybool_t _yvar_freeze(yvar_t ** new_var, const yvar_t * old_var)
+{
+    if (!new_var || !old_var) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    // frozen var with memory is shared. one without memory, e.g. a frozen int, is pinned and frozen again.
+    if (_yvar_frozen_root(old_var)) {
+        return _yvar_pin(new_var, old_var);
+    }
+
+    if (!_yvar_pin(new_var, old_var)) {
+        YUKI_LOG_WARNING("cannot pin var to freeze");
+        return yfalse;
+    }
+
+    // copies of frozen var find it thru its memory.
+    const char * data = (const char *)_yvar_frozen_data(*new_var);
+    (*new_var)->frozen_offset = data? (yuint32_t)(data - (const char *)*new_var): 0;
+    yvar_set_option(**new_var, YVAR_OPTION_FROZEN);
+    return ytrue;
+}
+
+/**
+ * make a writable copy of a frozen var in thread arena and point yvar to it.
+ * reference held by caller is not dropped. it's a no-op if var is not frozen.
+ */
+ybool_t _yvar_thaw(yvar_t ** yvar)
+{
+    if (!yvar || !*yvar) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (!yvar_has_option(**yvar, YVAR_OPTION_FROZEN)) {
+        return ytrue;
+    }
+
+    yvar_t * copy = NULL;
+
+    // frozen var itself must be copied, so nothing is shared.
+    if (!_yvar_clone_copy(&copy, *yvar, yfalse)) {
+        YUKI_LOG_WARNING("cannot copy frozen var");
+        return yfalse;
+    }
+
+    yvar_unset_option(*copy, YVAR_OPTION_PINNED);
+    *yvar = copy;
+    return ytrue;
+}
+
+/**
+ * assign rhs to the var pointed by lhs.
+ * if lhs points to a frozen var, lhs is pointed to a new var in thread arena first.
+ * frozen var itself is never modified.
+ */
+ybool_t _yvar_cow_assign(yvar_t ** lhs, const yvar_t * rhs)
+{
+    if (!lhs || !*lhs || !rhs) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (yvar_has_option(**lhs, YVAR_OPTION_FROZEN)) {
+        yvar_t * yvar = (yvar_t *)ybuffer_simple_alloc(sizeof(yvar_t));
+
+        if (!yvar) {
+            YUKI_LOG_WARNING("out of memory");
+            return yfalse;
+        }
+
+        yvar_memzero(*yvar);
+        *lhs = yvar;
+    }
+
+    return _yvar_assign(*lhs, rhs);
+}
+
+/**
+ * move a var from src to dst without copying. src is set to NULL.
+ * only var holding its own resource, i.e. returned by clone, pin or freeze, can be moved.
+ * dst takes over whatever src owns. a pinned var must still be unpinned thru dst.
+ */
+ybool_t _yvar_move(yvar_t ** dst, yvar_t ** src)
+{
+    if (!dst || !src || !*src) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (!yvar_has_option(**src, YVAR_OPTION_HOLD_RESOURCE)) {
+        YUKI_LOG_DEBUG("var does not hold resource. use yvar_clone() instead");
+        return yfalse;
+    }
+
+    *dst = *src;
+    *src = NULL;
+    return ytrue;
+}
+
+#define _YVAR_ENCODED_AT(context, offset, t) ((context)->buf? (t *)((context)->buf + (offset)): NULL)
+// pointers are only rewritten in a private copy. viewed buffer is at base address and is never written.
+#define _YVAR_VIEW_SET(context, field, value) do { \
+        if ((context)->relocate) { \
+            (field) = (value); \
+        } \
+    } while (0)
+
+/**
+ * reserve a block of size bytes at the end of encoded buffer. padding of block is zeroed.
+ */
+static ybool_t _yvar_encode_alloc(yvar_encode_context_t * context, ysize_t size, ysize_t * offset)
+{
+    ysize_t rounded = ybuffer_round_up(size);
+
+    if (rounded > context->size - context->offset) {
+        YUKI_LOG_DEBUG("buffer is too small to encode var. [size: %lu]", context->size);
+        return yfalse;
+    }
+
+    if (context->buf && rounded > size) {
+        memset(context->buf + context->offset + size, 0, rounded - size);
+    }
+
+    *offset = context->offset;
+    context->offset += rounded;
+    return ytrue;
+}
+
+/**
+ * encode a var to dst and append its elements to buffer.
+ * dst is NULL when encoded size is being counted.
+ */
+static ybool_t _yvar_encode_element(yvar_encode_context_t * context, yvar_t * dst, const yvar_t * src, ysize_t depth)
+{
+    ysize_t offset;
+
+    if (depth > YVAR_ENCODED_MAX_DEPTH) {
+        YUKI_LOG_DEBUG("var is too deep to encode");
+        return yfalse;
+    }
+
+    // only used fields are copied, so that padding and unused bytes of data are zero in buffer.
+    if (dst) {
+        memset(dst, 0, sizeof(yvar_t));
+        dst->type = src->type;
+        dst->version = src->version;
+        dst->options = src->options;
+        yvar_unset_option(*dst, YVAR_ENCODED_INVALID_OPTIONS);
+
+        if (src->type <= YVAR_TYPE_INT_MAX) {
+            memcpy(&dst->data, &src->data, _YVAR_PACKED_ITEM_SIZE(src->type));
+        }
+    }
+
+    switch (src->type) {
+        case YVAR_TYPE_ARRAY:
+        case YVAR_TYPE_STRIDED_ARRAY:
+        {
+            // strided array is encoded as a generic array
+            ysize_t cnt = _yvar_array_size(src);
+            ysize_t index;
+
+            if (!_yvar_encode_alloc(context, cnt * sizeof(yvar_t), &offset)) {
+                return yfalse;
+            }
+
+            yvar_t * yvars = cnt? _YVAR_ENCODED_AT(context, offset, yvar_t): NULL;
+
+            for (index = 0; index < cnt; index++) {
+                const yvar_t * value = yvar_is_array(*src)? src->data.yarray_data.yvars + index:
+                    _YVAR_STRIDED_ARRAY_VAR(src, index);
+
+                if (!_yvar_encode_element(context, yvars? yvars + index: NULL, value, depth + 1)) {
+                    return yfalse;
+                }
+            }
+
+            if (dst) {
+                yarray_t array = {cnt, yvars};
+                dst->type = YVAR_TYPE_ARRAY;
+                dst->data.yarray_data = array;
+            }
+
+            break;
+        }
+        case YVAR_TYPE_PACKED_ARRAY:
+        {
+            ysize_t size = _YVAR_PACKED_ARRAY_MEM_SIZE(src);
+
+            if (!_yvar_encode_alloc(context, size, &offset)) {
+                return yfalse;
+            }
+
+            if (dst) {
+                char * items = size? _YVAR_ENCODED_AT(context, offset, char): NULL;
+
+                if (size) {
+                    memcpy(items, src->data.ypacked_array_data.items, size);
+                }
+
+                dst->data.ypacked_array_data.size = src->data.ypacked_array_data.size;
+                dst->data.ypacked_array_data.item_type = src->data.ypacked_array_data.item_type;
+                dst->data.ypacked_array_data.items = items;
+            }
+
+            break;
+        }
+        case YVAR_TYPE_LIST:
+        {
+            // vars are packed into full nodes. each node is followed by elements of its vars.
+            const ylist_node_t * src_node = src->data.ylist_data.head;
+            const yvar_t * value = _yvar_list_next(&src_node, NULL);
+            ylist_node_t * head = NULL;
+            ylist_node_t * node = NULL;
+            ysize_t cnt = 0;
+
+            for (; value; value = _yvar_list_next(&src_node, value), cnt++) {
+                if (!(cnt % YLIST_NODE_CAPACITY)) {
+                    if (!_yvar_encode_alloc(context, sizeof(ylist_node_t), &offset)) {
+                        return yfalse;
+                    }
+
+                    ylist_node_t * next = _YVAR_ENCODED_AT(context, offset, ylist_node_t);
+
+                    if (next) {
+                        memset(next, 0, sizeof(ylist_node_t));
+                        next->prev = node;
+
+                        if (node) {
+                            node->next = next;
+                        } else {
+                            head = next;
+                        }
+                    }
+
+                    node = next;
+                }
+
+                if (!_yvar_encode_element(context, node? node->yvars + node->end: NULL, value, depth + 1)) {
+                    return yfalse;
+                }
+
+                if (node) {
+                    node->end++;
+                }
+            }
+
+            if (dst) {
+                if (head) {
+                    head->count = cnt;
+                }
+
+                dst->data.ylist_data.head = head;
+                dst->data.ylist_data.tail = node;
+            }
+
+            break;
+        }
+        case YVAR_TYPE_MAP:
+        {
+            const yvar_t * src_keys = src->data.ymap_data.keys;
+            const yvar_t * src_values = src->data.ymap_data.values;
+            yvar_t * keys = context->keys_dst;
+            ybool_t hashed = context->keys_hashed;
+
+            if ((!yvar_is_array(*src_keys) && !yvar_is_strided_array(*src_keys))
+                || (!yvar_is_array(*src_values) && !yvar_is_strided_array(*src_values))) {
+                YUKI_LOG_DEBUG("map keys or values is not an array");
+                return yfalse;
+            }
+
+            // maps sharing keys with last map, e.g. rows in a result set, share encoded keys and index.
+            if (src_keys != context->keys_src) {
+                ysize_t capacity = _yvar_map_index_capacity(src);
+                ysize_t index_size = _yvar_map_index_mem_size(src);
+
+                if (!_yvar_encode_alloc(context, index_size + sizeof(yvar_t), &offset)) {
+                    return yfalse;
+                }
+
+                keys = context->buf? (yvar_t *)(context->buf + offset + index_size): NULL;
+
+                if (!_yvar_encode_element(context, keys, src_keys, depth + 1)) {
+                    return yfalse;
+                }
+
+                if (keys && capacity) {
+                    _yvar_map_index_build(keys, capacity);
+                }
+
+                hashed = capacity? ytrue: yfalse;
+                context->keys_src = src_keys;
+                context->keys_dst = keys;
+                context->keys_hashed = hashed;
+            }
+
+            if (!_yvar_encode_alloc(context, sizeof(yvar_t), &offset)) {
+                return yfalse;
+            }
+
+            yvar_t * values = _YVAR_ENCODED_AT(context, offset, yvar_t);
+
+            if (!_yvar_encode_element(context, values, src_values, depth + 1)) {
+                return yfalse;
+            }
+
+            if (dst) {
+                dst->data.ymap_data.keys = keys;
+                dst->data.ymap_data.values = values;
+
+                if (hashed) {
+                    yvar_set_option(*dst, YVAR_OPTION_HASHED);
+                } else {
+                    yvar_unset_option(*dst, YVAR_OPTION_HASHED);
+                }
+            }
+
+            break;
+        }
+        case YVAR_TYPE_CSTR:
+        case YVAR_TYPE_STR:
+        {
+            ybool_t is_inline = yvar_has_option(*src, YVAR_OPTION_INLINE)? ytrue: yfalse;
+            const char * str = is_inline? src->data.yinline_str_data.str: src->data.ycstr_data.str;
+            ysize_t len = yvar_cstr_strlen(*src);
+
+            // short str is stored inside var as clone does
+            if (is_inline || len <= YVAR_INLINE_STR_MAX_SIZE) {
+                if (dst) {
+                    yinline_str_t inline_str;
+                    memset(&inline_str, 0, sizeof(inline_str));
+
+                    if (len) {
+                        memcpy(inline_str.str, str, len);
+                    }
+
+                    inline_str.size = (yuint8_t)len;
+                    dst->data.yinline_str_data = inline_str;
+                    yvar_unset_option(*dst, YVAR_OPTION_HASHED | YVAR_OPTION_INTERNED);
+                    yvar_set_option(*dst, YVAR_OPTION_INLINE);
+                }
+
+                break;
+            }
+
+            // hash is stored before chars. chars end with '\0'.
+            if (!_yvar_encode_alloc(context, YVAR_STR_HASH_SIZE + len + 1, &offset)) {
+                return yfalse;
+            }
+
+            if (dst) {
+                char * dest = context->buf + offset;
+                memset(dest, 0, YVAR_STR_HASH_SIZE);
+                *(yuint32_t *)dest = _yvar_hash(src);
+                dest += YVAR_STR_HASH_SIZE;
+                memcpy(dest, str, len);
+                dest[len] = '\0';
+                dst->data.ystr_data.size = len;
+                yvar_str_buffer_ref(*dst) = dest;
+                yvar_unset_option(*dst, YVAR_OPTION_INTERNED);
+                yvar_set_option(*dst, YVAR_OPTION_HASHED);
+            }
+
+            break;
+        }
+    }
+
+    return ytrue;
+}
+
+/**
+ * get size of buffer to encode a var. return 0 if var cannot be encoded.
  */
-ybool_t _yvar_triple_array_pin(yvar_t ** array, yvar_triple_array_t triple_array, ysize_t size, ysize_t dimension)
+ysize_t _yvar_encoded_size(const yvar_t * yvar)
 {
-    if (!array || !triple_array || !*triple_array || !size || !dimension) {
+    if (!yvar) {
         YUKI_LOG_FATAL("invalid param");
-        return yfalse;
+        return 0;
     }
 
-    yvar_t raw_array[size];
-    ysize_t index;
+    yvar_encode_context_t context;
+    memset(&context, 0, sizeof(context));
+    context.size = (ysize_t)-1;
+    context.offset = YVAR_ENCODED_HEADER_SIZE + ybuffer_round_up(sizeof(yvar_t));
 
-    for (index = 0; index < size; index++) {
-        yvar_array_with_size(raw_array[index], triple_array[index], dimension);
+    if (!_yvar_encode_element(&context, NULL, yvar, 0)) {
+        return 0;
     }
 
-    yvar_t the_array = YVAR_ARRAY_WITH_SIZE(raw_array, size);
-    return yvar_pin(*array, the_array);
+    return context.offset;
 }
 
-ybool_t _yvar_array_get(const yvar_t * array, size_t index, yvar_t * output)
+/**
+ * encode a var to a flat buffer, which can be sent to other processes or saved to file.
+ * buffer must be aligned to 8 bytes. size of buffer can be got by yvar_encoded_size().
+ * vars in buffer can be used in place after yvar_view().
+ */
+ybool_t _yvar_encode(const yvar_t * yvar, void * buf, ysize_t size)
 {
-    if (!array || !output) {
+    if (!yvar || !buf || ((uintptr_t)buf & (_YBUFFER_ALLOC_ALIGN - 1))) {
         YUKI_LOG_FATAL("invalid param");
         return yfalse;
     }
 
-    static yvar_t undefined = YVAR_UNDEFINED();
+    yvar_encode_context_t context;
+    memset(&context, 0, sizeof(context));
+    context.buf = (char *)buf;
+    context.size = size;
+    context.offset = YVAR_ENCODED_HEADER_SIZE + ybuffer_round_up(sizeof(yvar_t));
 
-    if (!yvar_is_array(*array)) {
-        YUKI_LOG_DEBUG("var is not array");
+    if (size < context.offset) {
+        YUKI_LOG_DEBUG("buffer is too small to encode var. [size: %lu]", size);
         return yfalse;
     }
 
-    const yarray_t * arr = &array->data.yarray_data;
+    yvar_t * root = (yvar_t *)(context.buf + YVAR_ENCODED_HEADER_SIZE);
 
-    if (index >= arr->size) {
-        YUKI_LOG_DEBUG("out of bound. [index: %u]", index);
-        return yvar_assign(*output, undefined);
+    if (!_yvar_encode_element(&context, root, yvar, 0)) {
+        return yfalse;
     }
 
-    return yvar_assign(*output, arr->yvars[index]);
+    yvar_encoded_header_t * header = (yvar_encoded_header_t *)buf;
+    memset(header, 0, YVAR_ENCODED_HEADER_SIZE);
+    header->magic = YVAR_ENCODED_MAGIC;
+    header->version = YUKI_VAR_VERSION;
+    header->pointer_size = (yuint8_t)sizeof(void *);
+    header->size = context.offset;
+    header->base = (yuint64_t)(uintptr_t)buf;
+    return ytrue;
 }
 
-ysize_t _yvar_array_size(const yvar_t * pyvar)
+/**
+ * check a pointer in encoded buffer. it must point to head bytes after the start of a block of size bytes
+ * at current offset. empty block must be NULL. output is relocated pointer.
+ */
+static ybool_t _yvar_view_block(yvar_view_context_t * context, const void * pointer, ysize_t head, ysize_t size,
+    char ** output)
 {
-    if (!yvar_is_array(*pyvar)) {
-        return 0;
-    }
+    ysize_t left = context->size - context->offset;
+    yuint64_t offset = (yuint64_t)(uintptr_t)pointer - context->base - head;
 
-    return pyvar->data.yarray_data.size;
-}
-
-ybool_t _yvar_list_push_back(yvar_t * yvar, yvar_t * node)
-{
-    if (!yvar || !node || !yvar_is_list(*yvar)) {
-        YUKI_LOG_FATAL("invalid param");
-        return yfalse;
+    if (!size) {
+        *output = NULL;
+        return pointer? yfalse: ytrue;
     }
 
-    if (yvar_has_option(*yvar, YVAR_OPTION_READONLY | YVAR_OPTION_PINNED)) {
-        YUKI_LOG_DEBUG("list is readonly or pinned. cannot be modified.");
+    if (!pointer || offset != context->offset || size > left || ybuffer_round_up(size) > left) {
+        YUKI_LOG_DEBUG("bad pointer in encoded var. [offset: %lu]", context->offset);
         return yfalse;
     }
 
-    ybuffer_t * buffer = ybuffer_create(sizeof(ylist_node_t));
+    context->offset += ybuffer_round_up(size);
+    *output = context->buf + offset + head;
+    return ytrue;
+}
 
-    if (!buffer) {
-        YUKI_LOG_WARNING("cannot create buffer");
-        return yfalse;
+/**
+ * check whether a pointer in encoded buffer points to a relocated node.
+ */
+static inline ybool_t _yvar_view_same(const yvar_view_context_t * context, const void * pointer, const void * node)
+{
+    if (!pointer || !node) {
+        return !pointer && !node;
     }
 
-    ybool_t ret = _yvar_list_push_back_internal(buffer, yvar, node, yfalse);
-    YUKI_ASSERT(!ybuffer_available_size(buffer));
-    return ret;
+    return (yuint64_t)(uintptr_t)pointer - context->base == (yuint64_t)((const char *)node - context->buf);
 }
 
-ybool_t _yvar_map_get(const yvar_t * map, const yvar_t * key, yvar_t * value)
+/**
+ * check an encoded var. if buffer is a private copy, its pointers are relocated as well.
+ * vars are walked in the same order as encoding, so that every block is visited exactly once.
+ */
+static ybool_t _yvar_view_element(yvar_view_context_t * context, yvar_t * yvar, ysize_t depth)
 {
-    if (!map || !key || !value || !yvar_is_map(*map)) {
-        YUKI_LOG_FATAL("invalid param");
+    char * mem;
+    ysize_t index;
+
+    if (depth > YVAR_ENCODED_MAX_DEPTH || yvar->type >= YVAR_TYPE_MAX || yvar->type == YVAR_TYPE_STRIDED_ARRAY
+        || (yvar->options & YVAR_ENCODED_INVALID_OPTIONS)) {
+        YUKI_LOG_DEBUG("bad var in encoded var. [type: %d] [options: %d]", yvar->type, yvar->options);
         return yfalse;
     }
 
-    static yvar_t undefined = YVAR_UNDEFINED();
-    yvar_t * keys = map->data.ymap_data.keys;
-    yvar_t * values = map->data.ymap_data.values;
+    switch (yvar->type) {
+        case YVAR_TYPE_ARRAY:
+        {
+            ysize_t cnt = yvar->data.yarray_data.size;
 
-    if (!yvar_is_array(*keys) || !yvar_is_array(*values)) {
-        YUKI_LOG_FATAL("map keys or values is not an array. why?");
-        return yfalse;
-    }
+            if (cnt > context->size / sizeof(yvar_t)
+                || !_yvar_view_block(context, yvar->data.yarray_data.yvars, 0, cnt * sizeof(yvar_t), &mem)) {
+                return yfalse;
+            }
 
-    // TODO: for sorted map, use binary search
-    ysize_t i = 0;
-    FOREACH_YVAR_ARRAY(*keys, v) {
-        if (yvar_equal(*v, *key)) {
-            return yvar_array_get(*values, i, *value);
+            _YVAR_VIEW_SET(context, yvar->data.yarray_data.yvars, (yvar_t *)mem);
+
+            for (index = 0; index < cnt; index++) {
+                if (!_yvar_view_element(context, yvar->data.yarray_data.yvars + index, depth + 1)) {
+                    return yfalse;
+                }
+            }
+
+            break;
         }
+        case YVAR_TYPE_PACKED_ARRAY:
+        {
+            ysize_t item_size = _YVAR_PACKED_ITEM_SIZE(yvar->data.ypacked_array_data.item_type);
 
-        i++;
+            if (!item_size || !_yvar_view_block(context, yvar->data.ypacked_array_data.items, 0,
+                (ysize_t)yvar->data.ypacked_array_data.size * item_size, &mem)) {
+                YUKI_LOG_DEBUG("bad packed array in encoded var");
+                return yfalse;
+            }
+
+            _YVAR_VIEW_SET(context, yvar->data.ypacked_array_data.items, (void *)mem);
+            break;
+        }
+        case YVAR_TYPE_LIST:
+        {
+            const void * next = yvar->data.ylist_data.head;
+            ylist_node_t * prev = NULL;
+            ylist_node_t * node = NULL;
+            ysize_t cnt = 0;
+
+            while (next) {
+                if (!_yvar_view_block(context, next, 0, sizeof(ylist_node_t), &mem)) {
+                    return yfalse;
+                }
+
+                node = (ylist_node_t *)mem;
+
+                if (node->begin || !node->end || node->end > YLIST_NODE_CAPACITY || node->flags
+                    || !_yvar_view_same(context, node->prev, prev)) {
+                    YUKI_LOG_DEBUG("bad list node in encoded var");
+                    return yfalse;
+                }
+
+                if (prev) {
+                    _YVAR_VIEW_SET(context, prev->next, node);
+                } else {
+                    _YVAR_VIEW_SET(context, yvar->data.ylist_data.head, node);
+                }
+
+                _YVAR_VIEW_SET(context, node->prev, prev);
+
+                for (index = 0; index < node->end; index++) {
+                    if (!_yvar_view_element(context, node->yvars + index, depth + 1)) {
+                        return yfalse;
+                    }
+                }
+
+                cnt += node->end;
+                next = node->next;
+                prev = node;
+            }
+
+            if (!_yvar_view_same(context, yvar->data.ylist_data.tail, node)
+                || (node && yvar->data.ylist_data.head->count != cnt)) {
+                YUKI_LOG_DEBUG("bad list in encoded var");
+                return yfalse;
+            }
+
+            _YVAR_VIEW_SET(context, yvar->data.ylist_data.tail, node);
+            break;
+        }
+        case YVAR_TYPE_MAP:
+        {
+            const void * pointer = yvar->data.ymap_data.keys;
+            yuint64_t keys_offset = (yuint64_t)(uintptr_t)pointer - context->base;
+            ybool_t hashed = yvar_has_option(*yvar, YVAR_OPTION_HASHED)? ytrue: yfalse;
+            yvar_t * keys;
+
+            if (pointer && context->keys_offset && keys_offset == context->keys_offset) {
+                if (hashed != context->keys_hashed) {
+                    YUKI_LOG_DEBUG("bad map in encoded var");
+                    return yfalse;
+                }
+
+                keys = (yvar_t *)(context->buf + keys_offset);
+                _YVAR_VIEW_SET(context, yvar->data.ymap_data.keys, keys);
+            } else {
+                // index is right before keys var. its size depends on number of keys.
+                if (!pointer || keys_offset < context->offset || keys_offset % _YBUFFER_ALLOC_ALIGN
+                    || keys_offset > context->size - sizeof(yvar_t)) {
+                    YUKI_LOG_DEBUG("bad map keys in encoded var");
+                    return yfalse;
+                }
+
+                keys = (yvar_t *)(context->buf + keys_offset);
+
+                if (!yvar_is_array(*keys) || keys->data.yarray_data.size > context->size / sizeof(yvar_t)) {
+                    YUKI_LOG_DEBUG("bad map keys in encoded var");
+                    return yfalse;
+                }
+
+                _YVAR_VIEW_SET(context, yvar->data.ymap_data.keys, keys);
+
+                ysize_t count = yvar_count(*keys);
+                ysize_t capacity = _yvar_map_index_capacity(yvar);
+                ysize_t index_size = _yvar_map_index_mem_size(yvar);
+
+                if (hashed != (capacity? ytrue: yfalse)
+                    || !_yvar_view_block(context, pointer, index_size, index_size + sizeof(yvar_t), &mem)) {
+                    YUKI_LOG_DEBUG("bad map index in encoded var");
+                    return yfalse;
+                }
+
+                if (capacity) {
+                    const ymap_index_t * map_index = _yvar_map_index(keys);
+                    const ymap_index_slot_t * slots;
+                    ysize_t used = 0;
+
+                    if (map_index->mask != capacity - 1 || map_index->count != count) {
+                        YUKI_LOG_DEBUG("bad map index in encoded var");
+                        return yfalse;
+                    }
+
+                    // index has empty slots as long as every slot points to a key
+                    slots = _yvar_map_index_slots(map_index);
+
+                    for (index = 0; index < capacity; index++) {
+                        if (slots[index].index > count) {
+                            YUKI_LOG_DEBUG("bad map index in encoded var");
+                            return yfalse;
+                        }
+
+                        used += slots[index].index? 1: 0;
+                    }
+
+                    if (used != count) {
+                        YUKI_LOG_DEBUG("bad map index in encoded var");
+                        return yfalse;
+                    }
+                }
+
+                if (!_yvar_view_element(context, keys, depth + 1)) {
+                    return yfalse;
+                }
+
+                context->keys_offset = (ysize_t)keys_offset;
+                context->keys_hashed = hashed;
+            }
+
+            if (!_yvar_view_block(context, yvar->data.ymap_data.values, 0, sizeof(yvar_t), &mem)) {
+                return yfalse;
+            }
+
+            _YVAR_VIEW_SET(context, yvar->data.ymap_data.values, (yvar_t *)mem);
+
+            if (!_yvar_view_element(context, yvar->data.ymap_data.values, depth + 1)
+                || !yvar_is_array(*yvar->data.ymap_data.values)) {
+                YUKI_LOG_DEBUG("bad map values in encoded var");
+                return yfalse;
+            }
+
+            break;
+        }
+        case YVAR_TYPE_CSTR:
+        case YVAR_TYPE_STR:
+        {
+            if (yvar_has_option(*yvar, YVAR_OPTION_INLINE)) {
+                yuint8_t size = yvar->data.yinline_str_data.size;
+
+                if (size > YVAR_INLINE_STR_MAX_SIZE || yvar->data.yinline_str_data.str[size]) {
+                    YUKI_LOG_DEBUG("bad str in encoded var");
+                    return yfalse;
+                }
+
+                break;
+            }
+
+            ysize_t len = yvar->data.ycstr_data.size;
+
+            if (!yvar_has_option(*yvar, YVAR_OPTION_HASHED) || len >= context->size
+                || !_yvar_view_block(context, yvar->data.ycstr_data.str, YVAR_STR_HASH_SIZE,
+                    YVAR_STR_HASH_SIZE + len + 1, &mem) || mem[len]) {
+                YUKI_LOG_DEBUG("bad str in encoded var");
+                return yfalse;
+            }
+
+            _YVAR_VIEW_SET(context, yvar->data.ystr_data.str, mem);
+            break;
+        }
     }
 
-    YUKI_LOG_DEBUG("key is not found");
-    yvar_assign(*value, undefined);
-    return yfalse;
+    return ytrue;
 }
 
 /**
- * clone a map thru a raw key-value array of vars.
- * this function can help user to create a map in a easier way.
- * @code
- * yvar_t raw_arr[][2] = {
- *     {YVAR_CSTR("uid"), YVAR_UINT64(123456UL)}, // "uid" => 123456
- *     {YVAR_CSTR("cash"), YVAR_INT64(234L)},     // "cash" => 234
- *     {YVAR_CSTR("diamond"), YVAR_UINT64(123L)}, // "diamond" => 123
- * };
- * yvar_t * map;
- * yvar_map_clone(map, raw_arr, sizeof(raw_arr) / sizeof(raw_arr[0]);
- * // or
- * yvar_map_pin(map, raw_arr, sizeof(raw_arr) / sizeof(raw_arr[0]);
- *
- * // a macro yvar_map_smart_create() is available to make code a little simpler.
- * yvar_map_smart_clone(map, raw_arr);
- * // or
- * yvar_map_smart_pin(map, raw_arr);
- * @endcode
+ * check header of an encoded buffer and get size of encoded var. return 0 if header is bad.
  */
-ybool_t _yvar_map_clone(yvar_t ** map, yvar_map_kv_t raw_arr, ysize_t size)
+static ysize_t _yvar_view_header(const void * buf, ysize_t size)
 {
-    if (!map || !raw_arr || !size) {
-        YUKI_LOG_FATAL("invalid param");
-        return yfalse;
-    }
-
-    yvar_t even_array[size];
-    yvar_t odd_array[size];
-    _yvar_map_assoc_array_sort(raw_arr, size, even_array, size, odd_array, size);
+    const yvar_encoded_header_t * header = (const yvar_encoded_header_t *)buf;
+    ysize_t offset = YVAR_ENCODED_HEADER_SIZE + ybuffer_round_up(sizeof(yvar_t));
 
-    yvar_t keys = YVAR_ARRAY(even_array);
-    yvar_t values = YVAR_ARRAY(odd_array);
-    yvar_t local_map = YVAR_MAP(keys, values);
+    if (size < offset || header->magic != YVAR_ENCODED_MAGIC || header->version != YUKI_VAR_VERSION
+        || header->pointer_size != sizeof(void *) || header->size < offset || header->size > size
+        || header->size % _YBUFFER_ALLOC_ALIGN) {
+        YUKI_LOG_DEBUG("bad header of encoded var. [size: %lu]", size);
+        return 0;
+    }
 
-    return yvar_clone(*map, local_map);
+    return (ysize_t)header->size;
 }
 
 /**
- * pin a map thru a raw key-value array of vars.
- * @see _yvar_map_clone()
+ * check every var in an encoded buffer and get root var.
+ * if relocate is true, buf is a private copy and its pointers are rewritten to point into it.
  */
-ybool_t _yvar_map_pin(yvar_t ** map, yvar_map_kv_t raw_arr, ysize_t size)
+static ybool_t _yvar_view_internal(yvar_t ** view, char * buf, ysize_t size, yuint64_t base, ybool_t relocate)
 {
-    if (!map || !raw_arr || !size) {
-        YUKI_LOG_FATAL("invalid param");
-        return yfalse;
-    }
-
-    yvar_t even_array[size];
-    yvar_t odd_array[size];
-    _yvar_map_assoc_array_sort(raw_arr, size, even_array, size, odd_array, size);
-
-    yvar_t keys = YVAR_ARRAY(even_array);
-    yvar_t values = YVAR_ARRAY(odd_array);
-    yvar_t local_map = YVAR_MAP(keys, values);
+    yvar_view_context_t context;
+    memset(&context, 0, sizeof(context));
+    context.buf = buf;
+    context.size = size;
+    context.offset = YVAR_ENCODED_HEADER_SIZE + ybuffer_round_up(sizeof(yvar_t));
+    context.base = base;
+    context.relocate = relocate;
 
-    return yvar_pin(*map, local_map);
-}
+    yvar_t * root = (yvar_t *)(buf + YVAR_ENCODED_HEADER_SIZE);
 
-ybool_t _yvar_assign(yvar_t * lhs, const yvar_t * rhs)
-{
-    if (!lhs || !rhs) {
-        YUKI_LOG_FATAL("invalid param");
+    if (!_yvar_view_element(&context, root, 0)) {
         return yfalse;
     }
 
-    if (yvar_has_option(*lhs, YVAR_OPTION_READONLY | YVAR_OPTION_PINNED)) {
-        YUKI_LOG_DEBUG("left hand side value is readonly");
+    if (context.offset != context.size) {
+        YUKI_LOG_DEBUG("unused bytes in encoded var. [offset: %lu]", context.offset);
         return yfalse;
     }
 
-    *lhs = *rhs;
+    *view = root;
     return ytrue;
 }
 
-ybool_t _yvar_clone(yvar_t ** new_var, const yvar_t * old_var)
+/**
+ * get root var of an encoded buffer, e.g. a file mapped by mmap() at the address where it's encoded.
+ * buffer is checked but never written, so it can be mapped readonly and shared by processes.
+ * buffer must be aligned to 8 bytes and be at its base address, i.e. where it's encoded.
+ * use yvar_view_copy() for buffer at any other address.
+ * view is valid as long as buffer. don't unpin it.
+ */
+ybool_t _yvar_view(yvar_t ** view, const void * buf, ysize_t size)
 {
-    if (!new_var || !old_var) {
+    if (!view || !buf || ((uintptr_t)buf & (_YBUFFER_ALLOC_ALIGN - 1))) {
         YUKI_LOG_FATAL("invalid param");
         return yfalse;
     }
 
-    ysize_t size = _yvar_mem_size(old_var);
-    ybuffer_t * buffer = ybuffer_create(size);
-
-    return _yvar_clone_internal(buffer, new_var, old_var);
-}
+    ysize_t encoded_size = _yvar_view_header(buf, size);
 
-ybool_t _yvar_pin(yvar_t ** new_var, const yvar_t * old_var)
-{
-    if (!new_var || !old_var) {
-        YUKI_LOG_FATAL("invalid param");
+    if (!encoded_size) {
         return yfalse;
     }
 
-    ysize_t size = _yvar_mem_size(old_var);
-    ybuffer_t * buffer = ybuffer_create_global(size);
-    ybool_t ret = _yvar_clone_internal(buffer, new_var, old_var);
+    const yvar_encoded_header_t * header = (const yvar_encoded_header_t *)buf;
 
-    if (!ret) {
-        YUKI_LOG_FATAL("unable to pin var");
+    // pointers in buffer are only valid at base address.
+    if (header->base != (yuint64_t)(uintptr_t)buf) {
+        YUKI_LOG_DEBUG("encoded var is not at base address. copy it by yvar_view_copy()");
         return yfalse;
     }
 
-    yvar_set_option(**new_var, YVAR_OPTION_PINNED);
-    return ret;
+    return _yvar_view_internal(view, (char *)buf, encoded_size, header->base, yfalse);
 }
 
-ybool_t _yvar_unpin(yvar_t * yvar)
+/**
+ * copy an encoded buffer to thread arena and get root var of the copy.
+ * pointers in the copy are relocated. buffer itself is never written and can be at any address,
+ * e.g. a message from another process.
+ * view is valid until current thread cleans up. don't unpin it.
+ */
+ybool_t _yvar_view_copy(yvar_t ** view, const void * buf, ysize_t size)
 {
-    if (!yvar) {
+    if (!view || !buf) {
         YUKI_LOG_FATAL("invalid param");
         return yfalse;
     }
 
-    if (!yvar_has_option(*yvar, YVAR_OPTION_PINNED)) {
-        YUKI_LOG_DEBUG("var is not pinned");
+    ysize_t encoded_size = _yvar_view_header(buf, size);
+
+    if (!encoded_size) {
         return yfalse;
     }
 
-    if (!ybuffer_destroy_global_pointer(yvar)) {
-        YUKI_LOG_WARNING("fail to destroy global pointer");
+    char * copy = (char *)ybuffer_simple_alloc(encoded_size);
+
+    if (!copy) {
+        YUKI_LOG_WARNING("out of memory");
         return yfalse;
     }
 
-    yvar_unset_option(*yvar, YVAR_OPTION_PINNED);
+    memcpy(copy, buf, encoded_size);
+    yvar_encoded_header_t * header = (yvar_encoded_header_t *)copy;
+
+    if (!_yvar_view_internal(view, copy, encoded_size, header->base, ytrue)) {
+        return yfalse;
+    }
+
+    // copy can be viewed again in place
+    header->base = (yuint64_t)(uintptr_t)copy;
     return ytrue;
 }
 
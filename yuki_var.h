@@ -28,6 +28,13 @@ extern "C" {
 #define YVAR_STR() _YVAR_INIT(YVAR_TYPE_STR, ystr, {0})
 #define YVAR_ARRAY(d) _YVAR_INIT(YVAR_TYPE_ARRAY, yarray, {.size = sizeof((d)) / sizeof(yvar_t), .yvars = (d)})
 #define YVAR_ARRAY_WITH_SIZE(d, s) _YVAR_INIT(YVAR_TYPE_ARRAY, yarray, {.size = (s), .yvars = (d)})
+// packed array items must be int-like. var is undefined if item type is not.
+#define YVAR_PACKED_ITEM_TYPE_IS_VALID(t) ((t) >= YVAR_TYPE_INT_MIN && (t) <= YVAR_TYPE_INT_MAX)
+#define _YVAR_PACKED_ARRAY_INIT(t, d, s) _YVAR_INIT(YVAR_PACKED_ITEM_TYPE_IS_VALID(t)? YVAR_TYPE_PACKED_ARRAY: YVAR_TYPE_UNDEFINED, \
+    ypacked_array, {.size = YVAR_PACKED_ITEM_TYPE_IS_VALID(t)? (s): 0, .item_type = YVAR_PACKED_ITEM_TYPE_IS_VALID(t)? (t): 0, \
+    .items = YVAR_PACKED_ITEM_TYPE_IS_VALID(t)? (d): NULL})
+#define YVAR_PACKED_ARRAY(t, d) _YVAR_PACKED_ARRAY_INIT((t), (d), sizeof((d)) / sizeof((d)[0]))
+#define YVAR_PACKED_ARRAY_WITH_SIZE(t, d, s) _YVAR_PACKED_ARRAY_INIT((t), (d), (s))
 #define YVAR_LIST() _YVAR_INIT(YVAR_TYPE_LIST, ylist, {0})
 #define YVAR_MAP(k, v) _YVAR_INIT(YVAR_TYPE_MAP, ymap, {&(k), &(v)})
 
@@ -59,6 +66,10 @@ extern "C" {
 #define yvar_uint32(yvar, d) _YVAR_INIT_FOR_CPP(yvar, YVAR_TYPE_UINT32, yuint32, (d))
 #define yvar_int64(yvar, d) _YVAR_INIT_FOR_CPP(yvar, YVAR_TYPE_INT64, yint64, (d))
 #define yvar_uint64(yvar, d) _YVAR_INIT_FOR_CPP(yvar, YVAR_TYPE_UINT64, yuint64, (d))
+/**
+ * d should be a str literal. size is sizeof(d) - 1 and all these chars are compared and cloned.
+ * for a char array holding a shorter str, use yvar_cstr_with_size() with its real length.
+ */
 #define yvar_cstr(yvar, d) do { \
         yvar_t * pointer = &(yvar); \
         ycstr_t str = {sizeof((d)) - 1, (d)}; \
@@ -99,6 +110,20 @@ extern "C" {
         pointer->options = YVAR_OPTION_DEFAULT; \
         pointer->data.yarray_data = array; \
     } while (0)
+#define yvar_packed_array(yvar, t, d) yvar_packed_array_with_size(yvar, t, d, sizeof((d)) / sizeof((d)[0]))
+#define yvar_packed_array_with_size(yvar, t, d, s) do { \
+        yvar_t * pointer = &(yvar); \
+        if (!YVAR_PACKED_ITEM_TYPE_IS_VALID(t)) { \
+            YUKI_LOG_FATAL("invalid packed array item type %d", (int)(t)); \
+            yvar_undefined(yvar); \
+            break; \
+        } \
+        ypacked_array_t array = {(yuint32_t)(s), (t), (d)}; \
+        pointer->type = YVAR_TYPE_PACKED_ARRAY; \
+        pointer->version = YUKI_VAR_VERSION; \
+        pointer->options = YVAR_OPTION_DEFAULT; \
+        pointer->data.ypacked_array_data = array; \
+    } while (0)
 #define yvar_list(yvar) do { \
         yvar_t * pointer = &(yvar); \
         ylist_t list = {0}; \
@@ -133,6 +158,8 @@ extern "C" {
 #define yvar_is_array(yvar)     _YVAR_IS_TYPE((yvar), YVAR_TYPE_ARRAY)
 #define yvar_is_list(yvar)      _YVAR_IS_TYPE((yvar), YVAR_TYPE_LIST)
 #define yvar_is_map(yvar)       _YVAR_IS_TYPE((yvar), YVAR_TYPE_MAP)
+#define yvar_is_packed_array(yvar) _YVAR_IS_TYPE((yvar), YVAR_TYPE_PACKED_ARRAY)
+#define yvar_is_strided_array(yvar) _YVAR_IS_TYPE((yvar), YVAR_TYPE_STRIDED_ARRAY)
 
 #define yvar_to_bool(yvar)      _yvar_to_bool(&(yvar))
 #define yvar_to_int8(yvar)      _yvar_to_int8(&(yvar))
@@ -159,6 +186,15 @@ extern "C" {
 #define yvar_get_cstr(yvar, output, size) _yvar_get_cstr(&(yvar), (output), (size))
 #define yvar_get_str(yvar, output, size) _yvar_get_str(&(yvar), (output), (size))
 
+#define yvar_parse_int8(yvar, output) _yvar_parse_int8(&(yvar), &(output))
+#define yvar_parse_uint8(yvar, output) _yvar_parse_uint8(&(yvar), &(output))
+#define yvar_parse_int16(yvar, output) _yvar_parse_int16(&(yvar), &(output))
+#define yvar_parse_uint16(yvar, output) _yvar_parse_uint16(&(yvar), &(output))
+#define yvar_parse_int32(yvar, output) _yvar_parse_int32(&(yvar), &(output))
+#define yvar_parse_uint32(yvar, output) _yvar_parse_uint32(&(yvar), &(output))
+#define yvar_parse_int64(yvar, output) _yvar_parse_int64(&(yvar), &(output))
+#define yvar_parse_uint64(yvar, output) _yvar_parse_uint64(&(yvar), &(output))
+
 #define yvar_has_option(yvar, opt) _yvar_has_option(&(yvar), (yuint32_t)(opt))
 #define yvar_set_option(yvar, opt) _yvar_set_option(&(yvar), (yuint32_t)(opt))
 #define yvar_unset_option(yvar, opt) _yvar_unset_option(&(yvar), (yuint32_t)(opt))
@@ -169,6 +205,7 @@ extern "C" {
 
 #define yvar_str_strlen(yvar) _yvar_cstr_strlen(&(yvar))
 #define yvar_cstr_strlen(yvar) _yvar_cstr_strlen(&(yvar))
+#define yvar_str_unshare(yvar) _yvar_str_unshare(&(yvar))
 
 #define yvar_triple_array_clone(yvar, triple_array, size, dimension) _yvar_triple_array_clone(&(yvar), (triple_array), (size), (dimension))
 #define yvar_triple_array_smart_clone(yvar, triple_array) _yvar_triple_array_clone(&(yvar), (triple_array), \
@@ -178,36 +215,106 @@ extern "C" {
     (sizeof(triple_array) / sizeof(triple_array[0])), (sizeof(triple_array[0]) / sizeof(triple_array[0][0])))
 #define yvar_array_get(yvar, index, output) _yvar_array_get(&(yvar), (index), &(output))
 #define yvar_array_size(yvar) _yvar_array_size(&(yvar))
+#define yvar_array_capacity(yvar) _yvar_array_capacity(&(yvar))
+#define yvar_array_reserve(yvar, capacity) _yvar_array_reserve(&(yvar), (capacity))
+#define yvar_array_push_back(yvar, value) _yvar_array_push_back(&(yvar), &(value))
+#define yvar_array_shrink(yvar) _yvar_array_shrink(&(yvar))
+#define yvar_array_sort(yvar) _yvar_array_sort(&(yvar))
+#define yvar_array_unique(yvar) _yvar_array_unique(&(yvar))
+#define yvar_array_intersect(lhs, rhs, output) _yvar_array_intersect(&(lhs), &(rhs), &(output))
+#define yvar_array_union(lhs, rhs, output) _yvar_array_union(&(lhs), &(rhs), &(output))
+#define yvar_array_pack(packed, array, item_type) _yvar_array_pack(&(packed), &(array), (item_type))
+#define yvar_array_unpack(array, packed) _yvar_array_unpack(&(array), &(packed))
+#define yvar_array_slice(array, begin, end, view) _yvar_array_slice(&(array), (begin), (end), 1, &(view))
+#define yvar_array_stride(array, begin, end, stride, view) _yvar_array_slice(&(array), (begin), (end), (stride), &(view))
+#define yvar_array_chunk(array, chunk_size, offset, chunk) _yvar_array_chunk(&(array), (chunk_size), &(offset), &(chunk))
+#define yvar_array_sum(array, sum) _yvar_array_sum(&(array), &(sum))
+#define yvar_array_minmax(array, min, max) _yvar_array_minmax(&(array), &(min), &(max))
+#define yvar_array_count_eq(array, value) _yvar_array_count_eq(&(array), &(value))
+#define yvar_array_filter_cmp(array, op, value, output) _yvar_array_filter_cmp(&(array), (op), &(value), &(output))
 
 #define yvar_list_push_back(yvar, node) _yvar_list_push_back(&(yvar), &(node))
+#define yvar_list_pop_front(yvar, output) _yvar_list_pop_front(&(yvar), &(output))
+#define yvar_list_pop_back(yvar, output) _yvar_list_pop_back(&(yvar), &(output))
 
 #define yvar_map_get(map, k, v) _yvar_map_get(&(map), &(k), &(v))
 #define yvar_map_clone(map, raw_arr, size) _yvar_map_clone(&(map), (raw_arr), (size))
 #define yvar_map_smart_clone(map, raw_arr) _yvar_map_clone(&(map), (raw_arr), (sizeof((raw_arr)) / sizeof((raw_arr)[0])))
 #define yvar_map_pin(map, raw_arr, size) _yvar_map_pin(&(map), (raw_arr), (size))
 #define yvar_map_smart_pin(map, raw_arr) _yvar_map_pin(&(map), (raw_arr), (sizeof((raw_arr)) / sizeof((raw_arr)[0])))
+#define yvar_map_sorted_clone(map, raw_arr, size) _yvar_map_sorted_clone(&(map), (raw_arr), (size))
+#define yvar_map_smart_sorted_clone(map, raw_arr) _yvar_map_sorted_clone(&(map), (raw_arr), (sizeof((raw_arr)) / sizeof((raw_arr)[0])))
+#define yvar_map_sorted_pin(map, raw_arr, size) _yvar_map_sorted_pin(&(map), (raw_arr), (size))
+#define yvar_map_smart_sorted_pin(map, raw_arr) _yvar_map_sorted_pin(&(map), (raw_arr), (sizeof((raw_arr)) / sizeof((raw_arr)[0])))
+#define yvar_map_range(map, lower, upper, keys, values) _yvar_map_range(&(map), &(lower), &(upper), &(keys), &(values))
+#define yvar_map_range_from(map, lower, keys, values) _yvar_map_range(&(map), &(lower), NULL, &(keys), &(values))
+#define yvar_map_range_to(map, upper, keys, values) _yvar_map_range(&(map), NULL, &(upper), &(keys), &(values))
+#define yvar_map_range_all(map, keys, values) _yvar_map_range(&(map), NULL, NULL, &(keys), &(values))
 
 #define yvar_assign(lhs, rhs) _yvar_assign(&(lhs), &(rhs))
 #define yvar_clone(new_var, old_var) _yvar_clone(&(new_var), &(old_var))
 #define yvar_pin(new_var, old_var) _yvar_pin(&(new_var), &(old_var))
 #define yvar_unpin(yvar) _yvar_unpin((yvar))
+#define yvar_freeze(new_var, old_var) _yvar_freeze(&(new_var), &(old_var))
+#define yvar_thaw(yvar) _yvar_thaw(&(yvar))
+#define yvar_cow_assign(lhs, rhs) _yvar_cow_assign(&(lhs), &(rhs))
+#define yvar_move(dst, src) _yvar_move(&(dst), &(src))
+#define yvar_encoded_size(yvar) _yvar_encoded_size(&(yvar))
+#define yvar_encode(yvar, buf, size) _yvar_encode(&(yvar), (buf), (size))
+#define yvar_view(view, buf, size) _yvar_view(&(view), (buf), (size))
+#define yvar_view_copy(view, buf, size) _yvar_view_copy(&(view), (buf), (size))
 #define yvar_memzero(yvar) _yvar_memzero(&(yvar))
 #define yvar_unset(yvar) yvar_memzero(yvar)
 
-/** get read/write reference of internal string buffer of cstr var. */
-#define yvar_cstr_buffer(yvar) ((yvar).data.ycstr_data.str)
-/** get read/write reference of internal string buffer of cstr var. */
-#define yvar_str_buffer(yvar) ((yvar).data.ystr_data.str)
+/**
+ * get internal string buffer of cstr var.
+ * chars of a cloned str are interned (YVAR_OPTION_INTERNED) and read-only, as other strs may share them.
+ * call yvar_str_unshare() to get a private copy before writing.
+ * a short str is stored inside cloned var. its buffer is valid as long as the var.
+ * @note
+ * it's not an lvalue since short strs are stored inline.
+ * use yvar_cstr_buffer_ref() to assign buffer of a str which is not inline.
+ */
+#define yvar_cstr_buffer(yvar) (((yvar).options & YVAR_OPTION_INLINE)? \
+    (yvar).data.yinline_str_data.str: (yvar).data.ycstr_data.str)
+/** get read/write reference of internal string buffer of cstr var which is not inline. */
+#define yvar_cstr_buffer_ref(yvar) ((yvar).data.ycstr_data.str)
+/** get read/write reference of native items of packed array var. */
+#define yvar_packed_array_buffer(yvar) ((yvar).data.ypacked_array_data.items)
+/** get var type of items of packed array var. */
+#define yvar_packed_array_item_type(yvar) ((yvar).data.ypacked_array_data.item_type)
+/**
+ * get internal string buffer of str var.
+ * @see yvar_cstr_buffer()
+ */
+#define yvar_str_buffer(yvar) (((yvar).options & YVAR_OPTION_INLINE)? \
+    (yvar).data.yinline_str_data.str: (yvar).data.ystr_data.str)
+/** get read/write reference of internal string buffer of str var which is not inline. */
+#define yvar_str_buffer_ref(yvar) ((yvar).data.ystr_data.str)
 
 // hey friend, i don't intend to use following code to frighten you.
 // but it's really too complex to implement a 'foreach' loop in C.
 // if you find any issue when using these 'foreach's, please keep calm and contact me.
 
+// move to next var in an unrolled list. jump to next node when current node is exhausted.
+#define _YVAR_LIST_NEXT(v, n, e) \
+    ((v) + 1 != (e)? (v) + 1: \
+        ((n) = (n)->next)? ((e) = (n)->yvars + (n)->end, (n)->yvars + (n)->begin): NULL)
+
+// vars, stride and size of a generic array or a strided array view. generic array has stride 1.
+#define _YVAR_FOREACH_ARRAY_VARS(y) (yvar_is_strided_array(*(y))? \
+    (y)->data.ystrided_array_data.yvars: (y)->data.yarray_data.yvars)
+#define _YVAR_FOREACH_ARRAY_STRIDE(y) (yvar_is_strided_array(*(y))? \
+    (ysize_t)(y)->data.ystrided_array_data.stride: (ysize_t)1)
+#define _YVAR_FOREACH_ARRAY_SIZE(y) (yvar_is_strided_array(*(y))? \
+    (ysize_t)(y)->data.ystrided_array_data.size: (y)->data.yarray_data.size)
+
 // if C99 is enabled, declare variable in for loop
 #if (defined(YUKI_CONFIG_C99_ENABLED))
 /**
  * iterate array elements in a var.
- * if var is not an array, do nothing.
+ * var can be a generic array or a strided array view made by yvar_array_stride().
+ * if var is neither, do nothing.
  * 
  * sample code.
  * @code
@@ -222,14 +329,22 @@ extern "C" {
  */
 # define FOREACH_YVAR_ARRAY(arr, value) \
     const yvar_t * _YVAR_TEMP_VARIABLE(yvar##key, __LINE__) = &(arr); \
-    if (!yvar_is_array(*_YVAR_TEMP_VARIABLE(yvar##key, __LINE__))) { \
+    const ysize_t _YVAR_TEMP_VARIABLE(stride##key, __LINE__) = \
+        _YVAR_FOREACH_ARRAY_STRIDE(_YVAR_TEMP_VARIABLE(yvar##key, __LINE__)); \
+    const ysize_t _YVAR_TEMP_VARIABLE(size##key, __LINE__) = \
+        _YVAR_FOREACH_ARRAY_SIZE(_YVAR_TEMP_VARIABLE(yvar##key, __LINE__)); \
+    yvar_t * const _YVAR_TEMP_VARIABLE(last##key, __LINE__) = _YVAR_TEMP_VARIABLE(size##key, __LINE__)? \
+        _YVAR_FOREACH_ARRAY_VARS(_YVAR_TEMP_VARIABLE(yvar##key, __LINE__)) + \
+        (_YVAR_TEMP_VARIABLE(size##key, __LINE__) - 1) * _YVAR_TEMP_VARIABLE(stride##key, __LINE__): NULL; \
+    if (!yvar_is_array(*_YVAR_TEMP_VARIABLE(yvar##key, __LINE__)) \
+        && !yvar_is_strided_array(*_YVAR_TEMP_VARIABLE(yvar##key, __LINE__))) { \
         YUKI_LOG_DEBUG("cannot do foreach array on a non array var"); \
     } else \
-        for (yvar_t *value = _YVAR_TEMP_VARIABLE(yvar##key, __LINE__)->data.yarray_data.yvars, \
-            *_YVAR_TEMP_VARIABLE(end##key, __LINE__) = \
-                _YVAR_TEMP_VARIABLE(yvar##key, __LINE__)->data.yarray_data.yvars + \
-                _YVAR_TEMP_VARIABLE(yvar##key, __LINE__)->data.yarray_data.size; \
-            value != _YVAR_TEMP_VARIABLE(end##key, __LINE__); value++)
+        for (yvar_t *value = _YVAR_TEMP_VARIABLE(size##key, __LINE__)? \
+                _YVAR_FOREACH_ARRAY_VARS(_YVAR_TEMP_VARIABLE(yvar##key, __LINE__)): NULL; \
+            value; \
+            value = value != _YVAR_TEMP_VARIABLE(last##key, __LINE__)? \
+                value + _YVAR_TEMP_VARIABLE(stride##key, __LINE__): NULL)
 
 /**
  * iterate list elements in a var.
@@ -254,13 +369,46 @@ extern "C" {
  */
 # define FOREACH_YVAR_LIST(list, value) \
     const yvar_t * _YVAR_TEMP_VARIABLE(yvar##key, __LINE__) = &(list); \
-    ylist_node_t * _YVAR_TEMP_VARIABLE(head##key, __LINE__) = _YVAR_TEMP_VARIABLE(yvar##key, __LINE__)->data.ylist_data.head; \
+    ylist_node_t * _YVAR_TEMP_VARIABLE(node##key, __LINE__) = yvar_is_list(*_YVAR_TEMP_VARIABLE(yvar##key, __LINE__))? \
+        _YVAR_TEMP_VARIABLE(yvar##key, __LINE__)->data.ylist_data.head: NULL; \
+    yvar_t * _YVAR_TEMP_VARIABLE(end##key, __LINE__) = _YVAR_TEMP_VARIABLE(node##key, __LINE__)? \
+        _YVAR_TEMP_VARIABLE(node##key, __LINE__)->yvars + _YVAR_TEMP_VARIABLE(node##key, __LINE__)->end: NULL; \
     if (!yvar_is_list(*_YVAR_TEMP_VARIABLE(yvar##key, __LINE__))) { \
         YUKI_LOG_DEBUG("cannot do foreach list on a non list var"); \
     } else \
-        for (yvar_t *value = &_YVAR_TEMP_VARIABLE(head##key, __LINE__)->yvar; \
-            _YVAR_TEMP_VARIABLE(head##key, __LINE__); \
-            value = &(_YVAR_TEMP_VARIABLE(head##key, __LINE__) = _YVAR_TEMP_VARIABLE(head##key, __LINE__)->next)->yvar)
+        for (yvar_t *value = _YVAR_TEMP_VARIABLE(node##key, __LINE__)? \
+                _YVAR_TEMP_VARIABLE(node##key, __LINE__)->yvars + _YVAR_TEMP_VARIABLE(node##key, __LINE__)->begin: NULL; \
+            value; \
+            value = _YVAR_LIST_NEXT(value, _YVAR_TEMP_VARIABLE(node##key, __LINE__), _YVAR_TEMP_VARIABLE(end##key, __LINE__)))
+
+/**
+ * iterate packed array items in a var. each item is boxed to a var.
+ * if var is not a packed array, do nothing.
+ *
+ * sample code.
+ * @code
+ * yint64_t raw_ids[] = {23, 45, 67};
+ * yvar_t ids = YVAR_PACKED_ARRAY(YVAR_TYPE_INT64, raw_ids);
+ *
+ * // note: don't declare 'value' yourself. i will do this for you.
+ * FOREACH_YVAR_PACKED_ARRAY(ids, value) {
+ *     // type of 'value' is yvar_t*. it's a copy of item. modifying it doesn't change array.
+ * }
+ * @endcode
+ */
+# define FOREACH_YVAR_PACKED_ARRAY(arr, value) \
+    const yvar_t * _YVAR_TEMP_VARIABLE(yvar##key, __LINE__) = &(arr); \
+    yvar_t _YVAR_TEMP_VARIABLE(item##key, __LINE__) = YVAR_EMPTY(); \
+    ysize_t _YVAR_TEMP_VARIABLE(index##key, __LINE__) = 0; \
+    if (!yvar_is_packed_array(*_YVAR_TEMP_VARIABLE(yvar##key, __LINE__))) { \
+        YUKI_LOG_DEBUG("cannot do foreach packed array on a non packed array var"); \
+    } else \
+        for (yvar_t *value = &_YVAR_TEMP_VARIABLE(item##key, __LINE__); \
+            _YVAR_TEMP_VARIABLE(index##key, __LINE__) < \
+                _YVAR_TEMP_VARIABLE(yvar##key, __LINE__)->data.ypacked_array_data.size \
+            && _yvar_array_get(_YVAR_TEMP_VARIABLE(yvar##key, __LINE__), \
+                _YVAR_TEMP_VARIABLE(index##key, __LINE__), value); \
+            _YVAR_TEMP_VARIABLE(index##key, __LINE__)++)
 
 /**
  * iterate map elements.
@@ -299,26 +447,52 @@ extern "C" {
 # define FOREACH_YVAR_ARRAY(arr, value) \
     yvar_t * value; \
     const yvar_t * _YVAR_TEMP_VARIABLE(yvar##key, __LINE__) = &(arr); \
-    yvar_t * _YVAR_TEMP_VARIABLE(end##key, __LINE__); \
-    if (!yvar_is_array(*_YVAR_TEMP_VARIABLE(yvar##key, __LINE__))) { \
+    const ysize_t _YVAR_TEMP_VARIABLE(stride##key, __LINE__) = \
+        _YVAR_FOREACH_ARRAY_STRIDE(_YVAR_TEMP_VARIABLE(yvar##key, __LINE__)); \
+    const ysize_t _YVAR_TEMP_VARIABLE(size##key, __LINE__) = \
+        _YVAR_FOREACH_ARRAY_SIZE(_YVAR_TEMP_VARIABLE(yvar##key, __LINE__)); \
+    yvar_t * const _YVAR_TEMP_VARIABLE(last##key, __LINE__) = _YVAR_TEMP_VARIABLE(size##key, __LINE__)? \
+        _YVAR_FOREACH_ARRAY_VARS(_YVAR_TEMP_VARIABLE(yvar##key, __LINE__)) + \
+        (_YVAR_TEMP_VARIABLE(size##key, __LINE__) - 1) * _YVAR_TEMP_VARIABLE(stride##key, __LINE__): NULL; \
+    if (!yvar_is_array(*_YVAR_TEMP_VARIABLE(yvar##key, __LINE__)) \
+        && !yvar_is_strided_array(*_YVAR_TEMP_VARIABLE(yvar##key, __LINE__))) { \
         YUKI_LOG_DEBUG("cannot do foreach array on a non array var"); \
     } else \
-        for (value = _YVAR_TEMP_VARIABLE(yvar##key, __LINE__)->data.yarray_data.yvars, \
-            _YVAR_TEMP_VARIABLE(end##key, __LINE__) = \
-                _YVAR_TEMP_VARIABLE(yvar##key, __LINE__)->data.yarray_data.yvars + \
-                _YVAR_TEMP_VARIABLE(yvar##key, __LINE__)->data.yarray_data.size; \
-            value != _YVAR_TEMP_VARIABLE(end##key, __LINE__); value++)
+        for (value = _YVAR_TEMP_VARIABLE(size##key, __LINE__)? \
+                _YVAR_FOREACH_ARRAY_VARS(_YVAR_TEMP_VARIABLE(yvar##key, __LINE__)): NULL; \
+            value; \
+            value = value != _YVAR_TEMP_VARIABLE(last##key, __LINE__)? \
+                value + _YVAR_TEMP_VARIABLE(stride##key, __LINE__): NULL)
 
 # define FOREACH_YVAR_LIST(list, value) \
     yvar_t * value; \
     const yvar_t * _YVAR_TEMP_VARIABLE(yvar##key, __LINE__) = &(list); \
-    ylist_node_t * _YVAR_TEMP_VARIABLE(head##key, __LINE__) = _YVAR_TEMP_VARIABLE(yvar##key, __LINE__)->data.ylist_data.head; \
+    ylist_node_t * _YVAR_TEMP_VARIABLE(node##key, __LINE__) = yvar_is_list(*_YVAR_TEMP_VARIABLE(yvar##key, __LINE__))? \
+        _YVAR_TEMP_VARIABLE(yvar##key, __LINE__)->data.ylist_data.head: NULL; \
+    yvar_t * _YVAR_TEMP_VARIABLE(end##key, __LINE__) = _YVAR_TEMP_VARIABLE(node##key, __LINE__)? \
+        _YVAR_TEMP_VARIABLE(node##key, __LINE__)->yvars + _YVAR_TEMP_VARIABLE(node##key, __LINE__)->end: NULL; \
     if (!yvar_is_list(*_YVAR_TEMP_VARIABLE(yvar##key, __LINE__))) { \
         YUKI_LOG_DEBUG("cannot do foreach list on a non list var"); \
     } else \
-        for (value = &_YVAR_TEMP_VARIABLE(head##key, __LINE__)->yvar; \
-            _YVAR_TEMP_VARIABLE(head##key, __LINE__); \
-            value = &(_YVAR_TEMP_VARIABLE(head##key, __LINE__) = _YVAR_TEMP_VARIABLE(head##key, __LINE__)->next)->yvar)
+        for (value = _YVAR_TEMP_VARIABLE(node##key, __LINE__)? \
+                _YVAR_TEMP_VARIABLE(node##key, __LINE__)->yvars + _YVAR_TEMP_VARIABLE(node##key, __LINE__)->begin: NULL; \
+            value; \
+            value = _YVAR_LIST_NEXT(value, _YVAR_TEMP_VARIABLE(node##key, __LINE__), _YVAR_TEMP_VARIABLE(end##key, __LINE__)))
+
+# define FOREACH_YVAR_PACKED_ARRAY(arr, value) \
+    yvar_t * value; \
+    const yvar_t * _YVAR_TEMP_VARIABLE(yvar##key, __LINE__) = &(arr); \
+    yvar_t _YVAR_TEMP_VARIABLE(item##key, __LINE__) = YVAR_EMPTY(); \
+    ysize_t _YVAR_TEMP_VARIABLE(index##key, __LINE__); \
+    if (!yvar_is_packed_array(*_YVAR_TEMP_VARIABLE(yvar##key, __LINE__))) { \
+        YUKI_LOG_DEBUG("cannot do foreach packed array on a non packed array var"); \
+    } else \
+        for (_YVAR_TEMP_VARIABLE(index##key, __LINE__) = 0, value = &_YVAR_TEMP_VARIABLE(item##key, __LINE__); \
+            _YVAR_TEMP_VARIABLE(index##key, __LINE__) < \
+                _YVAR_TEMP_VARIABLE(yvar##key, __LINE__)->data.ypacked_array_data.size \
+            && _yvar_array_get(_YVAR_TEMP_VARIABLE(yvar##key, __LINE__), \
+                _YVAR_TEMP_VARIABLE(index##key, __LINE__), value); \
+            _YVAR_TEMP_VARIABLE(index##key, __LINE__)++)
 
 # define FOREACH_YVAR_MAP(map, key, value) \
     yvar_t *key, *value; \
@@ -343,6 +517,7 @@ extern "C" {
 #define _YVAR_GET_FUNCTION_DECLARE(t) ybool_t _yvar_get_##t(const yvar_t * yvar, y##t##_t * output)
 #define _YVAR_GET_FUNCTION_DECLARE_WITH_SIZE(t) ybool_t _yvar_get_##t(const yvar_t * yvar, char * output, ysize_t size)
 #define _YVAR_TO_FUNCTION_DECLARE(t) y##t##_t _yvar_to_##t(const yvar_t * yvar)
+#define _YVAR_PARSE_FUNCTION_DECLARE(t) ybool_t _yvar_parse_##t(const yvar_t * yvar, y##t##_t * output)
 
 _YVAR_GET_FUNCTION_DECLARE(bool);
 _YVAR_GET_FUNCTION_DECLARE(int8);
@@ -366,6 +541,15 @@ _YVAR_TO_FUNCTION_DECLARE(uint32);
 _YVAR_TO_FUNCTION_DECLARE(int64);
 _YVAR_TO_FUNCTION_DECLARE(uint64);
 
+_YVAR_PARSE_FUNCTION_DECLARE(int8);
+_YVAR_PARSE_FUNCTION_DECLARE(uint8);
+_YVAR_PARSE_FUNCTION_DECLARE(int16);
+_YVAR_PARSE_FUNCTION_DECLARE(uint16);
+_YVAR_PARSE_FUNCTION_DECLARE(int32);
+_YVAR_PARSE_FUNCTION_DECLARE(uint32);
+_YVAR_PARSE_FUNCTION_DECLARE(int64);
+_YVAR_PARSE_FUNCTION_DECLARE(uint64);
+
 ybool_t _yvar_like_string(const yvar_t * yvar);
 ybool_t _yvar_like_int(const yvar_t * yvar);
 
@@ -378,22 +562,56 @@ ybool_t _yvar_equal(const yvar_t * plhs, const yvar_t * prhs);
 yint8_t _yvar_compare(const yvar_t * plhs, const yvar_t * prhs);
 
 ysize_t _yvar_cstr_strlen(const yvar_t * yvar);
+ybool_t _yvar_str_unshare(yvar_t * yvar);
 
 ybool_t _yvar_triple_array_clone(yvar_t ** array, yvar_triple_array_t triple_array, ysize_t size, ysize_t dimension);
 ybool_t _yvar_triple_array_pin(yvar_t ** array, yvar_triple_array_t triple_array, ysize_t size, ysize_t dimension);
 ybool_t _yvar_array_get(const yvar_t * pyvar, size_t index, yvar_t * output);
 ysize_t _yvar_array_size(const yvar_t * pyvar);
+ysize_t _yvar_array_capacity(const yvar_t * array);
+ybool_t _yvar_array_reserve(yvar_t * array, ysize_t capacity);
+ybool_t _yvar_array_push_back(yvar_t * array, const yvar_t * value);
+ybool_t _yvar_array_shrink(yvar_t * array);
+ybool_t _yvar_array_sort(yvar_t * array);
+ybool_t _yvar_array_unique(yvar_t * array);
+ybool_t _yvar_array_intersect(const yvar_t * lhs, const yvar_t * rhs, yvar_t * output);
+ybool_t _yvar_array_union(const yvar_t * lhs, const yvar_t * rhs, yvar_t * output);
+ybool_t _yvar_array_pack(yvar_t ** packed, const yvar_t * array, yuint8_t item_type);
+ybool_t _yvar_array_unpack(yvar_t ** array, const yvar_t * packed);
+ybool_t _yvar_array_slice(const yvar_t * array, ysize_t begin, ysize_t end, ysize_t stride, yvar_t * view);
+ybool_t _yvar_array_chunk(const yvar_t * array, ysize_t chunk_size, ysize_t * offset, yvar_t * chunk);
+
+// array kernels. see yuki_var_kernel.c.
+const char * yvar_kernel_name();
+ybool_t _yvar_array_sum(const yvar_t * array, yvar_t * sum);
+ybool_t _yvar_array_minmax(const yvar_t * array, yvar_t * min, yvar_t * max);
+ysize_t _yvar_array_count_eq(const yvar_t * array, const yvar_t * value);
+ybool_t _yvar_array_filter_cmp(const yvar_t * array, yvar_cmp_t op, const yvar_t * value, yvar_t * output);
 
 ybool_t _yvar_list_push_back(yvar_t * yvar, yvar_t * node);
+ybool_t _yvar_list_pop_front(yvar_t * yvar, yvar_t * output);
+ybool_t _yvar_list_pop_back(yvar_t * yvar, yvar_t * output);
 
 ybool_t _yvar_map_get(const yvar_t * map, const yvar_t * key, yvar_t * value);
 ybool_t _yvar_map_clone(yvar_t ** map, yvar_map_kv_t raw_arr, ysize_t size);
 ybool_t _yvar_map_pin(yvar_t ** map, yvar_map_kv_t raw_arr, ysize_t size);
+ybool_t _yvar_map_sorted_clone(yvar_t ** map, yvar_map_kv_t raw_arr, ysize_t size);
+ybool_t _yvar_map_sorted_pin(yvar_t ** map, yvar_map_kv_t raw_arr, ysize_t size);
+ybool_t _yvar_map_range(const yvar_t * map, const yvar_t * lower, const yvar_t * upper, yvar_t * keys, yvar_t * values);
 
 ybool_t _yvar_assign(yvar_t * lhs, const yvar_t * rhs);
 ybool_t _yvar_clone(yvar_t ** new_var, const yvar_t * old_var);
+ybool_t _yvar_clone_sized(yvar_t ** new_var, const yvar_t * old_var);
 ybool_t _yvar_pin(yvar_t ** new_var, const yvar_t * old_var);
 ybool_t _yvar_unpin(yvar_t * yvar);
+ybool_t _yvar_freeze(yvar_t ** new_var, const yvar_t * old_var);
+ybool_t _yvar_thaw(yvar_t ** yvar);
+ybool_t _yvar_cow_assign(yvar_t ** lhs, const yvar_t * rhs);
+ybool_t _yvar_move(yvar_t ** dst, yvar_t ** src);
+ysize_t _yvar_encoded_size(const yvar_t * yvar);
+ybool_t _yvar_encode(const yvar_t * yvar, void * buf, ysize_t size);
+ybool_t _yvar_view(yvar_t ** view, const void * buf, ysize_t size);
+ybool_t _yvar_view_copy(yvar_t ** view, const void * buf, ysize_t size);
 ybool_t _yvar_memzero(yvar_t * new_var);
 
 #ifdef __cplusplus
@@ -0,0 +1,810 @@
+#include <string.h>
+
+#include "yuki.h"
+
+// simd kernels are built with target attribute and chosen at runtime.
+// define YVAR_KERNEL_DISABLE_SIMD to build scalar kernel only.
+#if (defined(__GNUC__) && defined(__x86_64__) && !defined(YVAR_KERNEL_DISABLE_SIMD))
+# define YVAR_KERNEL_X86_ENABLED
+# include <immintrin.h>
+#endif
+
+// items are widened to int64 block by block before running kernels.
+#define YVAR_KERNEL_BLOCK_SIZE 256
+
+// uint64 items are biased by 2^63 so that they keep their order as int64.
+#define YVAR_KERNEL_UINT64_BIAS ((yuint64_t)1 << 63)
+
+/**
+ * kernels over int64 items.
+ * minmax() merges items into *min and *max.
+ * cmp() counts items matching 'item op value'. if hits is not NULL, hits[i] is set to 1 for matched item or 0 if not.
+ */
+typedef struct _yvar_kernel_t {
+    const char * name;
+    yuint64_t (*sum)(const yint64_t * items, ysize_t size);
+    void (*minmax)(const yint64_t * items, ysize_t size, yint64_t * min, yint64_t * max);
+    ysize_t (*cmp)(const yint64_t * items, ysize_t size, yvar_cmp_t op, yint64_t value, yuint8_t * hits);
+} yvar_kernel_t;
+
+/**
+ * reader of items in a generic array or a packed array.
+ * all vars in a generic array must have the same int-like type.
+ */
+typedef struct _yvar_kernel_reader_t {
+    const yvar_t * array;
+    yuint8_t item_type;
+    ysize_t size;
+    ysize_t offset;
+    yint64_t block[YVAR_KERNEL_BLOCK_SIZE];
+} yvar_kernel_reader_t;
+
+static yuint64_t _yvar_kernel_scalar_sum(const yint64_t * items, ysize_t size)
+{
+    yuint64_t sum = 0;
+    ysize_t i;
+
+    for (i = 0; i < size; i++) {
+        sum += (yuint64_t)items[i];
+    }
+
+    return sum;
+}
+
+static void _yvar_kernel_scalar_minmax(const yint64_t * items, ysize_t size, yint64_t * min, yint64_t * max)
+{
+    yint64_t lower = *min;
+    yint64_t upper = *max;
+    ysize_t i;
+
+    for (i = 0; i < size; i++) {
+        lower = items[i] < lower? items[i]: lower;
+        upper = items[i] > upper? items[i]: upper;
+    }
+
+    *min = lower;
+    *max = upper;
+}
+
+#define _YVAR_KERNEL_SCALAR_CMP_LOOP(exp) do { \
+        for (i = 0; i < size; i++) { \
+            yuint8_t hit = (exp)? 1: 0; \
+            count += hit; \
+            if (hits) { \
+                hits[i] = hit; \
+            } \
+        } \
+    } while (0)
+
+static ysize_t _yvar_kernel_scalar_cmp(const yint64_t * items, ysize_t size, yvar_cmp_t op, yint64_t value, yuint8_t * hits)
+{
+    ysize_t count = 0;
+    ysize_t i;
+
+    switch (op) {
+        case YVAR_CMP_EQ:
+            _YVAR_KERNEL_SCALAR_CMP_LOOP(items[i] == value);
+            break;
+        case YVAR_CMP_NE:
+            _YVAR_KERNEL_SCALAR_CMP_LOOP(items[i] != value);
+            break;
+        case YVAR_CMP_LT:
+            _YVAR_KERNEL_SCALAR_CMP_LOOP(items[i] < value);
+            break;
+        case YVAR_CMP_LE:
+            _YVAR_KERNEL_SCALAR_CMP_LOOP(items[i] <= value);
+            break;
+        case YVAR_CMP_GT:
+            _YVAR_KERNEL_SCALAR_CMP_LOOP(items[i] > value);
+            break;
+        case YVAR_CMP_GE:
+            _YVAR_KERNEL_SCALAR_CMP_LOOP(items[i] >= value);
+            break;
+    }
+
+    return count;
+}
+
+static const yvar_kernel_t g_yvar_kernel_scalar = {
+    "scalar",
+    _yvar_kernel_scalar_sum,
+    _yvar_kernel_scalar_minmax,
+    _yvar_kernel_scalar_cmp,
+};
+
+#ifdef YVAR_KERNEL_X86_ENABLED
+/**
+ * simd compare is built from eq and gt only.
+ * lt is gt with swapped operands. ne, le and ge invert eq, gt and lt.
+ */
+typedef enum _yvar_kernel_simd_cmp_t {
+    YVAR_KERNEL_SIMD_CMP_EQ,
+    YVAR_KERNEL_SIMD_CMP_GT,
+    YVAR_KERNEL_SIMD_CMP_LT,
+} yvar_kernel_simd_cmp_t;
+
+static inline yvar_kernel_simd_cmp_t _yvar_kernel_simd_cmp(yvar_cmp_t op, ybool_t * invert)
+{
+    *invert = op == YVAR_CMP_NE || op == YVAR_CMP_LE || op == YVAR_CMP_GE;
+
+    switch (op) {
+        case YVAR_CMP_EQ:
+        case YVAR_CMP_NE:
+            return YVAR_KERNEL_SIMD_CMP_EQ;
+        case YVAR_CMP_GT:
+        case YVAR_CMP_LE:
+            return YVAR_KERNEL_SIMD_CMP_GT;
+        default:
+            return YVAR_KERNEL_SIMD_CMP_LT;
+    }
+}
+
+__attribute__((target("sse4.2")))
+static yuint64_t _yvar_kernel_sse4_sum(const yint64_t * items, ysize_t size)
+{
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+    ysize_t i = 0;
+
+    for (; i + 4 <= size; i += 4) {
+        acc0 = _mm_add_epi64(acc0, _mm_loadu_si128((const __m128i *)(items + i)));
+        acc1 = _mm_add_epi64(acc1, _mm_loadu_si128((const __m128i *)(items + i + 2)));
+    }
+
+    acc0 = _mm_add_epi64(acc0, acc1);
+    yuint64_t sum = (yuint64_t)_mm_cvtsi128_si64(acc0) + (yuint64_t)_mm_extract_epi64(acc0, 1);
+    return sum + _yvar_kernel_scalar_sum(items + i, size - i);
+}
+
+__attribute__((target("sse4.2")))
+static void _yvar_kernel_sse4_minmax(const yint64_t * items, ysize_t size, yint64_t * min, yint64_t * max)
+{
+    __m128i lower = _mm_set1_epi64x(*min);
+    __m128i upper = _mm_set1_epi64x(*max);
+    ysize_t i = 0;
+
+    for (; i + 2 <= size; i += 2) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(items + i));
+        lower = _mm_blendv_epi8(lower, v, _mm_cmpgt_epi64(lower, v));
+        upper = _mm_blendv_epi8(upper, v, _mm_cmpgt_epi64(v, upper));
+    }
+
+    yint64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, lower);
+    _yvar_kernel_scalar_minmax(lanes, 2, min, max);
+    _mm_storeu_si128((__m128i *)lanes, upper);
+    _yvar_kernel_scalar_minmax(lanes, 2, min, max);
+    _yvar_kernel_scalar_minmax(items + i, size - i, min, max);
+}
+
+__attribute__((target("sse4.2")))
+static ysize_t _yvar_kernel_sse4_cmp(const yint64_t * items, ysize_t size, yvar_cmp_t op, yint64_t value, yuint8_t * hits)
+{
+    ybool_t invert;
+    yvar_kernel_simd_cmp_t cmp = _yvar_kernel_simd_cmp(op, &invert);
+    __m128i x = _mm_set1_epi64x(value);
+    ysize_t count = 0;
+    ysize_t i = 0;
+
+    for (; i + 2 <= size; i += 2) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(items + i));
+        __m128i m = YVAR_KERNEL_SIMD_CMP_EQ == cmp? _mm_cmpeq_epi64(v, x):
+            YVAR_KERNEL_SIMD_CMP_GT == cmp? _mm_cmpgt_epi64(v, x): _mm_cmpgt_epi64(x, v);
+        int bits = _mm_movemask_pd(_mm_castsi128_pd(m)) ^ (invert? 0x3: 0);
+
+        count += __builtin_popcount(bits);
+
+        if (hits) {
+            hits[i] = bits & 1;
+            hits[i + 1] = (bits >> 1) & 1;
+        }
+    }
+
+    return count + _yvar_kernel_scalar_cmp(items + i, size - i, op, value, hits? hits + i: NULL);
+}
+
+static const yvar_kernel_t g_yvar_kernel_sse4 = {
+    "sse4",
+    _yvar_kernel_sse4_sum,
+    _yvar_kernel_sse4_minmax,
+    _yvar_kernel_sse4_cmp,
+};
+
+__attribute__((target("avx2")))
+static yuint64_t _yvar_kernel_avx2_sum(const yint64_t * items, ysize_t size)
+{
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    ysize_t i = 0;
+
+    for (; i + 8 <= size; i += 8) {
+        acc0 = _mm256_add_epi64(acc0, _mm256_loadu_si256((const __m256i *)(items + i)));
+        acc1 = _mm256_add_epi64(acc1, _mm256_loadu_si256((const __m256i *)(items + i + 4)));
+    }
+
+    acc0 = _mm256_add_epi64(acc0, acc1);
+    __m128i acc = _mm_add_epi64(_mm256_castsi256_si128(acc0), _mm256_extracti128_si256(acc0, 1));
+    yuint64_t sum = (yuint64_t)_mm_cvtsi128_si64(acc) + (yuint64_t)_mm_extract_epi64(acc, 1);
+    return sum + _yvar_kernel_scalar_sum(items + i, size - i);
+}
+
+__attribute__((target("avx2")))
+static void _yvar_kernel_avx2_minmax(const yint64_t * items, ysize_t size, yint64_t * min, yint64_t * max)
+{
+    __m256i lower = _mm256_set1_epi64x(*min);
+    __m256i upper = _mm256_set1_epi64x(*max);
+    ysize_t i = 0;
+
+    for (; i + 4 <= size; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(items + i));
+        lower = _mm256_blendv_epi8(lower, v, _mm256_cmpgt_epi64(lower, v));
+        upper = _mm256_blendv_epi8(upper, v, _mm256_cmpgt_epi64(v, upper));
+    }
+
+    yint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, lower);
+    _yvar_kernel_scalar_minmax(lanes, 4, min, max);
+    _mm256_storeu_si256((__m256i *)lanes, upper);
+    _yvar_kernel_scalar_minmax(lanes, 4, min, max);
+    _yvar_kernel_scalar_minmax(items + i, size - i, min, max);
+}
+
+__attribute__((target("avx2")))
+static ysize_t _yvar_kernel_avx2_cmp(const yint64_t * items, ysize_t size, yvar_cmp_t op, yint64_t value, yuint8_t * hits)
+{
+    ybool_t invert;
+    yvar_kernel_simd_cmp_t cmp = _yvar_kernel_simd_cmp(op, &invert);
+    __m256i x = _mm256_set1_epi64x(value);
+    ysize_t count = 0;
+    ysize_t i = 0;
+
+    for (; i + 4 <= size; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(items + i));
+        __m256i m = YVAR_KERNEL_SIMD_CMP_EQ == cmp? _mm256_cmpeq_epi64(v, x):
+            YVAR_KERNEL_SIMD_CMP_GT == cmp? _mm256_cmpgt_epi64(v, x): _mm256_cmpgt_epi64(x, v);
+        int bits = _mm256_movemask_pd(_mm256_castsi256_pd(m)) ^ (invert? 0xF: 0);
+
+        count += __builtin_popcount(bits);
+
+        if (hits) {
+            hits[i] = bits & 1;
+            hits[i + 1] = (bits >> 1) & 1;
+            hits[i + 2] = (bits >> 2) & 1;
+            hits[i + 3] = (bits >> 3) & 1;
+        }
+    }
+
+    return count + _yvar_kernel_scalar_cmp(items + i, size - i, op, value, hits? hits + i: NULL);
+}
+
+static const yvar_kernel_t g_yvar_kernel_avx2 = {
+    "avx2",
+    _yvar_kernel_avx2_sum,
+    _yvar_kernel_avx2_minmax,
+    _yvar_kernel_avx2_cmp,
+};
+#endif
+
+static const yvar_kernel_t * _yvar_kernel_select()
+{
+#ifdef YVAR_KERNEL_X86_ENABLED
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        return &g_yvar_kernel_avx2;
+    }
+
+    if (__builtin_cpu_supports("sse4.2")) {
+        return &g_yvar_kernel_sse4;
+    }
+#endif
+
+    return &g_yvar_kernel_scalar;
+}
+
+/**
+ * get best kernel of current cpu. it's chosen once.
+ * threads racing on first call choose the same kernel.
+ */
+static const yvar_kernel_t * _yvar_kernel()
+{
+    static const yvar_kernel_t * kernel = NULL;
+
+    if (!kernel) {
+        kernel = _yvar_kernel_select();
+    }
+
+    return kernel;
+}
+
+static ybool_t _yvar_kernel_reader_init(yvar_kernel_reader_t * reader, const yvar_t * array)
+{
+    reader->array = array;
+    reader->offset = 0;
+
+    if (yvar_is_packed_array(*array)) {
+        reader->item_type = array->data.ypacked_array_data.item_type;
+        reader->size = array->data.ypacked_array_data.size;
+        return ytrue;
+    }
+
+    if (!yvar_is_array(*array)) {
+        YUKI_LOG_DEBUG("var is not array or packed array");
+        return yfalse;
+    }
+
+    reader->size = array->data.yarray_data.size;
+    reader->item_type = reader->size? array->data.yarray_data.yvars[0].type: YVAR_TYPE_INT64;
+
+    if (reader->item_type < YVAR_TYPE_INT_MIN || reader->item_type > YVAR_TYPE_INT_MAX) {
+        YUKI_LOG_DEBUG("array is not an int array. [type: %d]", reader->item_type);
+        return yfalse;
+    }
+
+    return ytrue;
+}
+
+#define _YVAR_KERNEL_WIDEN_VARS(field) do { \
+        for (i = 0; i < count; i++) { \
+            if (yvars[i].type != reader->item_type) { \
+                YUKI_LOG_DEBUG("vars in array have different types. [index: %lu]", reader->offset + i); \
+                return yfalse; \
+            } \
+            block[i] = (yint64_t)yvars[i].data.field; \
+        } \
+    } while (0)
+#define _YVAR_KERNEL_WIDEN_ITEMS(t) do { \
+        for (i = 0; i < count; i++) { \
+            block[i] = (yint64_t)((const t *)reader->array->data.ypacked_array_data.items)[reader->offset + i]; \
+        } \
+    } while (0)
+
+/**
+ * read next block of items as int64. *count is 0 if all items are read.
+ * it fails if a var in generic array has a different type from the first one.
+ */
+static ybool_t _yvar_kernel_read(yvar_kernel_reader_t * reader, const yint64_t ** items, ysize_t * count_output)
+{
+    ysize_t count = reader->size - reader->offset;
+    yint64_t * block = reader->block;
+    ysize_t i;
+
+    if (count > YVAR_KERNEL_BLOCK_SIZE) {
+        count = YVAR_KERNEL_BLOCK_SIZE;
+    }
+
+    *items = block;
+    *count_output = count;
+
+    if (!count) {
+        return ytrue;
+    }
+
+    if (yvar_is_packed_array(*reader->array)) {
+        switch (reader->item_type) {
+            case YVAR_TYPE_BOOL:
+                _YVAR_KERNEL_WIDEN_ITEMS(ybool_t);
+                break;
+            case YVAR_TYPE_INT8:
+                _YVAR_KERNEL_WIDEN_ITEMS(yint8_t);
+                break;
+            case YVAR_TYPE_UINT8:
+                _YVAR_KERNEL_WIDEN_ITEMS(yuint8_t);
+                break;
+            case YVAR_TYPE_INT16:
+                _YVAR_KERNEL_WIDEN_ITEMS(yint16_t);
+                break;
+            case YVAR_TYPE_UINT16:
+                _YVAR_KERNEL_WIDEN_ITEMS(yuint16_t);
+                break;
+            case YVAR_TYPE_INT32:
+                _YVAR_KERNEL_WIDEN_ITEMS(yint32_t);
+                break;
+            case YVAR_TYPE_UINT32:
+                _YVAR_KERNEL_WIDEN_ITEMS(yuint32_t);
+                break;
+            case YVAR_TYPE_INT64:
+                // no need to copy
+                *items = (const yint64_t *)reader->array->data.ypacked_array_data.items + reader->offset;
+                break;
+            case YVAR_TYPE_UINT64:
+                _YVAR_KERNEL_WIDEN_ITEMS(yuint64_t);
+
+                for (i = 0; i < count; i++) {
+                    block[i] = (yint64_t)((yuint64_t)block[i] ^ YVAR_KERNEL_UINT64_BIAS);
+                }
+
+                break;
+            default:
+                YUKI_LOG_FATAL("impossible item type value %d", reader->item_type);
+                return yfalse;
+        }
+    } else {
+        const yvar_t * yvars = reader->array->data.yarray_data.yvars + reader->offset;
+
+        switch (reader->item_type) {
+            case YVAR_TYPE_BOOL:
+                _YVAR_KERNEL_WIDEN_VARS(ybool_data);
+                break;
+            case YVAR_TYPE_INT8:
+                _YVAR_KERNEL_WIDEN_VARS(yint8_data);
+                break;
+            case YVAR_TYPE_UINT8:
+                _YVAR_KERNEL_WIDEN_VARS(yuint8_data);
+                break;
+            case YVAR_TYPE_INT16:
+                _YVAR_KERNEL_WIDEN_VARS(yint16_data);
+                break;
+            case YVAR_TYPE_UINT16:
+                _YVAR_KERNEL_WIDEN_VARS(yuint16_data);
+                break;
+            case YVAR_TYPE_INT32:
+                _YVAR_KERNEL_WIDEN_VARS(yint32_data);
+                break;
+            case YVAR_TYPE_UINT32:
+                _YVAR_KERNEL_WIDEN_VARS(yuint32_data);
+                break;
+            case YVAR_TYPE_INT64:
+                _YVAR_KERNEL_WIDEN_VARS(yint64_data);
+                break;
+            case YVAR_TYPE_UINT64:
+                _YVAR_KERNEL_WIDEN_VARS(yuint64_data);
+
+                for (i = 0; i < count; i++) {
+                    block[i] = (yint64_t)((yuint64_t)block[i] ^ YVAR_KERNEL_UINT64_BIAS);
+                }
+
+                break;
+            default:
+                YUKI_LOG_FATAL("impossible item type value %d", reader->item_type);
+                return yfalse;
+        }
+    }
+
+    reader->offset += count;
+    return ytrue;
+}
+
+/**
+ * convert value to a key comparable with items read by reader.
+ * return -1 or 1 if value is less or greater than any item. otherwise, return 0.
+ */
+static yint8_t _yvar_kernel_key(yuint8_t item_type, const yvar_t * value, yint64_t * key)
+{
+    if (yvar_is_uint64(*value)) {
+        yuint64_t uint64_value = value->data.yuint64_data;
+
+        if (YVAR_TYPE_UINT64 == item_type) {
+            *key = (yint64_t)(uint64_value ^ YVAR_KERNEL_UINT64_BIAS);
+            return 0;
+        }
+
+        if (uint64_value > (yuint64_t)YUKI_MAX_INT64_VALUE) {
+            return 1;
+        }
+
+        *key = (yint64_t)uint64_value;
+        return 0;
+    }
+
+    yint64_t int64_value = yvar_to_int64(*value);
+
+    if (YVAR_TYPE_UINT64 == item_type) {
+        if (int64_value < 0) {
+            return -1;
+        }
+
+        *key = (yint64_t)((yuint64_t)int64_value ^ YVAR_KERNEL_UINT64_BIAS);
+        return 0;
+    }
+
+    *key = int64_value;
+    return 0;
+}
+
+/**
+ * box a key read by reader to a var of item type.
+ */
+static ybool_t _yvar_kernel_box(yuint8_t item_type, yint64_t key, yvar_t * output)
+{
+    yvar_t yvar = YVAR_EMPTY();
+
+    switch (item_type) {
+        case YVAR_TYPE_BOOL:
+            yvar_bool(yvar, (ybool_t)key);
+            break;
+        case YVAR_TYPE_INT8:
+            yvar_int8(yvar, (yint8_t)key);
+            break;
+        case YVAR_TYPE_UINT8:
+            yvar_uint8(yvar, (yuint8_t)key);
+            break;
+        case YVAR_TYPE_INT16:
+            yvar_int16(yvar, (yint16_t)key);
+            break;
+        case YVAR_TYPE_UINT16:
+            yvar_uint16(yvar, (yuint16_t)key);
+            break;
+        case YVAR_TYPE_INT32:
+            yvar_int32(yvar, (yint32_t)key);
+            break;
+        case YVAR_TYPE_UINT32:
+            yvar_uint32(yvar, (yuint32_t)key);
+            break;
+        case YVAR_TYPE_INT64:
+            yvar_int64(yvar, key);
+            break;
+        case YVAR_TYPE_UINT64:
+            yvar_uint64(yvar, (yuint64_t)key ^ YVAR_KERNEL_UINT64_BIAS);
+            break;
+        default:
+            YUKI_LOG_FATAL("impossible item type value %d", item_type);
+            return yfalse;
+    }
+
+    return yvar_assign(*output, yvar);
+}
+
+static inline ysize_t _yvar_kernel_item_size(yuint8_t item_type)
+{
+    switch (item_type) {
+        case YVAR_TYPE_INT16:
+        case YVAR_TYPE_UINT16:
+            return sizeof(yint16_t);
+        case YVAR_TYPE_INT32:
+        case YVAR_TYPE_UINT32:
+            return sizeof(yint32_t);
+        case YVAR_TYPE_INT64:
+        case YVAR_TYPE_UINT64:
+            return sizeof(yint64_t);
+        default:
+            return sizeof(yint8_t);
+    }
+}
+
+static inline ybool_t _yvar_kernel_is_unsigned(yuint8_t item_type)
+{
+    return YVAR_TYPE_UINT8 == item_type || YVAR_TYPE_UINT16 == item_type
+        || YVAR_TYPE_UINT32 == item_type || YVAR_TYPE_UINT64 == item_type;
+}
+
+/**
+ * name of kernel chosen for current cpu. it's "avx2", "sse4" or "scalar".
+ */
+const char * yvar_kernel_name()
+{
+    return _yvar_kernel()->name;
+}
+
+/**
+ * sum all items in an int array or a packed array.
+ * sum is a uint64 var for unsigned items and an int64 var for others. it wraps on overflow.
+ */
+ybool_t _yvar_array_sum(const yvar_t * array, yvar_t * sum)
+{
+    if (!array || !sum) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    yvar_kernel_reader_t reader;
+
+    if (!_yvar_kernel_reader_init(&reader, array)) {
+        return yfalse;
+    }
+
+    const yvar_kernel_t * kernel = _yvar_kernel();
+    const yint64_t * items;
+    ysize_t count;
+    yuint64_t result = 0;
+
+    while (_yvar_kernel_read(&reader, &items, &count) && count) {
+        result += kernel->sum(items, count);
+    }
+
+    if (reader.offset != reader.size) {
+        return yfalse;
+    }
+
+    // each biased item adds 2^63. 2^63 * size is 2^63 or 0 in uint64.
+    if (YVAR_TYPE_UINT64 == reader.item_type && (reader.size & 1)) {
+        result ^= YVAR_KERNEL_UINT64_BIAS;
+    }
+
+    yvar_t yvar = YVAR_EMPTY();
+
+    if (_yvar_kernel_is_unsigned(reader.item_type)) {
+        yvar_uint64(yvar, result);
+    } else {
+        yvar_int64(yvar, (yint64_t)result);
+    }
+
+    return yvar_assign(*sum, yvar);
+}
+
+/**
+ * find min and max items in an int array or a packed array.
+ * min and max have the same type as items. it fails on empty array.
+ */
+ybool_t _yvar_array_minmax(const yvar_t * array, yvar_t * min, yvar_t * max)
+{
+    if (!array || !min || !max) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    yvar_kernel_reader_t reader;
+
+    if (!_yvar_kernel_reader_init(&reader, array)) {
+        return yfalse;
+    }
+
+    if (!reader.size) {
+        YUKI_LOG_DEBUG("array is empty");
+        return yfalse;
+    }
+
+    const yvar_kernel_t * kernel = _yvar_kernel();
+    const yint64_t * items;
+    ysize_t count;
+    yint64_t lower = YUKI_MAX_INT64_VALUE;
+    yint64_t upper = YUKI_MIN_INT64_VALUE;
+
+    while (_yvar_kernel_read(&reader, &items, &count) && count) {
+        kernel->minmax(items, count, &lower, &upper);
+    }
+
+    if (reader.offset != reader.size) {
+        return yfalse;
+    }
+
+    return _yvar_kernel_box(reader.item_type, lower, min) && _yvar_kernel_box(reader.item_type, upper, max);
+}
+
+/**
+ * count items in an int array or a packed array which are equal to an int-like value.
+ */
+ysize_t _yvar_array_count_eq(const yvar_t * array, const yvar_t * value)
+{
+    if (!array || !value || !yvar_like_int(*value)) {
+        YUKI_LOG_FATAL("invalid param");
+        return 0;
+    }
+
+    yvar_kernel_reader_t reader;
+    yint64_t key;
+
+    if (!_yvar_kernel_reader_init(&reader, array)) {
+        return 0;
+    }
+
+    if (_yvar_kernel_key(reader.item_type, value, &key)) {
+        return 0;
+    }
+
+    const yvar_kernel_t * kernel = _yvar_kernel();
+    const yint64_t * items;
+    ysize_t count;
+    ysize_t result = 0;
+
+    while (_yvar_kernel_read(&reader, &items, &count) && count) {
+        result += kernel->cmp(items, count, YVAR_CMP_EQ, key, NULL);
+    }
+
+    return reader.offset == reader.size? result: 0;
+}
+
+// copy matched items without branch. slot after last matched item is always in bound.
+#define _YVAR_KERNEL_COMPACT(t) do { \
+        t * to = (t *)dest + result; \
+        const t * from = (const t *)src + offset; \
+        ysize_t i; \
+        for (i = 0; i < count; i++) { \
+            *to = from[i]; \
+            to += hits[i]; \
+        } \
+        result = to - (t *)dest; \
+    } while (0)
+
+/**
+ * select items matching 'item op value' in an int array or a packed array.
+ * output is allocated in thread arena and has the same kind as array.
+ * vars in output of generic array are shallow copies of vars in array.
+ */
+ybool_t _yvar_array_filter_cmp(const yvar_t * array, yvar_cmp_t op, const yvar_t * value, yvar_t * output)
+{
+    if (!array || !value || !output || !yvar_like_int(*value) || op < YVAR_CMP_EQ || op > YVAR_CMP_GE) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    yvar_kernel_reader_t reader;
+
+    if (!_yvar_kernel_reader_init(&reader, array)) {
+        return yfalse;
+    }
+
+    ybool_t packed = yvar_is_packed_array(*array);
+    ysize_t item_size = packed? _yvar_kernel_item_size(reader.item_type): sizeof(yvar_t);
+    const char * src = packed? (const char *)array->data.ypacked_array_data.items: (const char *)array->data.yarray_data.yvars;
+    const yvar_kernel_t * kernel = _yvar_kernel();
+    yuint8_t hits[YVAR_KERNEL_BLOCK_SIZE];
+    const yint64_t * items;
+    char * dest = NULL;
+    ysize_t count;
+    ysize_t matched;
+    ysize_t result = 0;
+    ysize_t offset = 0;
+    yint64_t key;
+    yint8_t outside = _yvar_kernel_key(reader.item_type, value, &key);
+
+    // value is out of range of items. all items or no item match.
+    ybool_t all = YVAR_CMP_NE == op
+        || (outside < 0 && (YVAR_CMP_GT == op || YVAR_CMP_GE == op))
+        || (outside > 0 && (YVAR_CMP_LT == op || YVAR_CMP_LE == op));
+
+    if (reader.size) {
+        dest = (char *)ybuffer_simple_alloc(reader.size * item_size);
+
+        if (!dest) {
+            YUKI_LOG_WARNING("out of memory");
+            return yfalse;
+        }
+    }
+
+    while (_yvar_kernel_read(&reader, &items, &count) && count) {
+        if (outside) {
+            matched = all? count: 0;
+        } else {
+            matched = kernel->cmp(items, count, op, key, hits);
+        }
+
+        if (matched == count) {
+            memcpy(dest + result * item_size, src + offset * item_size, count * item_size);
+            result += count;
+        } else if (matched) {
+            switch (item_size) {
+                case sizeof(yint8_t):
+                    _YVAR_KERNEL_COMPACT(yint8_t);
+                    break;
+                case sizeof(yint16_t):
+                    _YVAR_KERNEL_COMPACT(yint16_t);
+                    break;
+                case sizeof(yint32_t):
+                    _YVAR_KERNEL_COMPACT(yint32_t);
+                    break;
+                case sizeof(yint64_t):
+                    _YVAR_KERNEL_COMPACT(yint64_t);
+                    break;
+                default:
+                    _YVAR_KERNEL_COMPACT(yvar_t);
+                    break;
+            }
+        }
+
+        offset += count;
+    }
+
+    if (reader.offset != reader.size) {
+        return yfalse;
+    }
+
+    // give back unused memory if it's still the latest allocation
+    if (dest && result < reader.size) {
+        ybuffer_simple_resize(dest, reader.size * item_size, result * item_size);
+    }
+
+    yvar_t yvar = YVAR_EMPTY();
+
+    if (packed) {
+        yvar_packed_array_with_size(yvar, reader.item_type, result? dest: NULL, result);
+    } else {
+        yvar_array_with_size(yvar, result? (yvar_t *)dest: NULL, result);
+
+        if (yvar_has_option(*array, YVAR_OPTION_SORTED)) {
+            yvar_set_option(yvar, YVAR_OPTION_SORTED);
+        }
+    }
+
+    return yvar_assign(*output, yvar);
+}